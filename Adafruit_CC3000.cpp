@@ -34,8 +34,7 @@
 #include "utility/wlan.h"
 #include "utility/debug.h"
 #include "utility/sntp.h"
-
-uint8_t g_csPin, g_irqPin, g_vbatPin, g_IRQnum, g_SPIspeed;
+#include "utility/cc3000_dns.h"
 
 static const uint8_t dreqinttable[] = {
 #if defined(__AVR_ATmega168__) || defined(__AVR_ATmega328P__) || defined (__AVR_ATmega328__) || defined(__AVR_ATmega8__) 
@@ -95,6 +94,15 @@ static const uint8_t dreqinttable[] = {
 #endif
 };
 
+/* SPI clocks tried by SPI_CLOCK_AUTO, slowest first */
+static const uint8_t spiclocktable[] = {
+#if defined(__arm__) && defined(__SAM3X8E__) // Arduino Due, 84MHz / divider
+  42, 21, 14, 10, 8, 6
+#else
+  SPI_CLOCK_DIV8, SPI_CLOCK_DIV4, SPI_CLOCK_DIV2
+#endif
+};
+
 /***********************/
 
 uint8_t pingReportnum;
@@ -111,8 +119,7 @@ netapp_pingreport_args_t pingReport;
 #define MAXSSID					  (32)
 #define MAXLENGTHKEY 			(32)  /* Cleared for 32 bytes by TI engineering 29/08/13 */
 
-#define MAX_SOCKETS 32  // can change this
-boolean closed_sockets[MAX_SOCKETS] = {false, false, false, false};
+// closed_sockets (and MAX_SOCKETS) are part of the driver context, see utility/cc3000_context.h
 
 /* *********************************************************************** */
 /*                                                                         */
@@ -120,10 +127,6 @@ boolean closed_sockets[MAX_SOCKETS] = {false, false, false, false};
 /*                                                                         */
 /* *********************************************************************** */
 #ifndef CC3000_TINY_DRIVER
-volatile unsigned long ulSmartConfigFinished;
-volatile unsigned char ucStopSmartConfig;
-volatile long ulSocket;
-
 char _deviceName[] = "CC3000";
 char _cc3000_prefix[] = { 'T', 'T', 'T' };
 const unsigned char _smartConfigKey[] = { 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37,
@@ -131,10 +134,8 @@ const unsigned char _smartConfigKey[] = { 0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x
                                           // AES key for smart config = "0123456789012345"
 #endif
 
-volatile unsigned long ulCC3000Connected,
-                       ulCC3000DHCP,
-                       ulCC3000DHCP_configured,
-                       OkToDoShutDown;
+// The connection flags (ulCC3000Connected, ulCC3000DHCP, ...) are part of the
+// driver context, see utility/cc3000_context.h
 
 Print* CC3KPrinter; // user specified output stream for general messages and debug
 
@@ -144,6 +145,137 @@ Print* CC3KPrinter; // user specified output stream for general messages and deb
 /*                                                                         */
 /* *********************************************************************** */
 
+/**************************************************************************/
+/*!
+    @brief    Runs SPI_CLOCK_PROBE_ROUNDS HCI_CMND_READ_BUFFER_SIZE round
+              trips at the current SPI clock and checks that every reply
+              matches the buffer setup read by wlan_start()
+
+    @returns  False if a reply was missing or corrupted
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::probeSPIClock(void)
+{
+  unsigned short freeBuffers = tSLInformation.usNumberOfFreeBuffers;
+  unsigned short bufferLength = tSLInformation.usSlBufferLength;
+  bool ok = true;
+
+  for (uint8_t i = 0; ok && (i < SPI_CLOCK_PROBE_ROUNDS); i++)
+  {
+    WDT_RESET();
+    tSLInformation.usNumberOfFreeBuffers = 0;
+    tSLInformation.usSlBufferLength = 0;
+    tSLInformation.usRxEventOpcode = HCI_CMND_READ_BUFFER_SIZE;
+    hci_command_send(HCI_CMND_READ_BUFFER_SIZE, tSLInformation.pucTxCommandBuffer, 0);
+
+    // A garbled command never gets a reply, so don't wait for it forever
+    unsigned long start = millis();
+    while (!tSLInformation.usEventOrDataReceived)
+    {
+      cc3k_int_poll();
+      if (millis() - start > SPI_CLOCK_PROBE_TIMEOUT)
+      {
+        break;
+      }
+    }
+    if (!tSLInformation.usEventOrDataReceived)
+    {
+      tSLInformation.usRxEventOpcode = 0;
+      ok = false;
+      break;
+    }
+
+    // Only hand a well-formed reply to the event handler, anything else
+    // is dropped here and counts as a failed round trip
+    unsigned char *frame = tSLInformation.pucReceivedData;
+    unsigned short opcode = 0;
+    if (*frame == HCI_TYPE_EVNT)
+    {
+      STREAM_TO_UINT16((char *)frame, HCI_EVENT_OPCODE_OFFSET, opcode);
+    }
+    if (opcode != HCI_CMND_READ_BUFFER_SIZE)
+    {
+      tSLInformation.usRxEventOpcode = 0;
+      tSLInformation.usEventOrDataReceived = 0;
+      SpiResumeSpi();
+      ok = false;
+      break;
+    }
+    hci_event_handler(NULL, 0, 0);
+
+    ok = (tSLInformation.usNumberOfFreeBuffers == freeBuffers) &&
+         (tSLInformation.usSlBufferLength == bufferLength);
+  }
+
+  tSLInformation.usNumberOfFreeBuffers = freeBuffers;
+  tSLInformation.usSlBufferLength = bufferLength;
+
+  return ok;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Steps through spiclocktable (slowest first) and keeps the
+              fastest SPI clock that passes probeSPIClock(). Called from
+              begin() when SPI_CLOCK_AUTO was passed as the SPI speed, with
+              the bus still at the slowest clock.
+*/
+/**************************************************************************/
+void Adafruit_CC3000::tuneSPIClock(void)
+{
+  uint8_t good = spiclocktable[0];
+
+  for (uint8_t i = 1; i < sizeof(spiclocktable); i++)
+  {
+    SpiSetClockDivider(spiclocktable[i]);
+    if (!probeSPIClock())
+    {
+      break;
+    }
+    good = spiclocktable[i];
+  }
+
+  SpiSetClockDivider(good);
+}
+
+/**************************************************************************/
+/*!
+    @brief    Fills in the scan parameters of a preset, see setScanPreset()
+*/
+/**************************************************************************/
+static void scanPreset(cc3000_scan_config_t *config, uint8_t preset, uint16_t channelMask)
+{
+  uint8_t channels = 0;
+
+  if (preset == CC3000_SCAN_FAST)
+  {
+    config->minDwellTime  = 10;
+    config->maxDwellTime  = 30;
+    config->numProbes     = 2;
+    config->channelMask   = channelMask;
+    config->rssiThreshold = -90;
+    config->interval      = 2000;
+
+    // One pass over the channels plus time for the results to settle
+    for (; channelMask; channelMask &= channelMask - 1)
+    {
+      channels++;
+    }
+    config->scanTime = channels * config->maxDwellTime + 250;
+  }
+  else
+  {
+    // A survey looks everywhere, whatever channels are given
+    config->minDwellTime  = 20;
+    config->maxDwellTime  = 100;
+    config->numProbes     = 5;
+    config->channelMask   = CC3000_SCAN_ALL_CHANNELS;
+    config->rssiThreshold = -120;
+    config->interval      = 2000;
+    config->scanTime      = 4500;
+  }
+}
+
 /**************************************************************************/
 /*!
     @brief    Scans for SSID/APs in the CC3000's range
@@ -157,8 +289,14 @@ Print* CC3KPrinter; // user specified output stream for general messages and deb
 #if ! defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
 bool Adafruit_CC3000::scanSSIDs(uint32_t time)
 {
-  const unsigned long intervalTime[16] = { 2000, 2000, 2000, 2000,  2000,
-    2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000, 2000 };
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  unsigned long intervalTime[16];
+
+  for (uint8_t i = 0; i < 16; i++)
+  {
+    intervalTime[i] = _scanConfig.interval;
+  }
 
   if (!_initialised)
   {
@@ -176,12 +314,119 @@ bool Adafruit_CC3000::scanSSIDs(uint32_t time)
 #endif
 
   CHECK_SUCCESS(
-      wlan_ioctl_set_scan_params(time, 20, 100, 5, 0x7FF, -120, 0, 300,
+      wlan_ioctl_set_scan_params(time, _scanConfig.minDwellTime,
+          _scanConfig.maxDwellTime, _scanConfig.numProbes,
+          _scanConfig.channelMask, _scanConfig.rssiThreshold, 0, 300,
           (unsigned long * ) &intervalTime),
           CC3000_MSG_FAIL_SSID_PARAMS, false);
 
   return true;
 }
+
+/**************************************************************************/
+/*!
+    @brief    Sets the parameters every later scan runs with, including
+              the scans done by connectToAP() and startSSIDscan()
+
+    @note     The device saves everything but scanTime in its NVMEM, so
+              its own connection scans (e.g. the profile or fast connect
+              policies at the next boot) use them too. The whole config
+              also goes to the NVMEM user file CC3000_SCAN_CONFIG_FILEID,
+              which begin() reads back, so the scans of the library after
+              a reboot keep using it instead of the survey preset. Any
+              running scan is stopped. That file is reserved for the
+              library, see CC3000_SCAN_CONFIG_FILEID.
+
+    @returns  False if an error occured!
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::setScanConfig(const cc3000_scan_config_t *config)
+{
+  uint8_t stored[CC3000_SCAN_CONFIG_SIZE];
+  uint8_t *p = stored;
+
+  _scanConfig = *config;
+  if (!scanSSIDs(0))
+  {
+    return false;
+  }
+
+  // Field by field, so the file doesn't depend on the compiler's padding
+  UINT8_TO_STREAM(p, CC3000_SCAN_CONFIG_MAGIC);
+  p = UINT16_TO_STREAM(p, config->minDwellTime);
+  p = UINT16_TO_STREAM(p, config->maxDwellTime);
+  UINT8_TO_STREAM(p, config->numProbes);
+  p = UINT16_TO_STREAM(p, config->channelMask);
+  UINT8_TO_STREAM(p, (uint8_t)config->rssiThreshold);
+  p = UINT16_TO_STREAM(p, config->interval);
+  p = UINT16_TO_STREAM(p, config->scanTime);
+  // The file only has to be allocated the first time
+  if ((nvmem_write(CC3000_SCAN_CONFIG_FILEID, sizeof(stored), 0, stored) != 0) &&
+      ((nvmem_create_entry(CC3000_SCAN_CONFIG_FILEID, sizeof(stored)) != 0) ||
+       (nvmem_write(CC3000_SCAN_CONFIG_FILEID, sizeof(stored), 0, stored) != 0)))
+  {
+    return false;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Takes the scan parameters setScanConfig() saved in NVMEM, if
+              there are any, else the survey preset stays
+*/
+/**************************************************************************/
+void Adafruit_CC3000::loadScanConfig(void)
+{
+  uint8_t stored[CC3000_SCAN_CONFIG_SIZE];
+  char *p = (char *)stored;
+
+  if ((nvmem_read(CC3000_SCAN_CONFIG_FILEID, sizeof(stored), 0, stored) == 0) &&
+      (stored[0] == CC3000_SCAN_CONFIG_MAGIC))
+  {
+    STREAM_TO_UINT16(p, 1, _scanConfig.minDwellTime);
+    STREAM_TO_UINT16(p, 3, _scanConfig.maxDwellTime);
+    STREAM_TO_UINT8(p, 5, _scanConfig.numProbes);
+    STREAM_TO_UINT16(p, 6, _scanConfig.channelMask);
+    _scanConfig.rssiThreshold = (int8_t)stored[8];
+    STREAM_TO_UINT16(p, 9, _scanConfig.interval);
+    STREAM_TO_UINT16(p, 11, _scanConfig.scanTime);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief    Sets the scan parameters to a preset, see setScanConfig()
+
+    @args[in] preset
+              CC3000_SCAN_SURVEY to look for every AP in range (the
+              default), CC3000_SCAN_FAST to look only on the channels in
+              channelMask, when you know where your APs are
+    @args[in] channelMask
+              The channels CC3000_SCAN_FAST scans, e.g.
+              CC3000_SCAN_CHANNEL(1) | CC3000_SCAN_CHANNEL(6). A survey
+              always scans all of them.
+
+    @returns  False if an error occured!
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::setScanPreset(uint8_t preset, uint16_t channelMask)
+{
+  cc3000_scan_config_t config;
+
+  scanPreset(&config, preset, channelMask);
+  return setScanConfig(&config);
+}
+
+/**************************************************************************/
+/*!
+    @brief    Gets the current scan parameters, e.g. to adjust a preset
+*/
+/**************************************************************************/
+void Adafruit_CC3000::getScanConfig(cc3000_scan_config_t *config)
+{
+  *config = _scanConfig;
+}
 #endif
 
 /* *********************************************************************** */
@@ -198,20 +443,47 @@ bool Adafruit_CC3000::scanSSIDs(uint32_t time)
 Adafruit_CC3000::Adafruit_CC3000(uint8_t csPin, uint8_t irqPin, uint8_t vbatPin, uint8_t SPIspeed)
 {
   _initialised = false;
-  g_csPin = csPin;
-  g_irqPin = irqPin;
-  g_vbatPin = vbatPin;
-  g_IRQnum = 0xFF;
-  g_SPIspeed = SPIspeed;
-
-  ulCC3000DHCP          = 0;
-  ulCC3000Connected     = 0;
+  _ctx = cc3000_ctx_alloc();
+  // Without a context of its own (more modules than CC3000_MAX_INSTANCES)
+  // begin() and every other call fail
+  if (_ctx != NULL)
+  {
+    CC3000_SELECT(_ctx);
+    g_csPin = csPin;
+    g_irqPin = irqPin;
+    g_vbatPin = vbatPin;
+    g_IRQnum = 0xFF;
+    g_SPIspeed = SPIspeed;
+
+    ulCC3000DHCP          = 0;
+    ulCC3000Connected     = 0;
+    _ctx->ipConfigState   = CC3000_IPCONFIG_NONE;
 #ifndef CC3000_TINY_DRIVER
-  ulSocket              = 0;
-  ulSmartConfigFinished = 0;
+    ulSocket              = 0;
+    ulSmartConfigFinished = 0;
 #endif
+  }
+
+  _apSSID           = 0;
+  _apKey            = 0;
+  _apSecmode        = 0;
+  _replayPolicy     = CC3000_REPLAY_ALL;
+  memset(_replay, 0, sizeof(_replay));
+  _lastHealthCheck  = 0;
+  _recoveries       = 0;
+  _lastRecoveryTime = 0;
+  _bootStart = 0;
+  // Until begin() finds the one setScanConfig() saved
+  scanPreset(&_scanConfig, CC3000_SCAN_SURVEY, CC3000_SCAN_ALL_CHANNELS);
 
 #ifndef CC3000_TINY_DRIVER
+  _scState    = CC3000_SMARTCONFIG_IDLE;
+  _scAES      = false;
+  _scTimeout  = 0;
+  _scSince    = 0;
+  _scWait     = 0;
+  _scProgress = 0;
+
   #if defined(UDR0) || defined(UDR1) || defined(CORE_TEENSY) || ( defined (__arm__) && defined (__SAM3X8E__) )
   CC3KPrinter = &Serial;
   #else
@@ -239,12 +511,27 @@ Adafruit_CC3000::Adafruit_CC3000(uint8_t csPin, uint8_t irqPin, uint8_t vbatPin,
               that were stored on the device from the SmartConfig process,
               otherwise false to erase existing profiles and start a
               clean connection
+    @args[in] fastBoot
+              Set this to true to let the device rejoin the AP it was last
+              connected to while starting up, then call connectFast()
+              instead of connectToAP()
 */
 /**************************************************************************/
-bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData)
+bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData, bool fastBoot)
 {
+  if (_ctx == NULL)
+  {
+    if (CC3KPrinter != 0) {
+      CC3KPrinter->println(F(CC3000_MSG_NO_CONTEXT_LEFT));
+    }
+    return false;
+  }
+  CC3000_SELECT(_ctx);
   if (_initialised) return true;
 
+  _bootStart = millis();
+  _ctx->dhcpTime = 0;
+
   #ifndef CORE_ADAX
   // determine irq #
   for (uint8_t i=0; i<sizeof(dreqinttable); i+=2) {
@@ -252,7 +539,8 @@ bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData)
       g_IRQnum = dreqinttable[i+1];
     }
   }
-#ifndef CC3000_TINY_DRIVER
+#if !defined(CC3000_TINY_DRIVER) && !defined(CC3000_POLLED)
+  // A polled transport never attaches an interrupt, so any pin will do
   if (g_IRQnum == 0xFF) {
     if (CC3KPrinter != 0) {
       CC3KPrinter->println(F(CC3000_MSG_IRQ_NOT_INT_PIN));
@@ -265,6 +553,13 @@ bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData)
   // (almost) every single pin on Xmega supports interrupt
   #endif
 
+  // Auto-tuning starts at the slowest clock and speeds up after wlan_start()
+  bool autoClock = (g_SPIspeed == SPI_CLOCK_AUTO);
+  if (autoClock)
+  {
+    g_SPIspeed = spiclocktable[0];
+  }
+
   init_spi();
   
   DEBUGPRINT_F("init\n\r");
@@ -280,34 +575,40 @@ bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData)
   DEBUGPRINT_F("start\n\r");
 
   WDT_RESET();
-  wlan_start(patchReq);
+  clearEvents(0xFF);
+  CHECK_SUCCESS(wlan_start(patchReq), CC3000_MSG_TIMEOUT_START, false);
+
+  if (autoClock)
+  {
+    tuneSPIClock();
+  }
   
   DEBUGPRINT_F("ioctl\n\r");
+  // With fastBoot the policy and profiles from the last run stay: with the
+  // Fast Connect policy left by connectFast() the device is already
+  // rejoining its last AP
+  bool keepProfiles = fastBoot;
 #ifndef CC3000_TINY_DRIVER
   // Check if we should erase previous stored connection details
   // (most likely written with data from the SmartConfig app)
-  if (!useSmartConfigData)
-  {
-#endif
-    // Manual connection only (no auto, profiles, etc.)
-    wlan_ioctl_set_connection_policy(0, 0, 0);
-    // Delete previous profiles from memory
-    wlan_ioctl_del_profile(255);
-#ifndef CC3000_TINY_DRIVER
-  }
-  else
+  if (useSmartConfigData && !fastBoot)
   {
     // Auto Connect - the C3000 device tries to connect to any AP it detects during scanning:
     // wlan_ioctl_set_connection_policy(1, 0, 0)
-    
-    // Fast Connect - the CC3000 device tries to reconnect to the last AP connected to:
-    // wlan_ioctl_set_connection_policy(0, 1, 0)
 
     // Use Profiles - the CC3000 device tries to connect to an AP from profiles:
     wlan_ioctl_set_connection_policy(0, 0, 1);
+    keepProfiles = true;
   }
-
 #endif
+  if (!keepProfiles)
+  {
+    // Manual connection only (no auto, profiles, etc.)
+    wlan_ioctl_set_connection_policy(0, 0, 0);
+    // Delete previous profiles from memory
+    wlan_ioctl_del_profile(255);
+  }
+
   WDT_RESET();
   CHECK_SUCCESS(
     wlan_set_event_mask(HCI_EVNT_WLAN_UNSOL_INIT        |
@@ -317,6 +618,12 @@ bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData)
                         HCI_EVNT_WLAN_KEEPALIVE),
                         CC3000_MSG_FAIL_SET_EVNT_MASK_2, false);
 
+#if ! defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
+  // The scans below and in connectToAP() write their parameters to the
+  // device, they must be the saved ones
+  loadScanConfig();
+#endif
+
   _initialised = true;
 
 #ifndef CC3000_TINY_DRIVER
@@ -324,25 +631,16 @@ bool Adafruit_CC3000::begin(uint8_t patchReq, bool useSmartConfigData)
   if (useSmartConfigData)
   {
     // Wait for a connection
-    uint32_t timeout = 0;
-    while(!ulCC3000Connected)
+    if (!ulCC3000Connected && !waitFor(CC3000_EVENT_CONNECTED, WLAN_CONNECT_TIMEOUT))
     {
-      WDT_RESET();
-      cc3k_int_poll();
-      if(timeout > WLAN_CONNECT_TIMEOUT)
-      {
-        if (CC3KPrinter != 0) {
-          CC3KPrinter->println(F(CC3000_MSG_TIMEOUT_SMART_CFG));
-        }
-        return false;
+      if (CC3KPrinter != 0) {
+        CC3KPrinter->println(F(CC3000_MSG_TIMEOUT_SMART_CFG));
       }
-      timeout += 10;
-      delay(10);
+      return false;
     }
 
-    WDT_RESET();
-    delay(1000);
-    if (ulCC3000DHCP)
+    // Give DHCP a moment, the device name is only advertised with an address
+    if (ulCC3000DHCP || waitFor(CC3000_EVENT_DHCP, 1000))
     {
       mdnsAdvertiser(1, (char *) _deviceName, strlen(_deviceName));
     }
@@ -485,6 +783,8 @@ uint32_t Adafruit_CC3000::IP2U32(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
 #ifndef CC3000_TINY_DRIVER
 void Adafruit_CC3000::reboot(uint8_t patch)
 {
+  if (_ctx == NULL) return;
+  CC3000_SELECT(_ctx);
   if (!_initialised)
   {
     return;
@@ -493,7 +793,7 @@ void Adafruit_CC3000::reboot(uint8_t patch)
   WDT_RESET();
   wlan_stop();
   WDT_RESET();
-  delay(5000);
+  cc3k_delay(5000);
   WDT_RESET();
   wlan_start(patch);
   WDT_RESET();
@@ -507,6 +807,8 @@ void Adafruit_CC3000::reboot(uint8_t patch)
 /**************************************************************************/
 void Adafruit_CC3000::stop(void)
 {
+  if (_ctx == NULL) return;
+  CC3000_SELECT(_ctx);
   if (!_initialised)
   {
     return;
@@ -514,7 +816,112 @@ void Adafruit_CC3000::stop(void)
 
   WDT_RESET();
   wlan_stop();
+  resetState();
+  WDT_RESET();
+}
+
+/**************************************************************************/
+/*!
+    @brief   Powers the CC3000 up again after stop(), without the pin and
+             SPI setup of begin(). With the Fast Connect policy (see
+             connectFast()) it rejoins its last AP by itself.
+
+    @returns  False if the module didn't come up
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::start(void)
+{
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised)
+  {
+    return false;
+  }
+
+  _bootStart = millis();
+  _ctx->dhcpTime = 0;
+  clearEvents(0xFF);
+
   WDT_RESET();
+  CHECK_SUCCESS(wlan_start(0), CC3000_MSG_TIMEOUT_START, false);
+  CHECK_SUCCESS(wlan_set_event_mask(HCI_EVNT_WLAN_UNSOL_INIT | HCI_EVNT_WLAN_KEEPALIVE),
+                CC3000_MSG_FAIL_SET_EVNT_MASK_2, false);
+
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief   Fills ipConfig from the cache, asking the module only when
+             the cache doesn't have it. Without full only the addresses
+             are filled in.
+*/
+/**************************************************************************/
+void Adafruit_CC3000::readIPConfig(tNetappIpconfigRetArgs *ipConfig, bool full)
+{
+  uint8_t state = cc3000_ctx->ipConfigState;
+
+#ifndef CC3000_TINY_DRIVER
+  if (full && (state == CC3000_IPCONFIG_FULL))
+  {
+    memcpy(ipConfig, &_ipConfig, sizeof(_ipConfig));
+    return;
+  }
+#endif
+
+  // The event handler may refresh the cache under us
+  noInterrupts();
+  state = cc3000_ctx->ipConfigState;
+  if (!full && (state != CC3000_IPCONFIG_NONE))
+  {
+    memcpy(ipConfig, cc3000_ctx->ipConfig, sizeof(cc3000_ctx->ipConfig));
+    interrupts();
+    return;
+  }
+  interrupts();
+
+  netapp_ipconfig(ipConfig);
+  if (ipConfig->aucIP[3] == 0)
+  {
+    return;
+  }
+
+  // Unless the link dropped while we were asking
+  noInterrupts();
+  if (ulCC3000DHCP && (cc3000_ctx->ipConfigState == state))
+  {
+    memcpy(cc3000_ctx->ipConfig, ipConfig, sizeof(cc3000_ctx->ipConfig));
+#ifndef CC3000_TINY_DRIVER
+    memcpy(&_ipConfig, ipConfig, sizeof(_ipConfig));
+    cc3000_ctx->ipConfigState = CC3000_IPCONFIG_FULL;
+#else
+    cc3000_ctx->ipConfigState = CC3000_IPCONFIG_ADDRESSES;
+#endif
+  }
+  interrupts();
+}
+
+/**************************************************************************/
+/*!
+    @brief   Forgets what the driver knew about the module after it was
+             powered down: its sockets (clients created before report
+             connected() == false), the link state and any fault
+*/
+/**************************************************************************/
+void Adafruit_CC3000::resetState(void)
+{
+  cc3000_ctx->fault = CC3000_FAULT_NONE;
+  cc3000_ctx->txTimedOut = 0;
+  cc3000_ctx->staleOpcode = 0;
+  cc3000_ctx->timeouts = 0;
+  cc3000_ctx->generation++;
+  socket_active_status = SOCKET_STATUS_INIT_VAL;
+  cc3000_ctx->listenSockets = 0;
+  memset(closed_sockets, 0, sizeof(closed_sockets));
+  ulCC3000Connected = 0;
+  ulCC3000DHCP = 0;
+  ulCC3000DHCP_configured = 0;
+  cc3000_ctx->ipConfigState = CC3000_IPCONFIG_NONE;
 }
 
 /**************************************************************************/
@@ -526,6 +933,8 @@ void Adafruit_CC3000::stop(void)
 /**************************************************************************/
 bool Adafruit_CC3000::disconnect(void)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised)
   {
     return false;
@@ -546,6 +955,8 @@ bool Adafruit_CC3000::disconnect(void)
 #ifndef CC3000_TINY_DRIVER
 bool Adafruit_CC3000::deleteProfiles(void)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised)
   {
     return false;
@@ -572,6 +983,8 @@ bool Adafruit_CC3000::deleteProfiles(void)
 #ifndef CC3000_TINY_DRIVER
 bool Adafruit_CC3000::getMacAddress(uint8_t address[6])
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised)
   {
     return false;
@@ -596,6 +1009,8 @@ bool Adafruit_CC3000::getMacAddress(uint8_t address[6])
 #ifndef CC3000_TINY_DRIVER
 bool Adafruit_CC3000::setMacAddress(uint8_t address[6])
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised)
   {
     return false;
@@ -610,8 +1025,8 @@ bool Adafruit_CC3000::setMacAddress(uint8_t address[6])
                 CC3000_MSG_FAIL_SET_MAC_ADDR, false);
 
   wlan_stop();
-  delay(200);
-  wlan_start(0);
+  cc3k_delay(200);
+  CHECK_SUCCESS(wlan_start(0), CC3000_MSG_TIMEOUT_START, false);
 
   return true;
 }
@@ -619,19 +1034,23 @@ bool Adafruit_CC3000::setMacAddress(uint8_t address[6])
 
 /**************************************************************************/
 /*!
-    @brief   Reads the current IP address
+    @brief   Reads the current IP address. The addresses are taken from
+             the DHCP event and kept until the link drops, so only the
+             first call after a static setup asks the module.
 
     @returns  False if an error occured!
 */
 /**************************************************************************/
 bool Adafruit_CC3000::getIPAddress(uint32_t *retip, uint32_t *netmask, uint32_t *gateway, uint32_t *dhcpserv, uint32_t *dnsserv)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised) return false;
   if (!ulCC3000Connected) return false;
   if (!ulCC3000DHCP) return false;
 
   tNetappIpconfigRetArgs ipconfig;
-  netapp_ipconfig(&ipconfig);
+  readIPConfig(&ipconfig, false);
 
   /* If byte 1 is 0 we don't have a valid address */
   if (ipconfig.aucIP[3] == 0) return false;
@@ -660,6 +1079,8 @@ bool Adafruit_CC3000::getIPAddress(uint32_t *retip, uint32_t *netmask, uint32_t
 #ifndef CC3000_TINY_DRIVER
 bool Adafruit_CC3000::getFirmwareVersion(uint8_t *major, uint8_t *minor)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   uint8_t fwpReturn[2];
 
   if (!_initialised)
@@ -679,59 +1100,525 @@ bool Adafruit_CC3000::getFirmwareVersion(uint8_t *major, uint8_t *minor)
 
 /**************************************************************************/
 /*!
-    @Brief   Prints out the current status flag of the CC3000
-
-    @note     This command isn't available when the CC3000 is configured
-              in 'CC3000_TINY_DRIVER' mode
+    @brief    Returns the SPI clock divider in use, e.g. the one picked by
+              begin() when SPI_CLOCK_AUTO was passed to the constructor.
+              Pass the value to the constructor to skip the probing on the
+              next boot.
 */
 /**************************************************************************/
-status_t Adafruit_CC3000::getStatus()
+uint8_t Adafruit_CC3000::getSPIClockDivider(void)
 {
-  if (!_initialised)
-  {
-    return STATUS_DISCONNECTED;
-  }
-
-  long results = wlan_ioctl_statusget();
-
-  switch(results)
-  {
-    case 1:
-      return STATUS_SCANNING;
-      break;
-    case 2:
-      return STATUS_CONNECTING;
-      break;
-    case 3:
-      return STATUS_CONNECTED;
-      break;
-    case 0:
-    default:
-      return STATUS_DISCONNECTED;
-      break;
-  }
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  return g_SPIspeed;
 }
 
 /**************************************************************************/
 /*!
-    @brief    Calls listSSIDs and then displays the results of the SSID scan
-
-              For the moment we only list these via CC3KPrinter->print since
-              this can consume a lot of memory passing all the data
-              back with a buffer
+    @brief    Sets the deadline for every blocking wait on the CC3000 (a
+              command reply, an SPI transfer, a free TX buffer). Calls
+              that run out of time fail with ERROR_WAIT_TIMEOUT instead
+              of hanging if an interrupt is missed.
 
-    @note     This command isn't available when the CC3000 is configured
-              in 'CC3000_TINY_DRIVER' mode
+    @param    ms  Deadline in milliseconds, 0 to wait forever
 
-    @returns  False if an error occured!
+    @returns  The previous deadline
 */
 /**************************************************************************/
-#ifndef CC3000_TINY_DRIVER
-
-ResultStruct_t SSIDScanResultBuff;
+uint32_t Adafruit_CC3000::setTimeout(uint32_t ms)
+{
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  return cc3000_set_wait_timeout(ms);
+}
+
+/**************************************************************************/
+/*!
+    @brief    Sets a function that runs whenever the driver waits on the
+              CC3000, e.g. cc3000_idle_sleep to sleep until the next
+              interrupt, or a cooperative task. The hook must not call
+              into the driver. Pass 0 to busy-wait again.
+
+    @note     The hook is shared by all modules
+*/
+/**************************************************************************/
+void Adafruit_CC3000::setIdleHook(cc3000_idle_hook_t hook)
+{
+  cc3000_set_idle_hook(hook);
+}
+
+/**************************************************************************/
+/*!
+    @brief    Waits until one of the unsolicited events in eventMask
+              (CC3000_EVENT_*) has arrived, or timeout milliseconds have
+              passed. Returns as soon as the event is in instead of at the
+              next multiple of a fixed delay.
+
+    @note     Events are latched from the moment they arrive, so clear the
+              ones you are going to wait for with clearEvents() before
+              issuing the command that causes them
+
+    @returns  The events from eventMask that fired (they are cleared), or
+              0 on a timeout
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000::waitFor(uint8_t eventMask, uint32_t timeout)
+{
+  if (_ctx == NULL) return 0;
+  uint32_t start = millis();
+  uint8_t fired;
+
+  CC3000_SELECT(_ctx);
+
+  for (;;)
+  {
+    noInterrupts();
+    fired = _ctx->events & eventMask;
+    _ctx->events &= ~fired;
+    interrupts();
+
+    if (fired || (millis() - start >= timeout))
+    {
+      return fired;
+    }
+
+    WDT_RESET();
+    cc3k_int_poll();
+    cc3000_idle();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief    Forgets the latched events in eventMask, see waitFor()
+*/
+/**************************************************************************/
+void Adafruit_CC3000::clearEvents(uint8_t eventMask)
+{
+  if (_ctx == NULL) return;
+  noInterrupts();
+  _ctx->events &= ~eventMask;
+  interrupts();
+}
+
+/**************************************************************************/
+/*!
+    @brief    Waits until the module has released the buffer of every
+              packet sent to it, i.e. the data went out on the air and
+              the module can be closed or powered down without losing it
+
+    @returns  False if packets were still held after timeout milliseconds
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::waitSent(uint32_t timeout)
+{
+  if (_ctx == NULL) return false;
+  uint32_t start = millis();
+  bool done;
+
+  CC3000_SELECT(_ctx);
+
+  for (;;)
+  {
+    noInterrupts();
+    done = (tSLInformation.NumberOfReleasedPackets == tSLInformation.NumberOfSentPackets);
+    interrupts();
+
+    if (done || (millis() - start >= timeout))
+    {
+      return done;
+    }
+
+    WDT_RESET();
+    cc3k_int_poll();
+    cc3000_idle();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief    Call regularly from loop(). Every CC3000_HEALTH_INTERVAL it
+              checks that the module still answers, and when the driver
+              has flagged a fault (the module stopped answering, a buffer
+              overrun, or a recovery that didn't get back on the AP) it
+              runs recover(). A single command that timed out only fails
+              that call. It also looks up host
+              names in regular use again before their cached answer
+              runs out, see getHostByName().
+
+    @note     A hung module is only noticed if the waits have a deadline,
+              see setTimeout()
+
+    @returns  False if the module is faulty and couldn't be recovered
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::supervise(void)
+{
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised)
+  {
+    return false;
+  }
+
+  if ((cc3000_ctx->fault == CC3000_FAULT_NONE) &&
+      (millis() - _lastHealthCheck >= CC3000_HEALTH_INTERVAL))
+  {
+    _lastHealthCheck = millis();
+    // A wedged module times out here; CC3000_FAULT_TIMEOUTS checks in a
+    // row without an answer raise the fault
+    wlan_ioctl_statusget();
+  }
+
+#ifndef CC3000_TINY_DRIVER
+  // Names in regular use are looked up again before they run out
+  if ((cc3000_ctx->fault == CC3000_FAULT_NONE) && ulCC3000DHCP)
+  {
+    dns_cache_refresh();
+  }
+#endif
+
+  if (cc3000_ctx->fault != CC3000_FAULT_NONE)
+  {
+    return recover();
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Restarts a wedged module: powers it down through the enable
+              pin, runs wlan_start again, reconnects to the AP last given
+              to connectToAP() (or waits for the stored profile) and
+              re-opens the registered sockets as set by setReplayPolicy().
+
+              Sockets that weren't registered are dead afterwards, their
+              clients report connected() == false.
+
+    @returns  False if the module didn't come back, or didn't get back on
+              the network (CC3000_FAULT_RECOVERY); the fault stays set so
+              that supervise() tries again
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::recover(void)
+{
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised)
+  {
+    return false;
+  }
+
+  unsigned long start = millis();
+
+  // Power cycle; wlan_stop also releases a transfer that was cut short
+  WDT_RESET();
+  wlan_stop();
+  resetState();
+
+  cc3k_delay(CC3000_RECOVERY_OFF_TIME);
+  WDT_RESET();
+  // Still faulty if the module doesn't come back, so supervise() retries
+  if ((wlan_start(0) != CC3000_SUCCESS) ||
+      (wlan_set_event_mask(HCI_EVNT_WLAN_UNSOL_INIT | HCI_EVNT_WLAN_KEEPALIVE) != CC3000_SUCCESS))
+  {
+    if (CC3KPrinter != 0) CC3KPrinter->println(F(CC3000_MSG_TIMEOUT_START));
+    cc3000_ctx->fault = CC3000_FAULT_TIMEOUT;
+    return false;
+  }
+
+  // Back on the AP, or on the stored profile if connectToAP() wasn't used.
+  // Until then the module runs but isn't recovered, supervise() tries again.
+  if (_apSSID != 0)
+  {
+    if (!connectToAP(_apSSID, _apKey, _apSecmode, CC3000_CONNECT_ATTEMPTS))
+    {
+      cc3000_ctx->fault = CC3000_FAULT_RECOVERY;
+      return false;
+    }
+  }
+
+  if (!ulCC3000DHCP)
+  {
+    uint32_t elapsed = millis() - start;
+
+    if ((elapsed >= CC3000_RECOVERY_DHCP_TIMEOUT) ||
+        !waitFor(CC3000_EVENT_DHCP, CC3000_RECOVERY_DHCP_TIMEOUT - elapsed))
+    {
+      cc3000_ctx->fault = CC3000_FAULT_RECOVERY;
+      return false;
+    }
+  }
+
+  replaySockets();
+
+  _recoveries++;
+  _lastRecoveryTime = millis() - start;
+  _lastHealthCheck = millis();
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Returns the fault the driver has flagged (CC3000_FAULT_...),
+              CC3000_FAULT_NONE while the module is healthy
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000::getFault(void)
+{
+  if (_ctx == NULL) return CC3000_FAULT_NO_CONTEXT;
+  CC3000_SELECT(_ctx);
+  return cc3000_ctx->fault;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Chooses which registered sockets recover() re-opens
+
+    @param    policy  CC3000_REPLAY_NONE, CC3000_REPLAY_LISTEN,
+                      CC3000_REPLAY_CLIENTS or CC3000_REPLAY_ALL (default)
+*/
+/**************************************************************************/
+void Adafruit_CC3000::setReplayPolicy(uint8_t policy)
+{
+  _replayPolicy = policy;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Has recover() reconnect a client to the same destination,
+              assigning the new connection to *client
+
+    @returns  False if all CC3000_REPLAY_SLOTS are in use (or for UDP
+              with the tiny driver, which has no connectUDP)
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::registerClient(Adafruit_CC3000_Client *client, uint32_t destIP, uint16_t destPort, bool udp)
+{
+#ifdef CC3000_TINY_DRIVER
+  if (udp)
+  {
+    return false;
+  }
+#endif
+  for (uint8_t i = 0; i < CC3000_REPLAY_SLOTS; i++)
+  {
+    if ((_replay[i].sock == 0) || (_replay[i].sock == client))
+    {
+      _replay[i].sock = client;
+      _replay[i].ip = destIP;
+      _replay[i].port = destPort;
+      _replay[i].type = CC3000_REPLAY_CLIENTS;
+      _replay[i].udp = udp;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Has recover() drop the server's clients and listen again
+
+    @returns  False if all CC3000_REPLAY_SLOTS are in use
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::registerServer(Adafruit_CC3000_Server *server)
+{
+  for (uint8_t i = 0; i < CC3000_REPLAY_SLOTS; i++)
+  {
+    if ((_replay[i].sock == 0) || (_replay[i].sock == server))
+    {
+      _replay[i].sock = server;
+      _replay[i].type = CC3000_REPLAY_LISTEN;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Forgets a client or server given to registerClient() or
+              registerServer()
+*/
+/**************************************************************************/
+void Adafruit_CC3000::unregisterSocket(void *sock)
+{
+  for (uint8_t i = 0; i < CC3000_REPLAY_SLOTS; i++)
+  {
+    if (_replay[i].sock == sock)
+    {
+      _replay[i].sock = 0;
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief    Number of successful recoveries since power-up
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000::getRecoveryCount(void)
+{
+  return _recoveries;
+}
+
+/**************************************************************************/
+/*!
+    @brief    How long the last successful recovery took, from powering
+              the module down to the sockets being re-opened, in ms
+*/
+/**************************************************************************/
+uint32_t Adafruit_CC3000::getLastRecoveryTime(void)
+{
+  return _lastRecoveryTime;
+}
+
+/**************************************************************************/
+/*!
+    @brief    The number of sockets that are open on the module
+
+    @param    listening  False to leave out the sockets servers listen on
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000::openSockets(bool listening)
+{
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < MAX_SOCKETS; i++)
+  {
+    if ((get_socket_active_status(i) == SOCKET_STATUS_ACTIVE) &&
+        (listening || !(cc3000_ctx->listenSockets & (1UL << i))))
+    {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Marks every open socket closed, for when the link they ran
+              over is gone: Adafruit_CC3000_Client::connected() then
+              returns false and closes them
+*/
+/**************************************************************************/
+void Adafruit_CC3000::dropSockets(void)
+{
+  if (_ctx == NULL) return;
+  CC3000_SELECT(_ctx);
+
+  for (uint8_t i = 0; i < MAX_SOCKETS; i++)
+  {
+    if (get_socket_active_status(i) == SOCKET_STATUS_ACTIVE)
+    {
+      closed_sockets[i] = true;
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief    Re-opens the registered sockets after a recovery
+*/
+/**************************************************************************/
+void Adafruit_CC3000::replaySockets(void)
+{
+  for (uint8_t i = 0; i < CC3000_REPLAY_SLOTS; i++)
+  {
+    replay_t *r = &_replay[i];
+
+    if (r->sock == 0)
+    {
+      continue;
+    }
+
+    if ((r->type == CC3000_REPLAY_LISTEN) && (_replayPolicy & CC3000_REPLAY_LISTEN))
+    {
+      Adafruit_CC3000_Server *server = (Adafruit_CC3000_Server *)r->sock;
+      for (uint8_t c = 0; c < MAX_SERVER_CLIENTS; c++)
+      {
+        server->_clients[c] = Adafruit_CC3000_Client();
+      }
+      server->begin();
+    }
+    else if ((r->type == CC3000_REPLAY_CLIENTS) && (_replayPolicy & CC3000_REPLAY_CLIENTS))
+    {
+#ifndef CC3000_TINY_DRIVER
+      if (r->udp)
+      {
+        *(Adafruit_CC3000_Client *)r->sock = connectUDP(r->ip, r->port);
+        continue;
+      }
+#endif
+      *(Adafruit_CC3000_Client *)r->sock = connectTCP(r->ip, r->port);
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @Brief   Prints out the current status flag of the CC3000
+
+    @note     This command isn't available when the CC3000 is configured
+              in 'CC3000_TINY_DRIVER' mode
+*/
+/**************************************************************************/
+status_t Adafruit_CC3000::getStatus()
+{
+  if (_ctx == NULL) return STATUS_DISCONNECTED;
+  CC3000_SELECT(_ctx);
+  if (!_initialised)
+  {
+    return STATUS_DISCONNECTED;
+  }
+
+  long results = wlan_ioctl_statusget();
+
+  switch(results)
+  {
+    case 1:
+      return STATUS_SCANNING;
+      break;
+    case 2:
+      return STATUS_CONNECTING;
+      break;
+    case 3:
+      return STATUS_CONNECTED;
+      break;
+    case 0:
+    default:
+      return STATUS_DISCONNECTED;
+      break;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief    Calls listSSIDs and then displays the results of the SSID scan
+
+              For the moment we only list these via CC3KPrinter->print since
+              this can consume a lot of memory passing all the data
+              back with a buffer
+
+    @note     This command isn't available when the CC3000 is configured
+              in 'CC3000_TINY_DRIVER' mode
+
+    @returns  False if an error occured!
+*/
+/**************************************************************************/
+#ifndef CC3000_TINY_DRIVER
+
+ResultStruct_t SSIDScanResultBuff;
 
 
 uint16_t Adafruit_CC3000::startSSIDscan() {
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
   uint16_t   index = 0;
 
   if (!_initialised)
@@ -749,7 +1636,7 @@ uint16_t Adafruit_CC3000::startSSIDscan() {
 
   // Wait for results
   WDT_RESET();
-  delay(4500);
+  cc3k_delay(_scanConfig.scanTime);
 
   CHECK_SUCCESS(wlan_ioctl_get_scan_results(0, (uint8_t* ) &SSIDScanResultBuff),
                 CC3000_MSG_FAIL_SSID_SCAN, false);
@@ -776,11 +1663,206 @@ uint8_t Adafruit_CC3000::getNextSSID(uint8_t *rssi, uint8_t *secMode, char *ssid
                   CC3000_MSG_ERR_SSID_SCAN_RESULT, false);
     return valid;
 }
+
+/**************************************************************************/
+/*!
+    @brief    Runs a scan and collects its results into the caller's
+              table in one pass: each AP shows up once (by BSSID, with its
+              strongest reading) and the table is sorted strongest first.
+              When there are more APs than entries the weakest are
+              dropped.
+
+    @args[in] target
+              An optional SSID; collecting stops as soon as it is seen,
+              the APs not read yet are left out
+
+    @note     This command isn't available when the CC3000 is configured
+              in 'CC3000_TINY_DRIVER' mode
+
+    @returns  The number of entries filled in, 0 if the scan failed
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000::collectScanResults(cc3000_scan_entry_t *table, uint8_t size, const char *target)
+{
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  uint8_t count;
+
+  if (!_initialised || (size == 0) || !scanSSIDs(4000))
+  {
+    return 0;
+  }
+
+  WDT_RESET();
+  cc3k_delay(_scanConfig.scanTime);
+
+  count = readScanResults(table, size, target, true);
+
+  scanSSIDs(0);
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Reads the results of a scan that is running or has run (see
+              scanSSIDs()) into a table, like collectScanResults() does.
+              It doesn't start or stop a scan.
+
+    @args[in] target
+              An optional SSID. With stopAtTarget reading stops as soon as
+              it is seen, otherwise only the APs of that SSID are kept.
+
+    @note     This command isn't available when the CC3000 is configured
+              in 'CC3000_TINY_DRIVER' mode
+
+    @returns  The number of entries filled in
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000::readScanResults(cc3000_scan_entry_t *table, uint8_t size, const char *target, bool stopAtTarget)
+{
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  ResultStruct_t result;
+  uint32_t remaining;
+  uint8_t count = 0;
+  uint8_t targetLen = target ? strlen(target) : 0;
+
+  if (!_initialised || (size == 0))
+  {
+    return 0;
+  }
+
+  // Every read returns one entry along with the number of APs found
+  if (wlan_ioctl_get_scan_results(0, (uint8_t *)&result) != 0)
+  {
+    return 0;
+  }
+
+  for (remaining = result.num_networks; remaining > 0; remaining--)
+  {
+    uint8_t rssi = result.rssiByte >> 1;
+    uint8_t ssidLen = result.Sec_ssidLen >> 2;
+    bool isTarget;
+    uint8_t i;
+
+    if (ssidLen > sizeof(table[0].ssid))
+    {
+      ssidLen = sizeof(table[0].ssid);
+    }
+    isTarget = targetLen && (ssidLen == targetLen) &&
+               (memcmp(result.ssid_name, target, targetLen) == 0);
+
+    if ((result.rssiByte & 0x01) && (stopAtTarget || !targetLen || isTarget))
+    {
+      // Already in the table? Then only keep the stronger reading
+      for (i = 0; i < count; i++)
+      {
+        if (memcmp(table[i].bssid, result.bssid, 6) == 0)
+        {
+          break;
+        }
+      }
+
+      if ((i == count) && (count == size))
+      {
+        // Full: replaces the weakest entry, which is the last one
+        i = count - 1;
+        if (table[i].rssi >= rssi)
+        {
+          i = size;
+        }
+      }
+      else if (i < count)
+      {
+        if (table[i].rssi >= rssi)
+        {
+          i = size;
+        }
+      }
+      else
+      {
+        count++;
+      }
+
+      if (i < size)
+      {
+        table[i].rssi = rssi;
+        table[i].secMode = result.Sec_ssidLen & 0x03;
+        table[i].ssidLen = ssidLen;
+        memcpy(table[i].bssid, result.bssid, 6);
+        memcpy(table[i].ssid, result.ssid_name, ssidLen);
+
+        // Move it up to its place, the rest of the table is sorted
+        for (; (i > 0) && (table[i - 1].rssi < table[i].rssi); i--)
+        {
+          cc3000_scan_entry_t swap = table[i - 1];
+          table[i - 1] = table[i];
+          table[i] = swap;
+        }
+      }
+
+      if (isTarget && stopAtTarget)
+      {
+        break;
+      }
+    }
+
+    WDT_RESET();
+    if ((remaining > 1) &&
+        (wlan_ioctl_get_scan_results(0, (uint8_t *)&result) != 0))
+    {
+      break;
+    }
+  }
+
+  return count;
+}
 #endif
 
 /**************************************************************************/
 /*!
-    @brief    Starts the smart config connection process
+    @brief    Starts the smart config connection process and blocks until
+              it's done, see smartConfigBegin() for a non-blocking one
+
+    @note     This command isn't available when the CC3000 is configured
+              in 'CC3000_TINY_DRIVER' mode
+
+    @returns  False if an error occured!
+*/
+/**************************************************************************/
+#ifndef CC3000_TINY_DRIVER
+bool Adafruit_CC3000::startSmartConfig(bool enableAES)
+{
+  cc3000_smartconfig_state_t state;
+
+  if (!smartConfigBegin(enableAES)) {
+    return false;
+  }
+
+  do {
+    WDT_RESET();
+    state = smartConfigRun();
+    cc3000_idle();
+  } while ((state != CC3000_SMARTCONFIG_DONE) && (state != CC3000_SMARTCONFIG_FAILED));
+
+  return state == CC3000_SMARTCONFIG_DONE;
+}
+
+/* A step of smartConfigRun() failed: report it and give up */
+#define SMARTCONFIG_CHECK(func,Notify)  {if ((func) != CC3000_SUCCESS) { if (CC3KPrinter != 0) CC3KPrinter->println(F(Notify)); smartConfigEnter(CC3000_SMARTCONFIG_FAILED, 0); break;}}
+
+/**************************************************************************/
+/*!
+    @brief    Starts SmartConfig provisioning without blocking: call
+              smartConfigRun() from loop() until it returns
+              CC3000_SMARTCONFIG_DONE or CC3000_SMARTCONFIG_FAILED.
+
+    @args[in] enableAES
+              Set this to true if the phone app encrypts the AP key
+    @args[in] timeout
+              How long to wait for the phone app, in milliseconds
+    @args[in] progress
+              Optional, called with every new state
 
     @note     This command isn't available when the CC3000 is configured
               in 'CC3000_TINY_DRIVER' mode
@@ -788,20 +1870,23 @@ uint8_t Adafruit_CC3000::getNextSSID(uint8_t *rssi, uint8_t *secMode, char *ssid
     @returns  False if an error occured!
 */
 /**************************************************************************/
-#ifndef CC3000_TINY_DRIVER
-bool Adafruit_CC3000::startSmartConfig(bool enableAES)
+bool Adafruit_CC3000::smartConfigBegin(bool enableAES, uint32_t timeout, cc3000_smartconfig_callback_t progress)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   ulSmartConfigFinished = 0;
   ulCC3000Connected = 0;
   ulCC3000DHCP = 0;
   OkToDoShutDown=0;
 
-  uint32_t   timeout = 0;
-
   if (!_initialised) {
     return false;
   }
 
+  _scAES = enableAES;
+  _scTimeout = timeout;
+  _scProgress = progress;
+
   // Reset all the previous configurations
   CHECK_SUCCESS(wlan_ioctl_set_connection_policy(WIFI_DISABLE, WIFI_DISABLE, WIFI_DISABLE),
                 CC3000_MSG_FAIL_SET_CONN_POLICY_11, false);
@@ -811,111 +1896,164 @@ bool Adafruit_CC3000::startSmartConfig(bool enableAES)
                 CC3000_MSG_FAIL_DEL_PROFILES_13, false);
 
   // CC3KPrinter->println("Disconnecting");
-  // Wait until CC3000 is disconnected
-  while (ulCC3000Connected == WIFI_STATUS_CONNECTED) {
-    WDT_RESET();
-    cc3k_int_poll();
+  clearEvents(CC3000_EVENT_DISCONNECTED);
+  if (ulCC3000Connected == WIFI_STATUS_CONNECTED) {
     CHECK_SUCCESS(wlan_disconnect(),
                   CC3000_MSG_FAIL_DISCONNECT_AP, false);
-    delay(10);
-    hci_unsolicited_event_handler();
   }
 
-  // Reset the CC3000
-  wlan_stop();
-  WDT_RESET();
-  delay(1000);
-  wlan_start(0);
+  smartConfigEnter(CC3000_SMARTCONFIG_DISCONNECTING, WLAN_CONNECT_TIMEOUT);
+  return true;
+}
 
-  // create new entry for AES encryption key
-  CHECK_SUCCESS(nvmem_create_entry(NVMEM_AES128_KEY_FILEID,16),
-                CC3000_MSG_FAIL_NEW_NVMEM_ENTRY, false);
-  
-  // write AES key to NVMEM
-  CHECK_SUCCESS(aes_write_key((unsigned char *)(&_smartConfigKey[0])),
-                CC3000_MSG_FAIL_WRITE_AES_KEY, false);
-  
-  //CC3KPrinter->println("Set prefix");
-  // Wait until CC3000 is disconnected
-  CHECK_SUCCESS(wlan_smart_config_set_prefix((char *)&_cc3000_prefix),
-                CC3000_MSG_FAIL_SMART_CFG_PREFIX, false);
+/**************************************************************************/
+/*!
+    @brief    Advances SmartConfig provisioning, see smartConfigBegin().
+              The waits (for the phone app, the resets, the connection)
+              return right away; only the module restarts take a moment.
 
-  //CC3KPrinter->println("Start config");
-  // Start the SmartConfig start process
-  CHECK_SUCCESS(wlan_smart_config_start(0),
-                CC3000_MSG_FAIL_START_SMART_CFG, false);
+    @returns  The current state
+*/
+/**************************************************************************/
+cc3000_smartconfig_state_t Adafruit_CC3000::smartConfigRun(void)
+{
+  if (_ctx == NULL) return CC3000_SMARTCONFIG_FAILED;
+  CC3000_SELECT(_ctx);
+  bool expired = (millis() - _scSince >= _scWait);
 
-  // Wait for smart config process complete (event in CC3000_UsynchCallback)
-  while (ulSmartConfigFinished == 0)
-  {
-    WDT_RESET();
-    cc3k_int_poll();
-    // waiting here for event SIMPLE_CONFIG_DONE
-    timeout+=10;
-    if (timeout > 60000)   // ~60s
-    {
-      return false;
-    }
-    delay(10); // ms
-    //  CC3KPrinter->print('.');
-  }
+  cc3k_int_poll();
 
-  CC3KPrinter->println(F("Got smart config data"));
-  if (enableAES) {
-    CHECK_SUCCESS(wlan_smart_config_process(),
-                 CC3000_MSG_FAIL_SMART_CFG_PROC, false);
-  }
-  
-  // ******************************************************
-  // Decrypt configuration information and add profile
-  // ToDo: This is causing stack overflow ... investigate
-  // CHECK_SUCCESS(wlan_smart_config_process(),
-  //             "Smart config failed", false);
-  // ******************************************************
-
-  // Connect automatically to the AP specified in smart config settings
-  CHECK_SUCCESS(wlan_ioctl_set_connection_policy(WIFI_DISABLE, WIFI_DISABLE, WIFI_ENABLE),
-                CC3000_MSG_FAIL_SET_CONN_POLICY_19, false);
-  
-  // Reset the CC3000
-  wlan_stop();
-  WDT_RESET();
-  delay(1000);
-  wlan_start(0);
-  
-  // Mask out all non-required events
-  CHECK_SUCCESS(wlan_set_event_mask(HCI_EVNT_WLAN_KEEPALIVE |
-                HCI_EVNT_WLAN_UNSOL_INIT
-                //HCI_EVNT_WLAN_ASYNC_PING_REPORT |
-                //HCI_EVNT_WLAN_TX_COMPLETE
-                ),
-                CC3000_MSG_FAIL_SET_EVNT_MASK_20, false);
-
-  // Wait for a connection
-  timeout = 0;
-  while(!ulCC3000Connected)
+  switch (_scState)
   {
-    WDT_RESET();
-    cc3k_int_poll();
-    if(timeout > WLAN_CONNECT_TIMEOUT) // ~20s
-    {
-      if (CC3KPrinter != 0) {
-        CC3KPrinter->println(F(CC3000_MSG_TIMEOUT_CONNECT));
+    case CC3000_SMARTCONFIG_DISCONNECTING:
+      // Wait until CC3000 is disconnected
+      if ((ulCC3000Connected != WIFI_STATUS_CONNECTED) || expired)
+      {
+        // Reset the CC3000
+        wlan_stop();
+        smartConfigEnter(CC3000_SMARTCONFIG_RESETTING, 1000);
       }
-      return false;
-    }
-    timeout += 10;
-    delay(10);
+      break;
+
+    case CC3000_SMARTCONFIG_RESETTING:
+      if (!expired)
+      {
+        break;
+      }
+      SMARTCONFIG_CHECK(wlan_start(0), CC3000_MSG_TIMEOUT_START);
+
+      // create new entry for AES encryption key
+      SMARTCONFIG_CHECK(nvmem_create_entry(NVMEM_AES128_KEY_FILEID,16),
+                        CC3000_MSG_FAIL_NEW_NVMEM_ENTRY);
+
+      // write AES key to NVMEM
+      SMARTCONFIG_CHECK(aes_write_key((unsigned char *)(&_smartConfigKey[0])),
+                        CC3000_MSG_FAIL_WRITE_AES_KEY);
+
+      //CC3KPrinter->println("Set prefix");
+      SMARTCONFIG_CHECK(wlan_smart_config_set_prefix((char *)&_cc3000_prefix),
+                        CC3000_MSG_FAIL_SMART_CFG_PREFIX);
+
+      //CC3KPrinter->println("Start config");
+      // Start the SmartConfig start process
+      clearEvents(CC3000_EVENT_SMART_CONFIG);
+      SMARTCONFIG_CHECK(wlan_smart_config_start(0),
+                        CC3000_MSG_FAIL_START_SMART_CFG);
+
+      smartConfigEnter(CC3000_SMARTCONFIG_LISTENING, _scTimeout);
+      break;
+
+    case CC3000_SMARTCONFIG_LISTENING:
+      // Wait for smart config process complete (event in CC3000_UsynchCallback)
+      if (!waitFor(CC3000_EVENT_SMART_CONFIG, 0))
+      {
+        if (expired)
+        {
+          wlan_smart_config_stop();
+          smartConfigEnter(CC3000_SMARTCONFIG_FAILED, 0);
+        }
+        break;
+      }
+
+      if (CC3KPrinter != 0) CC3KPrinter->println(F("Got smart config data"));
+      if (_scAES) {
+        SMARTCONFIG_CHECK(wlan_smart_config_process(),
+                          CC3000_MSG_FAIL_SMART_CFG_PROC);
+      }
+
+      // Connect automatically to the AP specified in smart config settings
+      SMARTCONFIG_CHECK(wlan_ioctl_set_connection_policy(WIFI_DISABLE, WIFI_DISABLE, WIFI_ENABLE),
+                        CC3000_MSG_FAIL_SET_CONN_POLICY_19);
+
+      // Reset the CC3000
+      wlan_stop();
+      smartConfigEnter(CC3000_SMARTCONFIG_RESTARTING, 1000);
+      break;
+
+    case CC3000_SMARTCONFIG_RESTARTING:
+      if (!expired)
+      {
+        break;
+      }
+      clearEvents(CC3000_EVENT_CONNECTED | CC3000_EVENT_DHCP);
+      SMARTCONFIG_CHECK(wlan_start(0), CC3000_MSG_TIMEOUT_START);
+
+      // Mask out all non-required events
+      SMARTCONFIG_CHECK(wlan_set_event_mask(HCI_EVNT_WLAN_KEEPALIVE |
+                        HCI_EVNT_WLAN_UNSOL_INIT
+                        //HCI_EVNT_WLAN_ASYNC_PING_REPORT |
+                        //HCI_EVNT_WLAN_TX_COMPLETE
+                        ),
+                        CC3000_MSG_FAIL_SET_EVNT_MASK_20);
+
+      smartConfigEnter(CC3000_SMARTCONFIG_CONNECTING, WLAN_CONNECT_TIMEOUT);
+      break;
+
+    case CC3000_SMARTCONFIG_CONNECTING:
+      if (ulCC3000Connected)
+      {
+        // Give DHCP a moment, the device name is only advertised with an address
+        smartConfigEnter(CC3000_SMARTCONFIG_DHCP, 1000);
+      }
+      else if (expired)
+      {
+        if (CC3KPrinter != 0) {
+          CC3KPrinter->println(F(CC3000_MSG_TIMEOUT_CONNECT));
+        }
+        smartConfigEnter(CC3000_SMARTCONFIG_FAILED, 0);
+      }
+      break;
+
+    case CC3000_SMARTCONFIG_DHCP:
+      if (ulCC3000DHCP)
+      {
+        mdnsAdvertiser(1, (char *) _deviceName, strlen(_deviceName));
+        smartConfigEnter(CC3000_SMARTCONFIG_DONE, 0);
+      }
+      else if (expired)
+      {
+        smartConfigEnter(CC3000_SMARTCONFIG_DONE, 0);
+      }
+      break;
+
+    default:
+      break;
   }
 
-  WDT_RESET();
-  delay(1000);
-  if (ulCC3000DHCP)
+  return _scState;
+}
+
+/* Moves SmartConfig on to a state that lasts at most wait milliseconds */
+void Adafruit_CC3000::smartConfigEnter(cc3000_smartconfig_state_t state, uint32_t wait)
+{
+  _scState = state;
+  _scWait = wait;
+  _scSince = millis();
+
+  if (_scProgress)
   {
-    mdnsAdvertiser(1, (char *) _deviceName, strlen(_deviceName));
+    _scProgress(state);
   }
-
-  return true;
 }
 
 #endif
@@ -933,6 +2071,8 @@ bool Adafruit_CC3000::startSmartConfig(bool enableAES)
 #if !defined(CC3000_TINY_DRIVER) || !defined(CC3000_SECURE)
 bool Adafruit_CC3000::connectOpen(const char *ssid)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised) {
     return false;
   }
@@ -941,7 +2081,7 @@ bool Adafruit_CC3000::connectOpen(const char *ssid)
     CHECK_SUCCESS(wlan_ioctl_set_connection_policy(0, 0, 0),
                  CC3000_MSG_FAIL_SET_CONN_POLICY_22, false);
     WDT_RESET();
-    delay(500);
+    cc3k_delay(500);
     CHECK_SUCCESS(wlan_connect(WLAN_SEC_UNSEC,
 					(const char*)ssid, strlen(ssid),
 					0 ,NULL,0),
@@ -977,12 +2117,14 @@ void CC3000_UsynchCallback(long lEventType, char * data, unsigned char length)
   {
     ulSmartConfigFinished = 1;
     ucStopSmartConfig     = 1;
+    cc3000_ctx->events   |= CC3000_EVENT_SMART_CONFIG;
   }
 #endif
 
   if (lEventType == HCI_EVNT_WLAN_UNSOL_CONNECT)
   {
     ulCC3000Connected = 1;
+    cc3000_ctx->events |= CC3000_EVENT_CONNECTED;
   }
 
   if (lEventType == HCI_EVNT_WLAN_UNSOL_DISCONNECT)
@@ -990,17 +2132,36 @@ void CC3000_UsynchCallback(long lEventType, char * data, unsigned char length)
     ulCC3000Connected = 0;
     ulCC3000DHCP      = 0;
     ulCC3000DHCP_configured = 0;
+    cc3000_ctx->ipConfigState = CC3000_IPCONFIG_NONE;
+    cc3000_ctx->events |= CC3000_EVENT_DISCONNECTED;
   }
   
   if (lEventType == HCI_EVNT_WLAN_UNSOL_DHCP)
   {
     ulCC3000DHCP = 1;
+    // The addresses come with the event, keep them for getIPAddress()
+    // (the status byte after them is 0 when the lease is good)
+    if ((length > sizeof(cc3000_ctx->ipConfig)) && (data[sizeof(cc3000_ctx->ipConfig)] == 0))
+    {
+      memcpy(cc3000_ctx->ipConfig, data, sizeof(cc3000_ctx->ipConfig));
+      cc3000_ctx->ipConfigState = CC3000_IPCONFIG_ADDRESSES;
+    }
+    else
+    {
+      cc3000_ctx->ipConfigState = CC3000_IPCONFIG_NONE;
+    }
+    if (cc3000_ctx->dhcpTime == 0)
+    {
+      cc3000_ctx->dhcpTime = millis();
+    }
+    cc3000_ctx->events |= CC3000_EVENT_DHCP;
   }
 
 #ifndef CC3000_TINY_DRIVER
   if (lEventType == HCI_EVENT_CC3000_CAN_SHUT_DOWN)
   {
     OkToDoShutDown = 1;
+    cc3000_ctx->events |= CC3000_EVENT_CAN_SHUT_DOWN;
   }
 
   if (lEventType == HCI_EVNT_WLAN_ASYNC_PING_REPORT)
@@ -1008,6 +2169,7 @@ void CC3000_UsynchCallback(long lEventType, char * data, unsigned char length)
     //PRINT_F("CC3000: Ping report\n\r");
     pingReportnum++;
     memcpy(&pingReport, data, length);
+    cc3000_ctx->events |= CC3000_EVENT_PING_REPORT;
   }
 #endif
 
@@ -1017,6 +2179,7 @@ void CC3000_UsynchCallback(long lEventType, char * data, unsigned char length)
     //PRINT_F("TCP Close wait #"); printDec(socketnum);
     if (socketnum < MAX_SOCKETS)
       closed_sockets[socketnum] = true;
+    cc3000_ctx->events |= CC3000_EVENT_TCP_CLOSE;
   }
 }
 
@@ -1033,6 +2196,8 @@ void CC3000_UsynchCallback(long lEventType, char * data, unsigned char length)
 #if ! defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
 bool Adafruit_CC3000::connectSecure(const char *ssid, const char *key, int32_t secMode)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised) {
     return false;
   }
@@ -1071,7 +2236,7 @@ bool Adafruit_CC3000::connectSecure(const char *ssid, const char *key, int32_t s
   CHECK_SUCCESS(wlan_ioctl_set_connection_policy(0, 0, 0),
                 CC3000_MSG_FAIL_SET_CONN_POLICY_27, false);
   WDT_RESET();
-  delay(500);
+  cc3k_delay(500);
   CHECK_SUCCESS(wlan_connect(secMode, (char *)ssid, strlen(ssid),
                              NULL,
                              (unsigned char *)key, strlen(key)),
@@ -1083,15 +2248,25 @@ bool Adafruit_CC3000::connectSecure(const char *ssid, const char *key, int32_t s
 }
 #endif
 
-// Connect with timeout
-bool Adafruit_CC3000::connectToAP(const char *ssid, const char *key, uint8_t secmode) {
+// Connect with timeout, giving up after the given number of attempts (0 tries until connected)
+bool Adafruit_CC3000::connectToAP(const char *ssid, const char *key, uint8_t secmode, uint8_t attempts) {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised) {
     return false;
   }
 
-  int16_t timer;
+  // Remembered for recover(), so the strings must stay around
+  _apSSID = ssid;
+  _apKey = key;
+  _apSecmode = secmode;
 
+  uint8_t attempt = 0;
   do {
+    if ((attempts > 0) && (attempt++ == attempts)) {
+      if (CC3KPrinter != 0) CC3KPrinter->println(F(CC3000_MSG_FAIL_CONNECT_AP));
+      return false;
+    }
     WDT_RESET();
     cc3k_int_poll();
     /* MEME: not sure why this is absolutely required but the cc3k freaks
@@ -1101,11 +2276,12 @@ bool Adafruit_CC3000::connectToAP(const char *ssid, const char *key, uint8_t sec
     scanSSIDs(4000);
     // Wait for results
     WDT_RESET();
-    delay(4500);
+    cc3k_delay(_scanConfig.scanTime);
     WDT_RESET();
     scanSSIDs(0);
     
     /* Attempt to connect to an access point */
+    clearEvents(CC3000_EVENT_CONNECTED);
     if (CC3KPrinter != 0) {
       CC3KPrinter->print(F(CC3000_MSG_CONNECTING));
       CC3KPrinter->print(ssid);
@@ -1131,18 +2307,11 @@ bool Adafruit_CC3000::connectToAP(const char *ssid, const char *key, uint8_t sec
 #ifndef CC3000_SECURE
     }
 #endif
-	  
-    timer = WLAN_CONNECT_TIMEOUT;
+
 
     /* Wait around a bit for the async connected signal to arrive or timeout */
     if (CC3KPrinter != 0) CC3KPrinter->print(F(CC3000_MSG_WAITING_CONNECT));
-    while ((timer > 0) && !checkConnected())
-    {
-      cc3k_int_poll();
-      delay(10);
-      timer -= 10;
-    }
-    if (timer <= 0) {
+    if (!checkConnected() && !waitFor(CC3000_EVENT_CONNECTED, WLAN_CONNECT_TIMEOUT)) {
       if (CC3KPrinter != 0) CC3KPrinter->println(F(CC3000_MSG_TIMEOUT));
     }
   } while (!checkConnected());
@@ -1150,25 +2319,150 @@ bool Adafruit_CC3000::connectToAP(const char *ssid, const char *key, uint8_t sec
   return true;
 }
 
+/**************************************************************************/
+/*!
+    @brief    Connects on the fast-boot path, use it after
+              begin(0, false, true). If the device rejoins the AP it was
+              last connected to within timeout milliseconds no scan is
+              run at all; otherwise it falls back to connectToAP(), for
+              at most attempts scan and connect rounds.
+
+              After a fallback connect the Fast Connect policy is turned
+              on, so from the next boot on the device rejoins this AP by
+              itself while begin() is still running.
+
+    @note     The strings must stay around, see connectToAP()
+
+    @returns  False if neither path got a connection
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::connectFast(const char *ssid, const char *key, uint8_t secmode, uint32_t timeout,
+                                  uint8_t attempts)
+{
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised) {
+    return false;
+  }
+
+  _apSSID = ssid;
+  _apKey = key;
+  _apSecmode = secmode;
+
+  if (checkConnected() || waitFor(CC3000_EVENT_CONNECTED, timeout))
+  {
+    return true;
+  }
+
+  // No last-known-good AP (or it's gone), take the slow path, but not forever
+  if (!connectToAP(ssid, key, secmode, attempts))
+  {
+    return false;
+  }
+
+  // Fast Connect - the CC3000 device tries to reconnect to the last AP connected to
+  CHECK_SUCCESS(wlan_ioctl_set_connection_policy(0, 1, 0),
+                CC3000_MSG_FAIL_SET_FAST_CONNECT, false);
+
+  return true;
+}
 
 #ifndef CC3000_TINY_DRIVER
-uint16_t Adafruit_CC3000::ping(uint32_t ip, uint8_t attempts, uint16_t timeout, uint8_t size) {
-  if (!_initialised) return 0;
-  if (!ulCC3000Connected) return 0;
-  if (!ulCC3000DHCP) return 0;
+/* The IP2U32 byte order to the order netapp_dhcp() sends */
+static uint32_t ipToStream(uint32_t ip)
+{
+  return (ip >> 24) | ((ip >> 8) & 0x0000FF00UL) |
+         ((ip << 8) & 0x00FF0000UL) | (ip << 24);
+}
 
-  uint32_t revIP = (ip >> 24) | ((ip >> 8) & 0xFF00) | ((ip & 0xFF00) << 8) | (ip << 24);
+/**************************************************************************/
+/*!
+    @brief    Gives the device a static IP configuration instead of DHCP,
+              e.g. the lease that getIPAddress() returned on an earlier
+              boot. The addresses are in the IP2U32 byte order.
 
-  pingReportnum = 0;
-  pingReport.packets_received = 0;
+    @note     The configuration is saved on the device and used from its
+              next start on, where it saves the whole DHCP exchange. Only
+              call it when the configuration changes, as every call
+              writes to the device's NVMEM.
 
-  //if (CC3KPrinter != 0) {
-  //  CC3KPrinter->print(F("Pinging ")); printIPdots(revIP); CC3KPrinter->print(" ");
-  //  CC3KPrinter->print(attempts); CC3KPrinter->println(F(" times"));
-  //}
-  
-  netapp_ping_send(&revIP, attempts, size, timeout);
-  delay(timeout*attempts*2);
+    @note     This command isn't available when the CC3000 is configured
+              in 'CC3000_TINY_DRIVER' mode
+
+    @returns  False if the device refused the configuration
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::setStaticIPAddress(uint32_t ip, uint32_t subnetMask, uint32_t defaultGateway, uint32_t dnsServer)
+{
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised) {
+    return false;
+  }
+
+  unsigned long aucIP = ipToStream(ip);
+  unsigned long aucSubnetMask = ipToStream(subnetMask);
+  unsigned long aucDefaultGateway = ipToStream(defaultGateway);
+  unsigned long aucDNSServer = ipToStream(dnsServer);
+
+  CHECK_SUCCESS(netapp_dhcp(&aucIP, &aucSubnetMask, &aucDefaultGateway, &aucDNSServer),
+                CC3000_MSG_FAIL_SET_IP_CONFIG, false);
+
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Switches the device back to DHCP from its next start on, see
+              setStaticIPAddress()
+
+    @returns  False if the device refused the configuration
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::setDHCP(void)
+{
+  return setStaticIPAddress(0, 0, 0, 0);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief    Boot-to-IP time: how long it took from begin() until the
+              device first had an IP address, in milliseconds
+
+    @returns  0 while there is no address yet
+*/
+/**************************************************************************/
+uint32_t Adafruit_CC3000::getBootTime(void)
+{
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  if (!_initialised || (_ctx->dhcpTime == 0)) {
+    return 0;
+  }
+
+  return _ctx->dhcpTime - _bootStart;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Pings a host and waits for the report, which comes in once
+              the last attempt is answered or timed out
+
+    @args[in] report
+              Optional, filled with the whole report (round trip times
+              in milliseconds)
+
+    @returns  The number of replies received
+*/
+/**************************************************************************/
+#ifndef CC3000_TINY_DRIVER
+uint16_t Adafruit_CC3000::ping(uint32_t ip, uint8_t attempts, uint16_t timeout, uint8_t size, netapp_pingreport_args_t *report) {
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
+  if (!startPing(ip, attempts, timeout, size)) return 0;
+
+  waitFor(CC3000_EVENT_PING_REPORT, (uint32_t)timeout*attempts*2);
   //if (CC3KPrinter != 0) CC3KPrinter->println(F("Req report"));
   //netapp_ping_report();
   //if (CC3KPrinter != 0) { CC3KPrinter->print(F("Reports: ")); CC3KPrinter->println(pingReportnum); }
@@ -1183,26 +2477,120 @@ uint16_t Adafruit_CC3000::ping(uint32_t ip, uint8_t attempts, uint16_t timeout,
       CC3KPrinter->print(F("AvgT: ")); CC3KPrinter->println(pingReport.avg_round_time);
     }
     //*/
+    if (report) {
+      memcpy(report, &pingReport, sizeof(pingReport));
+    }
     return pingReport.packets_received;
   } else {
     return 0;
   }
 }
 
+/**************************************************************************/
+/*!
+    @brief    Sends a ping without waiting for the report, poll for it
+              with getPingReport()
+
+    @returns  False if there is no connection or the module refused
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::startPing(uint32_t ip, uint8_t attempts, uint16_t timeout, uint8_t size) {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised) return false;
+  if (!ulCC3000Connected) return false;
+  if (!ulCC3000DHCP) return false;
+
+  uint32_t revIP = (ip >> 24) | ((ip >> 8) & 0xFF00) | ((ip & 0xFF00) << 8) | (ip << 24);
+
+  pingReportnum = 0;
+  pingReport.packets_received = 0;
+  clearEvents(CC3000_EVENT_PING_REPORT);
+
+  //if (CC3KPrinter != 0) {
+  //  CC3KPrinter->print(F("Pinging ")); printIPdots(revIP); CC3KPrinter->print(" ");
+  //  CC3KPrinter->print(attempts); CC3KPrinter->println(F(" times"));
+  //}
+  
+  return netapp_ping_send(&revIP, attempts, size, timeout) == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief    Checks for the report of a ping sent with startPing(),
+              without waiting
+
+    @returns  True once the report came in (and was copied to report)
+*/
+/**************************************************************************/
+bool Adafruit_CC3000::getPingReport(netapp_pingreport_args_t *report) {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
+  if (!_initialised) return false;
+
+  if (!waitFor(CC3000_EVENT_PING_REPORT, 0)) return false;
+
+  memcpy(report, &pingReport, sizeof(pingReport));
+  return true;
+}
+
 #endif
 
+/**************************************************************************/
+/*!
+    @brief    Looks a host name up. Answers (and failures) are cached,
+              asking again for the same name is free until the entry
+              expires, see utility/cc3000_dns.h.
+
+    @returns  What gethostbyname() returned, ip is 0 if the name wasn't
+              resolved
+*/
+/**************************************************************************/
 #ifndef CC3000_TINY_DRIVER
 uint16_t Adafruit_CC3000::getHostByName(char *hostname, uint32_t *ip) {
+  if (_ctx == NULL) return 0;
+  CC3000_SELECT(_ctx);
   if (!_initialised) return 0;
   if (!ulCC3000Connected) return 0;
   if (!ulCC3000DHCP) return 0;
 
-  int16_t r = gethostbyname(hostname, strlen(hostname), ip);
+  int16_t r = dns_cache_gethostbyname(hostname, strlen(hostname), ip);
   //if (CC3KPrinter != 0) { CC3KPrinter->print("Errno: "); CC3KPrinter->println(r); }
   return r;
 }
+
+/**************************************************************************/
+/*!
+    @brief    Forgets the cached host names, e.g. after moving to another
+              network
+*/
+/**************************************************************************/
+void Adafruit_CC3000::flushHostCache(void) {
+  if (_ctx == NULL) return;
+  CC3000_SELECT(_ctx);
+  dns_cache_flush();
+}
 #endif
 
+/**************************************************************************/
+/*!
+    Services the CC3000 SPI transport: samples the IRQ line and handles
+    at most one pending SPI frame (plus any unsolicited event it carries)
+
+    @note     Call this from your main loop when the library is built with
+              CC3000_POLLED, otherwise events like connect/disconnect or
+              DHCP are only seen while another driver call is waiting
+*/
+/**************************************************************************/
+void Adafruit_CC3000::poll(void)
+{
+  if (_ctx == NULL) return;
+  CC3000_SELECT(_ctx);
+  if (!_initialised) return;
+
+  cc3k_int_poll();
+}
+
 /**************************************************************************/
 /*!
     Checks if the device is connected or not
@@ -1212,6 +2600,8 @@ uint16_t Adafruit_CC3000::getHostByName(char *hostname, uint32_t *ip) {
 /**************************************************************************/
 bool Adafruit_CC3000::checkConnected(void)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   return ulCC3000Connected ? true : false;
 }
 
@@ -1224,6 +2614,8 @@ bool Adafruit_CC3000::checkConnected(void)
 /**************************************************************************/
 bool Adafruit_CC3000::checkDHCP(void)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   return ulCC3000DHCP ? true : false;
 }
 
@@ -1237,6 +2629,8 @@ bool Adafruit_CC3000::checkDHCP(void)
 #ifndef CC3000_TINY_DRIVER
 bool Adafruit_CC3000::checkSmartConfigFinished(void)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   return ulSmartConfigFinished ? true : false;
 }
 #endif
@@ -1251,11 +2645,13 @@ bool Adafruit_CC3000::checkSmartConfigFinished(void)
 /**************************************************************************/
 bool Adafruit_CC3000::getIPConfig(tNetappIpconfigRetArgs *ipConfig)
 {
+  if (_ctx == NULL) return false;
+  CC3000_SELECT(_ctx);
   if (!_initialised)      return false;
   if (!ulCC3000Connected) return false;
   if (!ulCC3000DHCP)      return false;
   
-  netapp_ipconfig(ipConfig);
+  readIPConfig(ipConfig, true);
   return true;
 }
 #endif
@@ -1268,13 +2664,15 @@ bool Adafruit_CC3000::getIPConfig(tNetappIpconfigRetArgs *ipConfig)
 /**************************************************************************/
 Adafruit_CC3000_Client Adafruit_CC3000::connectTCP(uint32_t destIP, uint16_t destPort)
 {
+  if (_ctx == NULL) return Adafruit_CC3000_Client();
+  CC3000_SELECT(_ctx);
   sockaddr      socketAddress;
   int32_t       tcp_socket;
 
   // Create the socket(s)
   //if (CC3KPrinter != 0) CC3KPrinter->print(F("Creating socket ... "));
   tcp_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-  if (-1 == tcp_socket)
+  if (tcp_socket < 0)
   {
     if (CC3KPrinter != 0) CC3KPrinter->println(F(CC3000_MSG_FAIL_OPEN_SOCKET_TCP));
     return Adafruit_CC3000_Client();
@@ -1300,7 +2698,7 @@ Adafruit_CC3000_Client Adafruit_CC3000::connectTCP(uint32_t destIP, uint16_t des
 
   //printHex((byte *)&socketAddress, sizeof(socketAddress));
   //if (CC3KPrinter != 0) CC3KPrinter->print(F("Connecting socket ... "));
-  if (-1 == connect(tcp_socket, &socketAddress, sizeof(socketAddress)))
+  if (connect(tcp_socket, &socketAddress, sizeof(socketAddress)) < 0)
   {
     if (CC3KPrinter != 0) CC3KPrinter->println(F(CC3000_MSG_ERR_CONN_TCP));
     closesocket(tcp_socket);
@@ -1314,6 +2712,8 @@ Adafruit_CC3000_Client Adafruit_CC3000::connectTCP(uint32_t destIP, uint16_t des
 #ifndef CC3000_TINY_DRIVER
 Adafruit_CC3000_Client Adafruit_CC3000::connectUDP(uint32_t destIP, uint16_t destPort)
 {
+  if (_ctx == NULL) return Adafruit_CC3000_Client();
+  CC3000_SELECT(_ctx);
   sockaddr      socketAddress;
   int32_t       udp_socket;
 
@@ -1322,7 +2722,7 @@ Adafruit_CC3000_Client Adafruit_CC3000::connectUDP(uint32_t destIP, uint16_t des
   // protocol = IPPROTO_TCP, IPPROTO_UDP or IPPROTO_RAW
   //if (CC3KPrinter != 0) CC3KPrinter->print(F("Creating socket... "));
   udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-  if (-1 == udp_socket)
+  if (udp_socket < 0)
   {
     CC3KPrinter->println(F(CC3000_MSG_FAIL_OPEN_SOCKET_UDP));
     return Adafruit_CC3000_Client();
@@ -1347,7 +2747,7 @@ Adafruit_CC3000_Client Adafruit_CC3000::connectUDP(uint32_t destIP, uint16_t des
   }
 
   //printHex((byte *)&socketAddress, sizeof(socketAddress));
-  if (-1 == connect(udp_socket, &socketAddress, sizeof(socketAddress)))
+  if (connect(udp_socket, &socketAddress, sizeof(socketAddress)) < 0)
   {
     if (CC3KPrinter != 0) CC3KPrinter->println(F(CC3000_MSG_ERR_CONN_UDP));
     closesocket(udp_socket);
@@ -1362,12 +2762,21 @@ Adafruit_CC3000_Client Adafruit_CC3000::connectUDP(uint32_t destIP, uint16_t des
 /**********************************************************************/
 Adafruit_CC3000_Client::Adafruit_CC3000_Client(void) {
   _socket = -1;
+  _generation = cc3000_ctx->generation;
+#if CC3000_MAX_INSTANCES > 1
+  _ctx = cc3000_ctx;
+#endif
 }
 
+// The socket belongs to the module whose context is currently selected
 Adafruit_CC3000_Client::Adafruit_CC3000_Client(uint16_t s) {
   _socket = s; 
   bufsiz = 0;
   _rx_buf_idx = 0;
+  _generation = cc3000_ctx->generation;
+#if CC3000_MAX_INSTANCES > 1
+  _ctx = cc3000_ctx;
+#endif
 }
 
 Adafruit_CC3000_Client::Adafruit_CC3000_Client(const Adafruit_CC3000_Client& copy) {
@@ -1376,6 +2785,10 @@ Adafruit_CC3000_Client::Adafruit_CC3000_Client(const Adafruit_CC3000_Client& cop
   bufsiz = copy.bufsiz;
   _rx_buf_idx = copy._rx_buf_idx;
   memcpy(_rx_buf, copy._rx_buf, RXBUFFERSIZE);
+  _generation = copy._generation;
+#if CC3000_MAX_INSTANCES > 1
+  _ctx = copy._ctx;
+#endif
 }
 
 void Adafruit_CC3000_Client::operator=(const Adafruit_CC3000_Client& other) {
@@ -1384,11 +2797,22 @@ void Adafruit_CC3000_Client::operator=(const Adafruit_CC3000_Client& other) {
   bufsiz = other.bufsiz;
   _rx_buf_idx = other._rx_buf_idx;
   memcpy(_rx_buf, other._rx_buf, RXBUFFERSIZE);
+  _generation = other._generation;
+#if CC3000_MAX_INSTANCES > 1
+  _ctx = other._ctx;
+#endif
 }
 
 bool Adafruit_CC3000_Client::connected(void) { 
+  CC3000_SELECT(_ctx);
   if (_socket < 0) return false;
 
+  // The module was restarted under us, the socket number may be reused
+  if (_generation != cc3000_ctx->generation) {
+    _socket = -1;
+    return false;
+  }
+
   if (! available() && closed_sockets[_socket] == true) {
     //if (CC3KPrinter != 0) CC3KPrinter->println("No more data, and closed!");
     closesocket(_socket);
@@ -1402,12 +2826,14 @@ bool Adafruit_CC3000_Client::connected(void) {
 
 int16_t Adafruit_CC3000_Client::write(const void *buf, uint16_t len, uint32_t flags)
 {
+  CC3000_SELECT(_ctx);
   return send(_socket, buf, len, flags);
 }
 
 
 size_t Adafruit_CC3000_Client::write(uint8_t c)
 {
+  CC3000_SELECT(_ctx);
   int32_t r;
   r = send(_socket, &c, 1, 0);
   if ( r < 0 ) return 0;
@@ -1416,6 +2842,7 @@ size_t Adafruit_CC3000_Client::write(uint8_t c)
 
 size_t Adafruit_CC3000_Client::fastrprint(const __FlashStringHelper *ifsh)
 {
+  CC3000_SELECT(_ctx);
   char _tx_buf[TXBUFFERSIZE];
   uint8_t idx = 0;
 
@@ -1463,6 +2890,7 @@ size_t Adafruit_CC3000_Client::fastrprintln(const char *str)
 
 size_t Adafruit_CC3000_Client::fastrprint(const char *str)
 {
+  CC3000_SELECT(_ctx);
   size_t len = strlen(str);
   if (len > 0) {
     return write(str, len, 0);
@@ -1475,19 +2903,40 @@ size_t Adafruit_CC3000_Client::fastrprint(const char *str)
 #ifndef CC3000_TINY_DRIVER
 int16_t Adafruit_CC3000_Client::read(void *buf, uint16_t len, uint32_t flags)
 {
+  CC3000_SELECT(_ctx);
   return recv(_socket, buf, len, flags);
 
 }
+
+/**************************************************************************/
+/*!
+    @brief  Sends up to len bytes that fill writes straight into the
+            driver's TX buffer, see send_fill() in utility/socket.h
+
+    @returns  The bytes sent, 0 if fill had none, negative on an error
+              (before fill was called)
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_Client::writeFill(tSendFill fill, void *arg, uint16_t len, uint32_t flags)
+{
+  CC3000_SELECT(_ctx);
+  return send_fill(_socket, len, flags, fill, arg);
+}
 #endif
 
 int32_t Adafruit_CC3000_Client::close(void) {
-  int32_t x = closesocket(_socket);
+  CC3000_SELECT(_ctx);
+  int32_t x = 0;
+  if (_generation == cc3000_ctx->generation) {
+    x = closesocket(_socket);
+  }
   _socket = -1;
   return x;
 }
 
 uint8_t Adafruit_CC3000_Client::read(void) 
 {
+  CC3000_SELECT(_ctx);
   while ((bufsiz <= 0) || (bufsiz == _rx_buf_idx)) {
     cc3k_int_poll();
     // buffer in some more data
@@ -1506,6 +2955,7 @@ uint8_t Adafruit_CC3000_Client::read(void)
 }
 
 uint8_t Adafruit_CC3000_Client::available(void) {
+  CC3000_SELECT(_ctx);
   // not open!
   if (_socket < 0) return 0;
 
@@ -1530,6 +2980,20 @@ uint8_t Adafruit_CC3000_Client::available(void) {
   else return 0;  // no data is available
 }
 
+/**************************************************************************/
+/*!
+    @brief   Makes this module the target of direct calls into the driver
+             (socket(), send(), netapp_*(), ...) and of servers started
+             afterwards. Only needed with CC3000_MAX_INSTANCES > 1, the
+             Adafruit_CC3000 functions select their module themselves.
+*/
+/**************************************************************************/
+void Adafruit_CC3000::select(void)
+{
+  if (_ctx == NULL) return;
+  CC3000_SELECT(_ctx);
+}
+
 void Adafruit_CC3000::setPrinter(Print* p) {
   CC3KPrinter = p;
 }
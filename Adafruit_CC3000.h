@@ -39,7 +39,33 @@
                                            // or communication will be flakey on 16mhz chips!
 #endif
 
+#define SPI_CLOCK_AUTO        0xFF  // pass as spispeed to let begin() pick the fastest working clock
+#define SPI_CLOCK_PROBE_ROUNDS   8  // round trips that must pass at each clock during auto-tuning
+#define SPI_CLOCK_PROBE_TIMEOUT 50  // how long to wait for each probe reply, in milliseconds
+
 #define WLAN_CONNECT_TIMEOUT 10000  // how long to wait, in milliseconds
+#define CC3000_FAST_CONNECT_TIMEOUT 3000  // how long connectFast() waits for the module to rejoin by itself, in milliseconds
+#define CC3000_CONNECT_ATTEMPTS 3  // scan and connect rounds of connectFast() and recover() before they give up
+
+#define CC3000_HEALTH_INTERVAL   5000  // how often supervise() checks that the module still answers, in milliseconds
+#define CC3000_RECOVERY_OFF_TIME 1000  // how long recover() keeps the module powered down, in milliseconds
+#define CC3000_RECOVERY_DHCP_TIMEOUT 30000  // how long recover() waits for an address, in milliseconds
+#define CC3000_REPLAY_SLOTS         4  // sockets that recover() can re-open
+
+/* Which registered sockets recover() re-opens */
+#define CC3000_REPLAY_NONE     0
+#define CC3000_REPLAY_LISTEN   1  // servers passed to registerServer()
+#define CC3000_REPLAY_CLIENTS  2  // clients passed to registerClient()
+#define CC3000_REPLAY_ALL      (CC3000_REPLAY_LISTEN | CC3000_REPLAY_CLIENTS)
+
+/* Unsolicited events that waitFor() can wait on */
+#define CC3000_EVENT_CONNECTED     0x01
+#define CC3000_EVENT_DISCONNECTED  0x02
+#define CC3000_EVENT_DHCP          0x04
+#define CC3000_EVENT_PING_REPORT   0x08
+#define CC3000_EVENT_SMART_CONFIG  0x10
+#define CC3000_EVENT_CAN_SHUT_DOWN 0x20
+#define CC3000_EVENT_TCP_CLOSE     0x40
 #define RXBUFFERSIZE  64 // how much to buffer on the incoming side
 #define TXBUFFERSIZE  32 // how much to buffer on the outgoing side
 
@@ -65,6 +91,58 @@ typedef struct Result_Struct
 	uint8_t 	bssid[6];
 } ResultStruct_t;  	/**!ResultStruct_t : data struct to store SSID scan results */
 
+/* Scan parameters, see setScanConfig() and wlan_ioctl_set_scan_params() */
+typedef struct
+{
+  uint16_t minDwellTime;   // time spent on each channel, in milliseconds
+  uint16_t maxDwellTime;
+  uint8_t  numProbes;      // probe requests sent per dwell
+  uint16_t channelMask;    // bit 0 is channel 1, see CC3000_SCAN_CHANNEL()
+  int8_t   rssiThreshold;  // weaker APs are left out of the results, in dBm
+  uint16_t interval;       // connection scan period on each channel, in milliseconds
+  uint16_t scanTime;       // how long a scan runs before its results are read, in milliseconds
+} cc3000_scan_config_t;
+
+#define CC3000_SCAN_CHANNEL(ch)   (1 << ((ch) - 1))
+#define CC3000_SCAN_ALL_CHANNELS  0x7FF   // channels 1 to 11
+
+/* Presets for setScanPreset() */
+#define CC3000_SCAN_SURVEY  0   // every channel with long dwells, finds everything
+#define CC3000_SCAN_FAST    1   // only the given channels with short dwells
+
+/* NVMEM user file setScanConfig() saves the parameters in. The module has
+   only two user files (14 and 15): this one is reserved for the library,
+   keep the sketch's own data in file 15. */
+#define CC3000_SCAN_CONFIG_FILEID  14
+#define CC3000_SCAN_CONFIG_MAGIC   0x5D  // first byte of that file while it holds them
+#define CC3000_SCAN_CONFIG_SIZE    13    // the magic byte and the fields, 16-bit ones little endian
+
+/* One AP in the table filled by collectScanResults() */
+typedef struct
+{
+  uint8_t  rssi    : 7;    // as in getNextSSID(), higher is stronger
+  uint8_t  secMode : 2;    // WLAN_SEC_UNSEC, WEP, WPA or WPA2
+  uint8_t  ssidLen : 6;
+  uint8_t  bssid[6];
+  char     ssid[32];       // ssidLen characters, not terminated
+} cc3000_scan_entry_t;
+
+/* SmartConfig provisioning steps, see smartConfigBegin() */
+typedef enum
+{
+  CC3000_SMARTCONFIG_IDLE,
+  CC3000_SMARTCONFIG_DISCONNECTING,
+  CC3000_SMARTCONFIG_RESETTING,
+  CC3000_SMARTCONFIG_LISTENING,    // waiting for the phone app
+  CC3000_SMARTCONFIG_RESTARTING,
+  CC3000_SMARTCONFIG_CONNECTING,   // to the AP the phone app sent
+  CC3000_SMARTCONFIG_DHCP,
+  CC3000_SMARTCONFIG_DONE,
+  CC3000_SMARTCONFIG_FAILED
+} cc3000_smartconfig_state_t;
+
+typedef void (*cc3000_smartconfig_callback_t)(cc3000_smartconfig_state_t state);
+
 /* Enum for wlan_ioctl_statusget results */
 typedef enum 
 {
@@ -75,6 +153,7 @@ typedef enum
 } status_t;
 
 class Adafruit_CC3000;
+class Adafruit_CC3000_Server;
 
 class Adafruit_CC3000_Client : public Print {
  public:
@@ -98,6 +177,7 @@ class Adafruit_CC3000_Client : public Print {
 #ifndef CC3000_TINY_DRIVER
   size_t fastrprintln(const __FlashStringHelper *ifsh);
   int16_t read(void *buf, uint16_t len, uint32_t flags = 0);
+  int16_t writeFill(tSendFill fill, void *arg, uint16_t len, uint32_t flags = 0);
 #endif
 
   int16_t write(const void *buf, uint16_t len, uint32_t flags = 0);
@@ -111,7 +191,12 @@ class Adafruit_CC3000_Client : public Print {
 
  private:
   int16_t _socket;
+  uint8_t _generation;  // the socket is dead once the module was recovered
+#if CC3000_MAX_INSTANCES > 1
+  tCC3000Context *_ctx;
+#endif
 
+  friend class Adafruit_CC3000_Pool;  // checks and closes idle sockets
 };
 
 // Ugly but necessary to include the server header after the client is fully defined.
@@ -123,18 +208,23 @@ class Adafruit_CC3000_Client : public Print {
 class Adafruit_CC3000 {
   public:
   Adafruit_CC3000(uint8_t csPin, uint8_t irqPin, uint8_t vbatPin, uint8_t spispeed = SPI_CLOCK_DIVIDER);
-    bool     begin(uint8_t patchReq = 0, bool useSmartConfigData = false);
+    bool     begin(uint8_t patchReq = 0, bool useSmartConfigData = false, bool fastBoot = false);
     void     reboot(uint8_t patchReq = 0);
     void     stop(void);
+    bool     start(void);
     bool     disconnect(void);
 
-    bool     connectToAP(const char *ssid, const char *key, uint8_t secmode);
+    bool     connectToAP(const char *ssid, const char *key, uint8_t secmode, uint8_t attempts = 0);
+    bool     connectFast(const char *ssid, const char *key, uint8_t secmode, uint32_t timeout = CC3000_FAST_CONNECT_TIMEOUT,
+                         uint8_t attempts = CC3000_CONNECT_ATTEMPTS);
+    uint32_t getBootTime(void);
 #if !defined(CC3000_TINY_DRIVER) || !defined(CC3000_SECURE)
     bool     connectOpen(const char *ssid);
 #endif
 #if !defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
     bool     connectSecure(const char *ssid, const char *key, int32_t secMode);
 #endif
+    void     poll(void);
     bool     checkConnected(void);
     bool     checkDHCP(void);
     bool     getIPAddress(uint32_t *retip, uint32_t *netmask, uint32_t *gateway, uint32_t *dhcpserv, uint32_t *dnsserv);
@@ -148,6 +238,9 @@ class Adafruit_CC3000 {
 
 #if ! defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
     bool     scanSSIDs(uint32_t time);
+    bool     setScanConfig(const cc3000_scan_config_t *config);
+    bool     setScanPreset(uint8_t preset, uint16_t channelMask = CC3000_SCAN_ALL_CHANNELS);
+    void     getScanConfig(cc3000_scan_config_t *config);
 #endif
 
 /* Functions that aren't available with the tiny driver */
@@ -164,22 +257,95 @@ class Adafruit_CC3000 {
     uint16_t startSSIDscan(void);
     void     stopSSIDscan();
     uint8_t  getNextSSID(uint8_t *rssi, uint8_t *secMode, char *ssidname);
+    uint8_t  collectScanResults(cc3000_scan_entry_t *table, uint8_t size, const char *target = NULL);
+    uint8_t  readScanResults(cc3000_scan_entry_t *table, uint8_t size, const char *target = NULL, bool stopAtTarget = true);
 
     bool     listSSIDResults(void);
     bool     startSmartConfig(bool enableAES);
+    bool     smartConfigBegin(bool enableAES, uint32_t timeout = 60000, cc3000_smartconfig_callback_t progress = 0);
+    cc3000_smartconfig_state_t smartConfigRun(void);
 
     bool     getIPConfig(tNetappIpconfigRetArgs *ipConfig);
+    bool     setStaticIPAddress(uint32_t ip, uint32_t subnetMask, uint32_t defaultGateway, uint32_t dnsServer);
+    bool     setDHCP(void);
 
 
-    uint16_t ping(uint32_t ip, uint8_t attempts=3,  uint16_t timeout=500, uint8_t size=32);
+    uint16_t ping(uint32_t ip, uint8_t attempts=3,  uint16_t timeout=500, uint8_t size=32, netapp_pingreport_args_t *report=NULL);
+    bool     startPing(uint32_t ip, uint8_t attempts=3,  uint16_t timeout=500, uint8_t size=32);
+    bool     getPingReport(netapp_pingreport_args_t *report);
     uint16_t getHostByName(char *hostname, uint32_t *ip);
+    void     flushHostCache(void);
 #endif
 
     status_t getStatus(void);
     void setPrinter(Print*);
+    uint8_t  getSPIClockDivider(void);
+    uint32_t setTimeout(uint32_t ms);
+    void     setIdleHook(cc3000_idle_hook_t hook);
+    uint8_t  waitFor(uint8_t eventMask, uint32_t timeout);
+    void     clearEvents(uint8_t eventMask);
+    bool     waitSent(uint32_t timeout);
+    void     select(void);
+
+    bool     supervise(void);
+    bool     recover(void);
+    uint8_t  getFault(void);
+    void     setReplayPolicy(uint8_t policy);
+    bool     registerClient(Adafruit_CC3000_Client *client, uint32_t destIP, uint16_t destPort, bool udp = false);
+    bool     registerServer(Adafruit_CC3000_Server *server);
+    void     unregisterSocket(void *sock);
+    uint16_t getRecoveryCount(void);
+    uint32_t getLastRecoveryTime(void);
+    uint8_t  openSockets(bool listening = true);
+    void     dropSockets(void);
 
   private:
     bool _initialised;
+    tCC3000Context *_ctx;
+    uint32_t _bootStart;  // millis() when begin() was called, see getBootTime()
+    cc3000_scan_config_t _scanConfig;
+#if ! defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
+    void     loadScanConfig(void);
+#endif
+#ifndef CC3000_TINY_DRIVER
+    tNetappIpconfigRetArgs _ipConfig;  // valid while the cache is CC3000_IPCONFIG_FULL
+#endif
+
+    /* Recovery: the AP given to connectToAP() and the sockets to re-open */
+    typedef struct
+    {
+      void     *sock;
+      uint32_t ip;
+      uint16_t port;
+      uint8_t  type;  // CC3000_REPLAY_LISTEN or CC3000_REPLAY_CLIENTS
+      bool     udp;
+    } replay_t;
+
+    const char *_apSSID, *_apKey;
+    uint8_t  _apSecmode;
+    uint8_t  _replayPolicy;
+    replay_t _replay[CC3000_REPLAY_SLOTS];
+    uint32_t _lastHealthCheck;
+    uint16_t _recoveries;
+    uint32_t _lastRecoveryTime;
+
+    void     replaySockets(void);
+    void     resetState(void);
+    void     readIPConfig(tNetappIpconfigRetArgs *ipConfig, bool full);
+
+#ifndef CC3000_TINY_DRIVER
+    /* Non-blocking SmartConfig, see smartConfigBegin() */
+    cc3000_smartconfig_state_t _scState;
+    bool     _scAES;
+    uint32_t _scTimeout;
+    uint32_t _scSince, _scWait;
+    cc3000_smartconfig_callback_t _scProgress;
+
+    void     smartConfigEnter(cc3000_smartconfig_state_t state, uint32_t wait);
+#endif
+
+    bool     probeSPIClock(void);
+    void     tuneSPIClock(void);
 
 };
 
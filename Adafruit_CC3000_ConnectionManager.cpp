@@ -0,0 +1,267 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_ConnectionManager.cpp
+
+  Non-blocking connection manager for the CC3000, see
+  Adafruit_CC3000_ConnectionManager.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_ConnectionManager.h"
+
+#define LINK_EVENTS (CC3000_EVENT_CONNECTED | CC3000_EVENT_DISCONNECTED | CC3000_EVENT_DHCP)
+
+/**************************************************************************/
+/*!
+    @brief  Creates a manager for the given module
+*/
+/**************************************************************************/
+Adafruit_CC3000_ConnectionManager::Adafruit_CC3000_ConnectionManager(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _ssid(0), _key(0), _secmode(0), _maxAttempts(0),
+    _state(CC3000_LINK_IDLE), _attempts(0), _backoff(CC3000_BACKOFF_MIN),
+    _linkUp(0), _linkDown(0)
+{ }
+
+/**************************************************************************/
+/*!
+    @brief  Starts connecting to the AP, call it once after
+            Adafruit_CC3000::begin() and then call run() from loop()
+
+    @note   The strings must stay around while the manager runs
+
+    @args[in] maxAttempts
+              How many connects in a row may fail before the manager gives
+              up (CC3000_LINK_FAILED), 0 to retry forever
+
+    @returns  False if the connection policy couldn't be set
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_ConnectionManager::begin(const char *ssid, const char *key, uint8_t secmode, uint8_t maxAttempts)
+{
+  _ssid = ssid;
+  _key = key;
+  _secmode = secmode;
+  _maxAttempts = maxAttempts;
+  _attempts = 0;
+  _backoff = CC3000_BACKOFF_MIN;
+
+  // The manager does the reconnecting, the module mustn't do it on its own
+  _cc3000->select();
+  if (wlan_ioctl_set_connection_policy(0, 0, 0) != 0)
+  {
+    return false;
+  }
+
+  if (_cc3000->checkConnected())
+  {
+    _state.enter(CC3000_LINK_DHCP, CC3000_DHCP_TIMEOUT);
+  }
+  else
+  {
+    attempt();
+  }
+
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops managing the link, the connection (if any) is left up
+*/
+/**************************************************************************/
+void Adafruit_CC3000_ConnectionManager::stop(void)
+{
+  _state.enter(CC3000_LINK_IDLE, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advances the state machine, call it from loop(). It never
+            waits: each call handles the events that came in since the
+            last one and returns.
+
+    @returns  The current state
+*/
+/**************************************************************************/
+cc3000_link_state_t Adafruit_CC3000_ConnectionManager::run(void)
+{
+  if ((_state == CC3000_LINK_IDLE) || (_state == CC3000_LINK_FAILED))
+  {
+    return _state;
+  }
+
+  _cc3000->poll();
+  uint8_t events = _cc3000->waitFor(LINK_EVENTS, 0);
+  bool expired = _state.expired();
+
+  switch (_state)
+  {
+    case CC3000_LINK_CONNECTING:
+      if (_cc3000->checkConnected())
+      {
+        _state.enter(CC3000_LINK_DHCP, CC3000_DHCP_TIMEOUT);
+      }
+      else if ((events & CC3000_EVENT_DISCONNECTED) || expired)
+      {
+        retry();
+      }
+      break;
+
+    case CC3000_LINK_DHCP:
+      if (!_cc3000->checkConnected())
+      {
+        retry();
+      }
+      else if (_cc3000->checkDHCP())
+      {
+        _state.enter(CC3000_LINK_UP, 0);
+        _attempts = 0;
+        _backoff = CC3000_BACKOFF_MIN;
+        if (_linkUp)
+        {
+          _linkUp();
+        }
+      }
+      else if (expired)
+      {
+        // Associated but no address, start over
+        _cc3000->disconnect();
+        retry();
+      }
+      break;
+
+    case CC3000_LINK_UP:
+      if ((events & CC3000_EVENT_DISCONNECTED) || !_cc3000->checkConnected())
+      {
+        linkDown();
+        // The first reconnect goes out right away, backoff only on failures
+        attempt();
+      }
+      break;
+
+    case CC3000_LINK_BACKOFF:
+      if (expired)
+      {
+        attempt();
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return _state;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Link state accessors
+*/
+/**************************************************************************/
+cc3000_link_state_t Adafruit_CC3000_ConnectionManager::getState(void)
+{
+  return _state;
+}
+
+bool Adafruit_CC3000_ConnectionManager::isUp(void)
+{
+  return _state == CC3000_LINK_UP;
+}
+
+uint8_t Adafruit_CC3000_ConnectionManager::getAttempts(void)
+{
+  return _attempts;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the functions run() calls when the link comes up (with an
+            address) and when it goes down
+*/
+/**************************************************************************/
+void Adafruit_CC3000_ConnectionManager::onLinkUp(cc3000_link_callback_t callback)
+{
+  _linkUp = callback;
+}
+
+void Adafruit_CC3000_ConnectionManager::onLinkDown(cc3000_link_callback_t callback)
+{
+  _linkDown = callback;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends one connect request. It only queues the connect on the
+            module; the result comes in as an event that run() picks up.
+*/
+/**************************************************************************/
+void Adafruit_CC3000_ConnectionManager::attempt(void)
+{
+  long ret;
+
+  _attempts++;
+  _cc3000->clearEvents(LINK_EVENTS);
+
+  _cc3000->select();
+#if ! defined(CC3000_TINY_DRIVER) || defined(CC3000_SECURE)
+  if ((_secmode == 0) || (strlen(_key) == 0))
+  {
+    ret = wlan_connect(WLAN_SEC_UNSEC, _ssid, strlen(_ssid), NULL, NULL, 0);
+  }
+  else
+  {
+    ret = wlan_connect(_secmode, _ssid, strlen(_ssid), NULL,
+                       (unsigned char *)_key, strlen(_key));
+  }
+#else
+  ret = wlan_connect(_ssid, strlen(_ssid));
+#endif
+
+  if (ret != 0)
+  {
+    retry();
+    return;
+  }
+
+  _state.enter(CC3000_LINK_CONNECTING, WLAN_CONNECT_TIMEOUT);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Schedules the next connect after a failed one. The delay is
+            drawn from the upper half of the current backoff, which then
+            doubles up to CC3000_BACKOFF_MAX, so a room full of boards
+            doesn't retry in lockstep.
+*/
+/**************************************************************************/
+void Adafruit_CC3000_ConnectionManager::retry(void)
+{
+  if (_maxAttempts && (_attempts >= _maxAttempts))
+  {
+    _state.enter(CC3000_LINK_FAILED, 0);
+    return;
+  }
+
+  _state.enter(CC3000_LINK_BACKOFF, _backoff / 2 + random(_backoff / 2 + 1));
+
+  _backoff *= 2;
+  if (_backoff > CC3000_BACKOFF_MAX)
+  {
+    _backoff = CC3000_BACKOFF_MAX;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  The link dropped: the open sockets are marked closed (their
+            connections are gone with it) and the sketch is told
+*/
+/**************************************************************************/
+void Adafruit_CC3000_ConnectionManager::linkDown(void)
+{
+  _cc3000->dropSockets();
+
+  if (_linkDown)
+  {
+    _linkDown();
+  }
+}
@@ -0,0 +1,79 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_ConnectionManager.h
+
+  Non-blocking connection manager for the CC3000.
+
+  Instead of connectToAP(), which blocks until it is connected, call
+  begin() once and run() from loop(). The manager follows the link through
+  the unsolicited connect, disconnect and DHCP events, and when the link
+  fails or drops it retries with a jittered exponential backoff. While it
+  waits the sketch keeps running.
+
+  When the link goes down the sockets that were open are marked closed, so
+  Adafruit_CC3000_Client::connected() returns false for them.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_CONNECTIONMANAGER_H
+#define ADAFRUIT_CC3000_CONNECTIONMANAGER_H
+
+#include "Adafruit_CC3000.h"
+#include "utility/cc3000_state.h"
+
+#ifndef CC3000_BACKOFF_MIN
+#define CC3000_BACKOFF_MIN     1000  // backoff before the first retry, in milliseconds
+#endif
+#ifndef CC3000_BACKOFF_MAX
+#define CC3000_BACKOFF_MAX    60000  // longest backoff, in milliseconds
+#endif
+#ifndef CC3000_DHCP_TIMEOUT
+#define CC3000_DHCP_TIMEOUT   15000  // how long to wait for an address after connecting, in milliseconds
+#endif
+
+typedef enum
+{
+  CC3000_LINK_IDLE,        // stopped, begin() wasn't called
+  CC3000_LINK_CONNECTING,  // waiting for the AP to accept us
+  CC3000_LINK_DHCP,        // associated, waiting for an address
+  CC3000_LINK_UP,
+  CC3000_LINK_BACKOFF,     // waiting to retry
+  CC3000_LINK_FAILED       // gave up after maxAttempts
+} cc3000_link_state_t;
+
+typedef void (*cc3000_link_callback_t)(void);
+
+class Adafruit_CC3000_ConnectionManager {
+  public:
+    Adafruit_CC3000_ConnectionManager(Adafruit_CC3000 &cc3000);
+
+    bool     begin(const char *ssid, const char *key, uint8_t secmode, uint8_t maxAttempts = 0);
+    void     stop(void);
+    cc3000_link_state_t run(void);
+
+    cc3000_link_state_t getState(void);
+    bool     isUp(void);
+    uint8_t  getAttempts(void);
+
+    void     onLinkUp(cc3000_link_callback_t callback);
+    void     onLinkDown(cc3000_link_callback_t callback);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+
+    const char *_ssid, *_key;
+    uint8_t  _secmode;
+    uint8_t  _maxAttempts;  // 0 retries forever
+
+    cc3000_state<cc3000_link_state_t> _state;
+    uint8_t  _attempts;     // since the link was last up
+    uint32_t _backoff;      // upper bound of the next backoff
+
+    cc3000_link_callback_t _linkUp, _linkDown;
+
+    void     attempt(void);
+    void     retry(void);
+    void     linkDown(void);
+};
+
+#endif
@@ -0,0 +1,240 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_DutyCycle.cpp
+
+  Duty-cycled radio for battery powered telemetry nodes, see
+  Adafruit_CC3000_DutyCycle.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_DutyCycle.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates a scheduler for the given module. Don't call the
+            module's begin(), the first wake does.
+*/
+/**************************************************************************/
+Adafruit_CC3000_DutyCycle::Adafruit_CC3000_DutyCycle(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _ssid(0), _key(0), _secmode(0), _destIP(0),
+    _destPort(0), _period(0), _threshold(CC3000_DUTY_BUFFER_SIZE),
+    _begun(false), _lastWake(0), _backoff(false), _used(0), _wakes(0), _failedWakes(0),
+    _radioOnTime(0), _lastWakeTime(0), _bytesSent(0), _lastWakeBytes(0)
+{ }
+
+/**************************************************************************/
+/*!
+    @brief  Sets up the schedule
+
+    @note   The strings must stay around while the scheduler runs
+
+    @args[in] period
+              Time between wakes in milliseconds, counted from the start of
+              the last wake. Nothing happens while the queue is empty.
+    @args[in] threshold
+              Wake early once this many bytes are queued
+*/
+/**************************************************************************/
+void Adafruit_CC3000_DutyCycle::begin(const char *ssid, const char *key, uint8_t secmode,
+                                      uint32_t destIP, uint16_t destPort,
+                                      uint32_t period, uint16_t threshold)
+{
+  _ssid = ssid;
+  _key = key;
+  _secmode = secmode;
+  _destIP = destIP;
+  _destPort = destPort;
+  _period = period;
+  _threshold = threshold;
+  _lastWake = millis();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Queues a payload for the next wake
+
+    @returns  False if it doesn't fit (nothing is queued then)
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_DutyCycle::queue(const void *data, uint16_t len)
+{
+  if (len > CC3000_DUTY_BUFFER_SIZE - _used)
+  {
+    return false;
+  }
+
+  memcpy(_buf + _used, data, len);
+  _used += len;
+  return true;
+}
+
+uint16_t Adafruit_CC3000_DutyCycle::queued(void)
+{
+  return _used;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Call from loop(): wakes the radio when the period is over or
+            the threshold is reached, and there is something to send.
+            After a failed wake only the period counts.
+
+    @returns  True if a wake ran and the queue was sent
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_DutyCycle::run(void)
+{
+  if ((_used == 0) ||
+      (((_used < _threshold) || _backoff) && (millis() - _lastWake < _period)))
+  {
+    return false;
+  }
+
+  return wake();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs a wake now: power up, connect, send the queue in one
+            burst, power down. Getting on the network may take up to
+            CC3000_DUTY_WAKE_TIMEOUT, if the AP isn't there the module
+            goes back to sleep after that.
+
+    @returns  True if the whole queue was sent
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_DutyCycle::wake(void)
+{
+  uint16_t sent = 0;
+  uint32_t elapsed;
+  bool up;
+
+  _lastWake = millis();
+
+  // The first wake sets the module up, later ones only power it
+  if (!_begun)
+  {
+    up = _begun = _cc3000->begin(0, false, true);
+  }
+  else
+  {
+    up = _cc3000->start();
+  }
+
+  if (up && _cc3000->connectFast(_ssid, _key, _secmode, CC3000_FAST_CONNECT_TIMEOUT,
+                                  CC3000_DUTY_CONNECT_ATTEMPTS))
+  {
+    // Whatever is left of the deadline goes to DHCP
+    elapsed = millis() - _lastWake;
+    if (_cc3000->checkDHCP() ||
+        ((elapsed < CC3000_DUTY_WAKE_TIMEOUT) &&
+         _cc3000->waitFor(CC3000_EVENT_DHCP, CC3000_DUTY_WAKE_TIMEOUT - elapsed)))
+    {
+      sent = flush();
+    }
+  }
+
+  _cc3000->stop();
+
+  _wakes++;
+  _backoff = (sent < _used);
+  if (_backoff)
+  {
+    _failedWakes++;
+  }
+
+  // Keep what didn't make it for the next wake
+  memmove(_buf, _buf + sent, _used - sent);
+  _used -= sent;
+
+  _lastWakeTime = millis() - _lastWake;
+  _radioOnTime += _lastWakeTime;
+  _lastWakeBytes = sent;
+  _bytesSent += sent;
+
+  return _used == 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends the queue over one connection, in TX buffer sized
+            pieces, and waits for the module to put them on the air
+            before closing it
+
+    @returns  The number of bytes sent, 0 if the module still held some
+              of them after CC3000_DUTY_SEND_TIMEOUT (the next wake sends
+              them all again)
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_DutyCycle::flush(void)
+{
+  uint16_t sent = 0;
+
+  Adafruit_CC3000_Client client = _cc3000->connectTCP(_destIP, _destPort);
+  if (!client.connected())
+  {
+    return 0;
+  }
+
+  while (sent < _used)
+  {
+    uint16_t len = _used - sent;
+    if (len > CC3000_DUTY_CHUNK)
+    {
+      len = CC3000_DUTY_CHUNK;
+    }
+
+    int16_t ret = client.write(_buf + sent, len);
+    if (ret <= 0)
+    {
+      break;
+    }
+    sent += ret;
+  }
+
+  // Closing and powering down drop whatever the module still holds
+  if (!_cc3000->waitSent(CC3000_DUTY_SEND_TIMEOUT))
+  {
+    sent = 0;
+  }
+
+  client.close();
+  return sent;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Energy-proxy metrics: the number of wakes (and of wakes that
+            didn't send everything), the radio-on time in milliseconds in
+            total and of the last wake, and the bytes sent in total and
+            in the last wake
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_DutyCycle::getWakes(void)
+{
+  return _wakes;
+}
+
+uint16_t Adafruit_CC3000_DutyCycle::getFailedWakes(void)
+{
+  return _failedWakes;
+}
+
+uint32_t Adafruit_CC3000_DutyCycle::getRadioOnTime(void)
+{
+  return _radioOnTime;
+}
+
+uint32_t Adafruit_CC3000_DutyCycle::getLastWakeTime(void)
+{
+  return _lastWakeTime;
+}
+
+uint32_t Adafruit_CC3000_DutyCycle::getBytesSent(void)
+{
+  return _bytesSent;
+}
+
+uint16_t Adafruit_CC3000_DutyCycle::getLastWakeBytes(void)
+{
+  return _lastWakeBytes;
+}
@@ -0,0 +1,93 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_DutyCycle.h
+
+  Duty-cycled radio for battery powered telemetry nodes.
+
+  The module stays powered down (VBAT off) while the sketch queues its
+  payloads. run() wakes it every period, or as soon as threshold bytes are
+  queued, and does the whole burst in one go: power up, rejoin the AP on
+  the fast-boot path, open one TCP connection, send everything queued,
+  close and power down again. Payloads only leave the queue once the
+  module has released every packet it was given; the ones that couldn't
+  be sent, or were still held after CC3000_DUTY_SEND_TIMEOUT, stay queued
+  for the next wake. A wake that doesn't get on the network within
+  CC3000_DUTY_WAKE_TIMEOUT powers down again, and the next one waits out
+  the full period even if the threshold is reached.
+
+  Energy is proportional to radio-on time, so that is what the metrics
+  report, along with the bytes sent per wake.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_DUTYCYCLE_H
+#define ADAFRUIT_CC3000_DUTYCYCLE_H
+
+#include "Adafruit_CC3000.h"
+#include "utility/hci.h"
+
+#ifndef CC3000_DUTY_BUFFER_SIZE
+#define CC3000_DUTY_BUFFER_SIZE  256    // bytes of payload queued while the radio is off
+#endif
+#ifndef CC3000_DUTY_WAKE_TIMEOUT
+#define CC3000_DUTY_WAKE_TIMEOUT 30000  // how long a wake may take to join the AP and get an address, in milliseconds
+#endif
+#ifndef CC3000_DUTY_SEND_TIMEOUT
+#define CC3000_DUTY_SEND_TIMEOUT 5000   // how long a wake waits for the module to get the queue on the air, in milliseconds
+#endif
+#ifndef CC3000_DUTY_CONNECT_ATTEMPTS
+#define CC3000_DUTY_CONNECT_ATTEMPTS 1  // scan and connect rounds when the AP isn't rejoined by itself
+#endif
+
+// Largest send() that fits the TX buffer: the SPI and HCI data headers, the
+// 16 bytes of send arguments and the overrun guard byte come off it
+#define CC3000_DUTY_CHUNK  (CC3000_TX_BUFFER_SIZE - SPI_HEADER_SIZE - \
+                            SIMPLE_LINK_HCI_DATA_HEADER_SIZE - 16 - 1)
+
+class Adafruit_CC3000_DutyCycle {
+  public:
+    Adafruit_CC3000_DutyCycle(Adafruit_CC3000 &cc3000);
+
+    void     begin(const char *ssid, const char *key, uint8_t secmode,
+                   uint32_t destIP, uint16_t destPort,
+                   uint32_t period, uint16_t threshold = CC3000_DUTY_BUFFER_SIZE);
+
+    bool     queue(const void *data, uint16_t len);
+    uint16_t queued(void);
+
+    bool     run(void);
+    bool     wake(void);
+
+    uint16_t getWakes(void);
+    uint16_t getFailedWakes(void);
+    uint32_t getRadioOnTime(void);
+    uint32_t getLastWakeTime(void);
+    uint32_t getBytesSent(void);
+    uint16_t getLastWakeBytes(void);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+
+    const char *_ssid, *_key;
+    uint8_t  _secmode;
+    uint32_t _destIP;
+    uint16_t _destPort;
+    uint32_t _period;
+    uint16_t _threshold;
+
+    bool     _begun;        // begin() ran, later wakes use start()
+    uint32_t _lastWake;     // millis() at the start of the last wake
+    bool     _backoff;      // the last wake failed, wait the full period
+
+    uint8_t  _buf[CC3000_DUTY_BUFFER_SIZE];
+    uint16_t _used;
+
+    uint16_t _wakes, _failedWakes;
+    uint32_t _radioOnTime, _lastWakeTime;
+    uint32_t _bytesSent;
+    uint16_t _lastWakeBytes;
+
+    uint16_t flush(void);
+};
+
+#endif
@@ -0,0 +1,999 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_HTTP.cpp
+
+  HTTP/1.1 client with persistent connections, see Adafruit_CC3000_HTTP.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_HTTP.h"
+#include <ctype.h>
+
+#ifndef CC3000_TINY_DRIVER
+
+/* Returns the value of a header line if it's the named header, else NULL */
+static const char *headerValue(const char *line, const char *name)
+{
+  uint8_t len = strlen(name);
+
+  if ((strncasecmp(line, name, len) != 0) || (line[len] != ':'))
+  {
+    return NULL;
+  }
+
+  line += len + 1;
+  while ((*line == ' ') || (*line == '\t'))
+  {
+    line++;
+  }
+  return line;
+}
+
+/* Whether a header value ends with the given token, e.g. "gzip, chunked" */
+static bool endsWithToken(const char *value, const char *token)
+{
+  uint8_t len = strlen(value), tokenLen = strlen(token);
+
+  while ((len > 0) && ((value[len - 1] == ' ') || (value[len - 1] == '\t')))
+  {
+    len--;
+  }
+  return (len >= tokenLen) && (strncasecmp(value + len - tokenLen, token, tokenLen) == 0) &&
+         ((len == tokenLen) || (value[len - tokenLen - 1] == ' ') ||
+          (value[len - tokenLen - 1] == ','));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Creates a client for the given module, begin() sets the server
+*/
+/**************************************************************************/
+Adafruit_CC3000_HTTP::Adafruit_CC3000_HTTP(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _pool(NULL), _conn(&_client), _ip(0), _port(80), _host(NULL), _timeout(CC3000_HTTP_TIMEOUT),
+    _captureName(NULL), _captureValue(NULL), _captureSize(0),
+    _inBody(false), _chunked(false), _afterChunk(false), _untilClose(false), _keepAlive(false),
+    _remaining(0), _contentLength(-1), _connects(0), _outLen(0), _outFailed(false),
+    _producer(NULL), _stream(NULL), _upRemaining(0), _upChunked(false), _upStarted(false),
+    _upEnded(false), _upDone(false)
+{
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the server the requests go to, closing the connection to
+            the last one
+
+    @args[in] host
+              Sent in the Host header, has to stay valid while the client
+              is used
+*/
+/**************************************************************************/
+void Adafruit_CC3000_HTTP::begin(uint32_t ip, uint16_t port, const char *host)
+{
+  if (_inBody && !drain())
+  {
+    stop();
+  }
+  if (_conn != &_client)
+  {
+    // Kept for when we come back to this server
+    _pool->release(_conn);
+    _conn = &_client;
+  }
+  stop();
+  _ip = ip;
+  _port = port;
+  _host = host;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets how long the server may be silent while a response is
+            read, CC3000_HTTP_TIMEOUT by default
+*/
+/**************************************************************************/
+void Adafruit_CC3000_HTTP::setTimeout(uint32_t ms)
+{
+  _timeout = ms;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Takes the connections from the pool from now on, NULL to open
+            them directly again
+*/
+/**************************************************************************/
+void Adafruit_CC3000_HTTP::usePool(Adafruit_CC3000_Pool *pool)
+{
+  stop();
+  _pool = pool;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Keeps the value of one response header (e.g. "Location"), cut
+            off to size - 1 characters. The value is empty when the
+            response doesn't have the header.
+*/
+/**************************************************************************/
+void Adafruit_CC3000_HTTP::captureHeader(const char *name, char *value, uint8_t size)
+{
+  _captureName = name;
+  _captureValue = value;
+  _captureSize = size;
+  if (size > 0)
+  {
+    value[0] = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Closes the connection, the next request opens a new one
+*/
+/**************************************************************************/
+void Adafruit_CC3000_HTTP::stop(void)
+{
+  if (_conn != &_client)
+  {
+    _pool->release(_conn, false);
+    _conn = &_client;
+  }
+  // connected() tidies up after a socket the server closed
+  else if (_client.connected())
+  {
+    _client.close();
+  }
+  _client.bufsiz = 0;
+  _client._rx_buf_idx = 0;
+  _inBody = false;
+}
+
+int16_t Adafruit_CC3000_HTTP::get(const char *path, cc3000_http_body_callback_t body)
+{
+  return request("GET", path, NULL, NULL, 0, body);
+}
+
+int16_t Adafruit_CC3000_HTTP::post(const char *path, const char *contentType,
+                                   const void *data, uint16_t len, cc3000_http_body_callback_t body)
+{
+  return request("POST", path, contentType, data, len, body);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends a request and reads the response head
+
+    @args[in] contentType
+              Content type of the request body, NULL without a body
+    @args[in] body
+              Gets the response body before request() returns. Without
+              it the body is left for read().
+
+    @returns  The status code, or one of the CC3000_HTTP_ERR results
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_HTTP::request(const char *method, const char *path, const char *contentType,
+                                      const void *data, uint16_t len, cc3000_http_body_callback_t body)
+{
+  _producer = NULL;
+  _stream = NULL;
+  return exchange(method, path, contentType, data, len, body);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends a request with a body from a producer, and reads the
+            response head as request() does
+
+    @args[in] length
+              The Content-Length, -1 to send the body chunked
+
+    @returns  The status code, CC3000_HTTP_ERR_BODY if the producer
+              ended before length, or one of the other CC3000_HTTP_ERR
+              results
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_HTTP::upload(const char *method, const char *path, const char *contentType,
+                                     cc3000_http_producer_t producer, int32_t length,
+                                     cc3000_http_body_callback_t body)
+{
+  _producer = producer;
+  _stream = NULL;
+  return exchange(method, path, contentType, NULL, length, body);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends a request with a body read from a stream, e.g. a File.
+            The body ends when the stream has nothing available.
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_HTTP::upload(const char *method, const char *path, const char *contentType,
+                                     Stream &stream, int32_t length, cc3000_http_body_callback_t body)
+{
+  _producer = NULL;
+  _stream = &stream;
+  return exchange(method, path, contentType, NULL, length, body);
+}
+
+/* Sends the request (the body from data, or from the producer or stream
+   of an upload), reads the response head and hands on the body */
+int16_t Adafruit_CC3000_HTTP::exchange(const char *method, const char *path, const char *contentType,
+                                       const void *data, int32_t len, cc3000_http_body_callback_t body)
+{
+  // The rest of the last body stands between us and the next response
+  if (_inBody && !drain())
+  {
+    stop();
+  }
+
+  for (uint8_t attempt = 0; attempt < 2; attempt++)
+  {
+    bool reused = _conn->connected();
+    bool nothing;
+    int16_t status;
+
+    if (!reused && !connect(&reused))
+    {
+      return CC3000_HTTP_ERR_CONNECT;
+    }
+
+    _upStarted = false;
+    if (!sendRequest(method, path, contentType, data, len))
+    {
+      stop();
+      if (reused && !_upStarted)
+      {
+        continue;
+      }
+      return (_upDone && !_outFailed) ? CC3000_HTTP_ERR_BODY : CC3000_HTTP_ERR_SEND;
+    }
+
+    status = readHead(strcmp(method, "HEAD") == 0, &nothing);
+    if (status < 0)
+    {
+      stop();
+      // The server closed the kept connection before it saw the request,
+      // so it's safe to send it again (unless it was streamed)
+      if (reused && nothing && !_upStarted)
+      {
+        continue;
+      }
+      return status;
+    }
+
+    if (body)
+    {
+      const uint8_t *slice;
+      int16_t n;
+
+      while ((n = nextSlice(&slice, 0xFFFF)) > 0)
+      {
+        if (!body(slice, n))
+        {
+          stop();
+          return CC3000_HTTP_ERR_ABORTED;
+        }
+      }
+      if (n < 0)
+      {
+        stop();
+        return n;
+      }
+    }
+
+    return status;
+  }
+
+  return CC3000_HTTP_ERR_SEND;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the body of the last response, with the chunk framing
+            removed
+
+    @returns  Up to len bytes, as many as have arrived (waiting for one at
+              least), 0 at the end of the body, or CC3000_HTTP_ERR_TIMEOUT
+              (the connection is closed then)
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_HTTP::read(void *buf, uint16_t len)
+{
+  const uint8_t *slice;
+  int16_t n = nextSlice(&slice, len);
+
+  if (n > 0)
+  {
+    memcpy(buf, slice, n);
+  }
+  else if (n < 0)
+  {
+    stop();
+  }
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Response accessors: whether the body was read to the end, its
+            Content-Length (-1 when it has none) and whether it's chunked
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_HTTP::bodyDone(void)
+{
+  return !_inBody;
+}
+
+int32_t Adafruit_CC3000_HTTP::getContentLength(void)
+{
+  return _contentLength;
+}
+
+bool Adafruit_CC3000_HTTP::isChunked(void)
+{
+  return _chunked;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Returns how many connections were opened, to see whether they
+            are kept
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_HTTP::getConnects(void)
+{
+  return _connects;
+}
+
+/* Opens a connection, or takes an idle one from the pool (reused then) */
+bool Adafruit_CC3000_HTTP::connect(bool *reused)
+{
+  stop();
+  *reused = false;
+  if ((_ip == 0) || (_host == NULL))
+  {
+    return false;
+  }
+
+  if (_pool)
+  {
+    Adafruit_CC3000_Client *pooled = _pool->acquire(_ip, _port, reused);
+    if (pooled == NULL)
+    {
+      return false;
+    }
+    _conn = pooled;
+  }
+  else
+  {
+    _client = _cc3000->connectTCP(_ip, _port);
+    _client.bufsiz = 0;
+    _client._rx_buf_idx = 0;
+    if (!_client.connected())
+    {
+      return false;
+    }
+  }
+
+  if (!*reused)
+  {
+    _connects++;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends the request line, the headers and the body, packed into
+            sends of CC3000_HTTP_CHUNK
+
+    @args[in] len
+              Of the body, -1 for an upload sent chunked
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_HTTP::sendRequest(const char *method, const char *path, const char *contentType,
+                                       const void *data, int32_t len)
+{
+  bool streamed = (_producer != NULL) || (_stream != NULL);
+
+  _outLen = 0;
+  _outFailed = false;
+
+  put(method);
+  put(F(" "));
+  put(path);
+  put(F(" HTTP/1.1\r\nHost: "));
+  put(_host);
+  put(F("\r\n"));
+
+  if (contentType)
+  {
+    put(F("Content-Type: "));
+    put(contentType);
+    put(F("\r\n"));
+  }
+  if (len < 0)
+  {
+    put(F("Transfer-Encoding: chunked\r\n"));
+  }
+  else if (contentType || streamed)
+  {
+    char number[11];
+    uint8_t pos = sizeof(number) - 1;
+    uint32_t rest = len;
+
+    number[pos] = 0;
+    do
+    {
+      number[--pos] = '0' + rest % 10;
+      rest /= 10;
+    } while (rest);
+
+    put(F("Content-Length: "));
+    put(number + pos);
+    put(F("\r\n"));
+  }
+  put(F("\r\n"));
+
+  if (streamed)
+  {
+    // The rest of the head goes in the first frame of the body
+    _upChunked = (len < 0);
+    _upRemaining = _upChunked ? 0 : len;
+    return !_outFailed && sendBody();
+  }
+
+  if (len > 0)
+  {
+    put(data, len);
+  }
+  return flush();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends the body of an upload, each frame filled by fillFrame()
+            in the driver's TX buffer
+
+    @returns  False if a send failed, or the producer ended before the
+              Content-Length (_upDone is set then)
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_HTTP::sendBody(void)
+{
+  _upEnded = false;
+  _upDone = false;
+
+  while (!_upDone || (_outLen > 0))
+  {
+    if (_conn->writeFill(fill, this, CC3000_HTTP_CHUNK) < 0)
+    {
+      _outFailed = true;
+      return false;
+    }
+  }
+  return !_upEnded || _upChunked;
+}
+
+long Adafruit_CC3000_HTTP::fill(unsigned char *buf, long len, void *arg)
+{
+  return ((Adafruit_CC3000_HTTP *)arg)->fillFrame(buf, len);
+}
+
+// Hex digits of the chunk sizes, padded to fit the largest frame
+#define CHUNK_DIGITS  ((CC3000_HTTP_CHUNK < 0x100) ? 2 : ((CC3000_HTTP_CHUNK < 0x1000) ? 3 : 4))
+
+/**************************************************************************/
+/*!
+    @brief  Fills one frame: the rest of the request head, then as much of
+            the body as fits, framed as one chunk when it's chunked. The
+            last chunk goes in as soon as the producer ends and there's
+            room for it.
+
+    @returns  The frame length
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_HTTP::fillFrame(uint8_t *frame, uint16_t len)
+{
+  uint16_t pos = 0;
+
+  if (_outLen > 0)
+  {
+    memcpy(frame, _out, _outLen);
+    pos = _outLen;
+    _outLen = 0;
+  }
+
+  if (_upDone)
+  {
+    return pos;
+  }
+
+  if (_upChunked)
+  {
+    // Chunks while there's room for a size line, some data and its CRLF
+    while (!_upEnded && (len - pos > CHUNK_DIGITS + 4))
+    {
+      uint16_t n = produce(frame + pos + CHUNK_DIGITS + 2, len - pos - CHUNK_DIGITS - 4);
+
+      if (n == 0)
+      {
+        _upEnded = true;
+        break;
+      }
+
+      for (int8_t i = CHUNK_DIGITS - 1; i >= 0; i--)
+      {
+        frame[pos + i] = "0123456789abcdef"[(n >> (4 * (CHUNK_DIGITS - 1 - i))) & 0x0F];
+      }
+      pos += CHUNK_DIGITS;
+      frame[pos++] = '\r';
+      frame[pos++] = '\n';
+      pos += n;
+      frame[pos++] = '\r';
+      frame[pos++] = '\n';
+    }
+
+    if (_upEnded && (len - pos >= 5))
+    {
+      memcpy(frame + pos, "0\r\n\r\n", 5);
+      pos += 5;
+      _upDone = true;
+    }
+  }
+  else
+  {
+    while ((pos < len) && (_upRemaining > 0))
+    {
+      uint16_t room = len - pos;
+      uint16_t n;
+
+      if (room > _upRemaining)
+      {
+        room = _upRemaining;
+      }
+      n = produce(frame + pos, room);
+
+      // Ended short of the Content-Length, the request can't be finished
+      if (n == 0)
+      {
+        _upEnded = true;
+        break;
+      }
+      pos += n;
+      _upRemaining -= n;
+    }
+    _upDone = _upEnded || (_upRemaining == 0);
+  }
+
+  return pos;
+}
+
+/* Takes up to len bytes of the body from the producer or the stream */
+uint16_t Adafruit_CC3000_HTTP::produce(uint8_t *buf, uint16_t len)
+{
+  uint16_t n;
+
+  if (_producer)
+  {
+    n = _producer(buf, len);
+  }
+  else
+  {
+    int available = _stream->available();
+
+    n = 0;
+    if (available > 0)
+    {
+      n = _stream->readBytes((char *)buf, ((uint16_t)available < len) ? available : len);
+    }
+  }
+
+  if (n > len)
+  {
+    n = len;
+  }
+  if (n > 0)
+  {
+    _upStarted = true;
+  }
+  return n;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the status line and the headers, skipping interim
+            (1xx) responses, and sets up reading the body
+
+    @args[in] nothing
+              Set when not a single byte came back
+
+    @returns  The status code, or one of the CC3000_HTTP_ERR results
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_HTTP::readHead(bool head, bool *nothing)
+{
+  char line[CC3000_HTTP_LINE_SIZE];
+  int16_t status;
+
+  *nothing = true;
+  if (!waitData())
+  {
+    return CC3000_HTTP_ERR_TIMEOUT;
+  }
+  *nothing = false;
+
+  do
+  {
+    if (!readLine(line, sizeof(line)))
+    {
+      return CC3000_HTTP_ERR_TIMEOUT;
+    }
+    if ((strncmp(line, "HTTP/1.", 7) != 0) || (line[8] != ' ') ||
+        (line[9] < '1') || (line[9] > '9'))
+    {
+      return CC3000_HTTP_ERR_RESPONSE;
+    }
+
+    status = atoi(line + 9);
+    _keepAlive = (line[7] != '0');  // HTTP/1.0 closes unless asked not to
+    _chunked = false;
+    _contentLength = -1;
+    if (_captureSize > 0)
+    {
+      _captureValue[0] = 0;
+    }
+
+    while (true)
+    {
+      const char *value;
+
+      if (!readLine(line, sizeof(line)))
+      {
+        return CC3000_HTTP_ERR_TIMEOUT;
+      }
+      if (line[0] == 0)
+      {
+        break;
+      }
+
+      if ((value = headerValue(line, "Content-Length")) != NULL)
+      {
+        _contentLength = strtoul(value, NULL, 10);
+      }
+      else if ((value = headerValue(line, "Transfer-Encoding")) != NULL)
+      {
+        _chunked = endsWithToken(value, "chunked");
+      }
+      else if ((value = headerValue(line, "Connection")) != NULL)
+      {
+        if (strncasecmp(value, "close", 5) == 0)
+        {
+          _keepAlive = false;
+        }
+        else if (strncasecmp(value, "keep-alive", 10) == 0)
+        {
+          _keepAlive = true;
+        }
+      }
+
+      if (_captureName && (value = headerValue(line, _captureName)) != NULL)
+      {
+        strncpy(_captureValue, value, _captureSize - 1);
+        _captureValue[_captureSize - 1] = 0;
+      }
+    }
+  } while (status < 200);
+
+  _inBody = true;
+  _afterChunk = false;
+  _untilClose = false;
+  _remaining = 0;
+  if (head || (status == 204) || (status == 304))
+  {
+    _inBody = false;
+  }
+  else if (_chunked)
+  {
+    // Chunked wins over Content-Length
+    _contentLength = -1;
+  }
+  else if (_contentLength >= 0)
+  {
+    _remaining = _contentLength;
+    _inBody = (_remaining > 0);
+  }
+  else
+  {
+    _untilClose = true;
+    _keepAlive = false;
+  }
+
+  if (!_inBody)
+  {
+    endBody();
+  }
+  return status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the size line of the next chunk (after the CRLF that
+            ends the last one), or the trailers after the last chunk
+
+    @returns  False if the framing is broken or the server went silent
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_HTTP::nextChunk(void)
+{
+  char line[CC3000_HTTP_LINE_SIZE];
+
+  if (_afterChunk && (!readLine(line, sizeof(line)) || line[0]))
+  {
+    return false;
+  }
+  _afterChunk = true;
+
+  // The size may be followed by ";" and extensions
+  if (!readLine(line, sizeof(line)) || !isxdigit(line[0]))
+  {
+    return false;
+  }
+  _remaining = strtoul(line, NULL, 16);
+
+  if (_remaining == 0)
+  {
+    do
+    {
+      if (!readLine(line, sizeof(line)))
+      {
+        return false;
+      }
+    } while (line[0]);
+    endBody();
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Takes the next piece of the body straight out of the client's
+            RX buffer, without copying it
+
+    @returns  The length of the piece (at most max), 0 at the end of the
+              body, or CC3000_HTTP_ERR_TIMEOUT
+*/
+/**************************************************************************/
+int16_t Adafruit_CC3000_HTTP::nextSlice(const uint8_t **data, uint16_t max)
+{
+  uint16_t n;
+
+  if (!_inBody)
+  {
+    return 0;
+  }
+
+  if (_chunked && (_remaining == 0))
+  {
+    if (!nextChunk())
+    {
+      return CC3000_HTTP_ERR_TIMEOUT;
+    }
+    if (!_inBody)
+    {
+      return 0;
+    }
+  }
+
+  if (!waitData())
+  {
+    // Closing the connection ends a body without a length
+    if (_untilClose && !_conn->connected())
+    {
+      endBody();
+      return 0;
+    }
+    return CC3000_HTTP_ERR_TIMEOUT;
+  }
+
+  n = _conn->bufsiz - _conn->_rx_buf_idx;
+  if (n > max)
+  {
+    n = max;
+  }
+  if (!_untilClose && (n > _remaining))
+  {
+    n = _remaining;
+  }
+
+  *data = _conn->_rx_buf + _conn->_rx_buf_idx;
+  _conn->_rx_buf_idx += n;
+
+  if (!_untilClose)
+  {
+    _remaining -= n;
+    if ((_remaining == 0) && !_chunked)
+    {
+      endBody();
+    }
+  }
+  return n;
+}
+
+/* The response is over: keep the connection for the next one, or close it */
+void Adafruit_CC3000_HTTP::endBody(void)
+{
+  _inBody = false;
+  if (!_keepAlive)
+  {
+    stop();
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Skips the unread rest of the body, if it's short enough to be
+            worth it for keeping the connection
+
+    @returns  True if the connection can take the next request
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_HTTP::drain(void)
+{
+  uint16_t skipped = 0;
+  const uint8_t *slice;
+  int16_t n;
+
+  if (_untilClose || (!_chunked && (_remaining > CC3000_HTTP_DRAIN_MAX)))
+  {
+    return false;
+  }
+
+  while ((n = nextSlice(&slice, CC3000_HTTP_DRAIN_MAX)) > 0)
+  {
+    skipped += n;
+    if (skipped > CC3000_HTTP_DRAIN_MAX)
+    {
+      return false;
+    }
+  }
+  return (n == 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Waits until the client's RX buffer has unread bytes, filling
+            it with one recv()
+
+    @returns  False when the server closed the connection or was silent
+              for the timeout
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_HTTP::waitData(void)
+{
+  uint32_t start = millis();
+
+  while (true)
+  {
+    if ((_conn->bufsiz > 0) && (_conn->_rx_buf_idx < _conn->bufsiz))
+    {
+      return true;
+    }
+
+    // Unlike the client's read(), a recv() that finds the socket closed
+    // ends the wait instead of blocking for more
+    if (_conn->available())
+    {
+      int16_t n = _conn->read(_conn->_rx_buf, sizeof(_conn->_rx_buf));
+
+      _conn->_rx_buf_idx = 0;
+      if (n <= 0)
+      {
+        _conn->bufsiz = 0;
+        _conn->close();
+        return false;
+      }
+      _conn->bufsiz = n;
+      return true;
+    }
+
+    if (!_conn->connected() || (millis() - start >= _timeout))
+    {
+      return false;
+    }
+    cc3000_idle();
+  }
+}
+
+bool Adafruit_CC3000_HTTP::readByte(uint8_t *c)
+{
+  if (!waitData())
+  {
+    return false;
+  }
+  *c = _conn->_rx_buf[_conn->_rx_buf_idx++];
+  return true;
+}
+
+/* Reads a line without its CRLF, the part that doesn't fit is dropped */
+bool Adafruit_CC3000_HTTP::readLine(char *line, uint8_t size)
+{
+  uint8_t len = 0, c;
+
+  while (readByte(&c))
+  {
+    if (c == '\n')
+    {
+      if ((len > 0) && (line[len - 1] == '\r'))
+      {
+        len--;
+      }
+      line[len] = 0;
+      return true;
+    }
+    if (len < size - 1)
+    {
+      line[len++] = c;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Appends to the request, sending it whenever CC3000_HTTP_CHUNK
+            bytes are together
+*/
+/**************************************************************************/
+void Adafruit_CC3000_HTTP::put(const void *data, uint16_t len)
+{
+  const uint8_t *p = (const uint8_t *)data;
+
+  while (len)
+  {
+    uint16_t n = sizeof(_out) - _outLen;
+    if (n > len)
+    {
+      n = len;
+    }
+    memcpy(_out + _outLen, p, n);
+    _outLen += n;
+    p += n;
+    len -= n;
+
+    if (_outLen == sizeof(_out))
+    {
+      flush();
+    }
+  }
+}
+
+void Adafruit_CC3000_HTTP::put(const char *str)
+{
+  put(str, strlen(str));
+}
+
+void Adafruit_CC3000_HTTP::put(const __FlashStringHelper *str)
+{
+  const char PROGMEM *p = (const char PROGMEM *)str;
+  uint8_t c;
+
+  while ((c = pgm_read_byte(p++)) != 0)
+  {
+    put(&c, 1);
+  }
+}
+
+/* Sends what's collected, false if any send of the request failed */
+bool Adafruit_CC3000_HTTP::flush(void)
+{
+  if ((_outLen > 0) && !_outFailed)
+  {
+    _outFailed = (_conn->write(_out, _outLen) != (int16_t)_outLen);
+  }
+  _outLen = 0;
+  return !_outFailed;
+}
+
+#endif
@@ -0,0 +1,165 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_HTTP.h
+
+  HTTP/1.1 client with persistent connections.
+
+  The connection to the server stays open between requests (unless the
+  server closes it) and is opened again when it dropped. The response
+  headers are parsed as they come out of the client's RX buffer; the
+  body, sized by Content-Length or sent chunked, is handed on in pieces
+  without being collected: either to a callback given with the request,
+  or to the sketch calling read() after request() returned. Chunked
+  bodies arrive with the chunk framing removed.
+
+  Requests go out in as few sends as fit CC3000_HTTP_CHUNK each. A
+  request on a kept connection that the server closed in the meantime is
+  sent once more on a new one.
+
+  upload() sends a request body that is never held in RAM as a whole,
+  e.g. a log file from SD: a producer callback or a Stream writes it
+  straight into the driver's TX buffer, one frame at a time. The body
+  goes chunked, or with a Content-Length when the caller knows it. A
+  streamed body can't be sent twice, so a request is only sent again on
+  a new connection if none of it was taken from the producer yet.
+
+  With usePool() the connections come from an Adafruit_CC3000_Pool, and
+  begin() with another server leaves the connection to the last one idle
+  in the pool instead of closing it. One client can then take turns with
+  a few servers without connecting anew each time.
+
+  Not available with CC3000_TINY_DRIVER.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_HTTP_H
+#define ADAFRUIT_CC3000_HTTP_H
+
+#include "Adafruit_CC3000.h"
+#include "Adafruit_CC3000_Pool.h"
+#include "utility/hci.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#ifndef CC3000_HTTP_TIMEOUT
+#define CC3000_HTTP_TIMEOUT    10000  // how long the server may be silent, in milliseconds
+#endif
+#ifndef CC3000_HTTP_LINE_SIZE
+#define CC3000_HTTP_LINE_SIZE  64     // longest header line kept, longer ones are cut off
+#endif
+#ifndef CC3000_HTTP_DRAIN_MAX
+#define CC3000_HTTP_DRAIN_MAX  512    // unread body bytes skipped to keep the connection, else it's closed
+#endif
+
+// Largest send() that fits the TX buffer: the SPI and HCI data headers, the
+// 16 bytes of send arguments and the overrun guard byte come off it
+#define CC3000_HTTP_CHUNK  (CC3000_TX_BUFFER_SIZE - SPI_HEADER_SIZE - \
+                            SIMPLE_LINK_HCI_DATA_HEADER_SIZE - 16 - 1)
+
+/* request() results other than the status code */
+#define CC3000_HTTP_ERR_CONNECT   -1  // couldn't connect to the server
+#define CC3000_HTTP_ERR_SEND      -2  // the request couldn't be sent
+#define CC3000_HTTP_ERR_TIMEOUT   -3  // the server stopped sending, or closed the connection early
+#define CC3000_HTTP_ERR_RESPONSE  -4  // not an HTTP response
+#define CC3000_HTTP_ERR_ABORTED   -5  // the body callback returned false
+#define CC3000_HTTP_ERR_BODY      -6  // the upload ended before its Content-Length
+
+/* Gets the body in pieces, return false to stop reading it */
+typedef bool (*cc3000_http_body_callback_t)(const uint8_t *data, uint16_t len);
+
+/* Writes up to len bytes of an upload to buf, returns how many (0 ends the
+   body). It writes into the driver's TX buffer, so it mustn't call the
+   module. */
+typedef uint16_t (*cc3000_http_producer_t)(uint8_t *buf, uint16_t len);
+
+class Adafruit_CC3000_HTTP {
+  public:
+    Adafruit_CC3000_HTTP(Adafruit_CC3000 &cc3000);
+
+    void     begin(uint32_t ip, uint16_t port, const char *host);
+    void     setTimeout(uint32_t ms);
+    void     usePool(Adafruit_CC3000_Pool *pool);
+    void     captureHeader(const char *name, char *value, uint8_t size);
+    void     stop(void);
+
+    int16_t  get(const char *path, cc3000_http_body_callback_t body = NULL);
+    int16_t  post(const char *path, const char *contentType, const void *data, uint16_t len,
+                  cc3000_http_body_callback_t body = NULL);
+    int16_t  request(const char *method, const char *path, const char *contentType,
+                     const void *data, uint16_t len, cc3000_http_body_callback_t body = NULL);
+    int16_t  upload(const char *method, const char *path, const char *contentType,
+                    cc3000_http_producer_t producer, int32_t length = -1,
+                    cc3000_http_body_callback_t body = NULL);
+    int16_t  upload(const char *method, const char *path, const char *contentType,
+                    Stream &stream, int32_t length = -1, cc3000_http_body_callback_t body = NULL);
+
+    int16_t  read(void *buf, uint16_t len);
+    bool     bodyDone(void);
+    int32_t  getContentLength(void);
+    bool     isChunked(void);
+    uint16_t getConnects(void);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+    Adafruit_CC3000_Client _client;
+    Adafruit_CC3000_Pool *_pool;
+    Adafruit_CC3000_Client *_conn;   // _client, or one from the pool
+
+    uint32_t _ip;
+    uint16_t _port;
+    const char *_host;
+    uint32_t _timeout;
+
+    const char *_captureName;
+    char    *_captureValue;
+    uint8_t  _captureSize;
+
+    bool     _inBody;       // the body of the last response isn't read to the end
+    bool     _chunked;
+    bool     _afterChunk;   // a chunk was read, its CRLF comes before the next size
+    bool     _untilClose;   // no length given, the body ends with the connection
+    bool     _keepAlive;    // the server keeps the connection after this response
+    uint32_t _remaining;    // of the body, or of the current chunk
+    int32_t  _contentLength;
+    uint16_t _connects;
+
+    uint8_t  _out[CC3000_HTTP_CHUNK];
+    uint16_t _outLen;
+    bool     _outFailed;
+
+    cc3000_http_producer_t _producer;  // of the upload in flight, or _stream
+    Stream  *_stream;
+    uint32_t _upRemaining;  // of the Content-Length
+    bool     _upChunked;
+    bool     _upStarted;    // the producer gave data, the body can't be sent again
+    bool     _upEnded;      // the producer has no more
+    bool     _upDone;       // all of the body is in the frames
+
+    bool     connect(bool *reused);
+    int16_t  exchange(const char *method, const char *path, const char *contentType,
+                      const void *data, int32_t len, cc3000_http_body_callback_t body);
+    bool     sendRequest(const char *method, const char *path, const char *contentType,
+                         const void *data, int32_t len);
+    bool     sendBody(void);
+    uint16_t fillFrame(uint8_t *frame, uint16_t len);
+    uint16_t produce(uint8_t *buf, uint16_t len);
+    static long fill(unsigned char *buf, long len, void *arg);
+    int16_t  readHead(bool head, bool *nothing);
+    bool     nextChunk(void);
+    int16_t  nextSlice(const uint8_t **data, uint16_t max);
+    void     endBody(void);
+    bool     drain(void);
+
+    bool     waitData(void);
+    bool     readByte(uint8_t *c);
+    bool     readLine(char *line, uint8_t size);
+
+    void     put(const void *data, uint16_t len);
+    void     put(const char *str);
+    void     put(const __FlashStringHelper *str);
+    bool     flush(void);
+};
+
+#endif
+
+#endif
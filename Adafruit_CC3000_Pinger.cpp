@@ -0,0 +1,252 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Pinger.cpp
+
+  Background pinger for link-quality monitoring, see
+  Adafruit_CC3000_Pinger.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_Pinger.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+/**************************************************************************/
+/*!
+    @brief  Creates a pinger for the given module
+*/
+/**************************************************************************/
+Adafruit_CC3000_Pinger::Adafruit_CC3000_Pinger(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _ip(0), _interval(0), _timeout(0), _size(0),
+    _state(CC3000_PINGER_IDLE), _lastPing(0),
+    _lost(0), _haveReport(false)
+{
+  memset(_buckets, 0, sizeof(_buckets));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts pinging, the first ping goes out on the next run()
+
+    @args[in] ip
+              The host, as given to Adafruit_CC3000::ping()
+    @args[in] interval
+              Time between pings in milliseconds, counted from the start
+              of the last one
+    @args[in] timeout
+              How long the module waits for a reply, in milliseconds
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pinger::begin(uint32_t ip, uint32_t interval, uint16_t timeout, uint8_t size)
+{
+  _ip = ip;
+  _interval = interval;
+  _timeout = timeout;
+  _size = size;
+
+  _state.enter(CC3000_PINGER_WAIT, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops pinging, the histogram is kept
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pinger::stop(void)
+{
+  _state.enter(CC3000_PINGER_IDLE, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advances the pinger, call it from loop(). It never waits.
+
+    @returns  The current state
+*/
+/**************************************************************************/
+cc3000_pinger_state_t Adafruit_CC3000_Pinger::run(void)
+{
+  if (_state == CC3000_PINGER_IDLE)
+  {
+    return _state;
+  }
+
+  _cc3000->poll();
+  bool expired = _state.expired();
+
+  switch (_state)
+  {
+    case CC3000_PINGER_WAIT:
+      if (!expired)
+      {
+        break;
+      }
+      _lastPing = millis();
+      // Nothing to measure while we're off the network
+      if (!_cc3000->startPing(_ip, 1, _timeout, _size))
+      {
+        next();
+        break;
+      }
+      // The report is due once the timeout is over, allow as much again
+      _state.enter(CC3000_PINGER_PINGING, (uint32_t)_timeout * 2);
+      break;
+
+    case CC3000_PINGER_PINGING:
+      if (_cc3000->getPingReport(&_report))
+      {
+        _haveReport = true;
+        if (_report.packets_received)
+        {
+          // One attempt per ping, the average is its round trip time
+          uint32_t bucket = _report.avg_round_time / CC3000_PING_BUCKET_WIDTH;
+          if (bucket >= CC3000_PING_BUCKETS)
+          {
+            bucket = CC3000_PING_BUCKETS - 1;
+          }
+          count(&_buckets[bucket]);
+        }
+        else
+        {
+          count(&_lost);
+        }
+        next();
+      }
+      else if (expired)
+      {
+        count(&_lost);
+        next();
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return _state;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clears the histogram and the lost count
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pinger::reset(void)
+{
+  memset(_buckets, 0, sizeof(_buckets));
+  _lost = 0;
+  _haveReport = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Histogram accessors. Bucket i counts the replies that took
+            from i * CC3000_PING_BUCKET_WIDTH up to (i + 1) *
+            CC3000_PING_BUCKET_WIDTH milliseconds, the last bucket also
+            the slower ones. getCount() is the number of replies.
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_Pinger::getBucket(uint8_t bucket)
+{
+  if (bucket >= CC3000_PING_BUCKETS)
+  {
+    return 0;
+  }
+
+  return _buckets[bucket];
+}
+
+uint16_t Adafruit_CC3000_Pinger::getLost(void)
+{
+  return _lost;
+}
+
+uint16_t Adafruit_CC3000_Pinger::getCount(void)
+{
+  uint32_t total = 0;
+
+  for (uint8_t i = 0; i < CC3000_PING_BUCKETS; i++)
+  {
+    total += _buckets[i];
+  }
+
+  return (total > 0xFFFF) ? 0xFFFF : total;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Estimates a percentile of the round trip time from the
+            histogram, e.g. 95 for the time 95% of the replies beat
+
+    @returns  The upper edge of the bucket it falls in, in milliseconds,
+              or 0 without replies
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_Pinger::getPercentile(uint8_t percent)
+{
+  uint32_t total = 0, seen = 0;
+
+  for (uint8_t i = 0; i < CC3000_PING_BUCKETS; i++)
+  {
+    total += _buckets[i];
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+
+  for (uint8_t i = 0; i < CC3000_PING_BUCKETS; i++)
+  {
+    seen += _buckets[i];
+    if (seen * 100 >= total * percent)
+    {
+      return (i + 1) * CC3000_PING_BUCKET_WIDTH;
+    }
+  }
+
+  return CC3000_PING_BUCKETS * CC3000_PING_BUCKET_WIDTH;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Copies the report of the last ping that got one
+
+    @returns  False if no report came in yet
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Pinger::getLastReport(netapp_pingreport_args_t *report)
+{
+  if (!_haveReport)
+  {
+    return false;
+  }
+
+  memcpy(report, &_report, sizeof(_report));
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Waits for the rest of the interval before the next ping
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pinger::next(void)
+{
+  uint32_t elapsed = millis() - _lastPing;
+
+  _state.enter(CC3000_PINGER_WAIT, (elapsed < _interval) ? _interval - elapsed : 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Counts one ping, the counters stop at their maximum
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pinger::count(uint16_t *counter)
+{
+  if (*counter < 0xFFFF)
+  {
+    (*counter)++;
+  }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Pinger.h
+
+  Background pinger for link-quality monitoring.
+
+  Call run() from loop(): every interval it pings the host once without
+  waiting, picks up the report when the module sends it and counts the
+  round trip time into a histogram of CC3000_PING_BUCKETS buckets, each
+  CC3000_PING_BUCKET_WIDTH milliseconds wide (the last one takes
+  everything slower). Pings without a reply count as lost.
+
+  The pinger and ping() share the module's ping report, don't call ping()
+  while the pinger runs.
+
+  Not available with CC3000_TINY_DRIVER, there is no ping.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_PINGER_H
+#define ADAFRUIT_CC3000_PINGER_H
+
+#include "Adafruit_CC3000.h"
+#include "utility/cc3000_state.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#ifndef CC3000_PING_BUCKETS
+#define CC3000_PING_BUCKETS        8  // histogram buckets
+#endif
+#ifndef CC3000_PING_BUCKET_WIDTH
+#define CC3000_PING_BUCKET_WIDTH  25  // round trip time per bucket, in milliseconds
+#endif
+
+typedef enum
+{
+  CC3000_PINGER_IDLE,
+  CC3000_PINGER_WAIT,      // until the next ping
+  CC3000_PINGER_PINGING    // waiting for the report
+} cc3000_pinger_state_t;
+
+class Adafruit_CC3000_Pinger {
+  public:
+    Adafruit_CC3000_Pinger(Adafruit_CC3000 &cc3000);
+
+    void     begin(uint32_t ip, uint32_t interval = 1000, uint16_t timeout = 500, uint8_t size = 32);
+    void     stop(void);
+    cc3000_pinger_state_t run(void);
+    void     reset(void);
+
+    uint16_t getBucket(uint8_t bucket);
+    uint16_t getLost(void);
+    uint16_t getCount(void);
+    uint16_t getPercentile(uint8_t percent);
+    bool     getLastReport(netapp_pingreport_args_t *report);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+
+    uint32_t _ip;
+    uint32_t _interval;
+    uint16_t _timeout;
+    uint8_t  _size;
+
+    cc3000_state<cc3000_pinger_state_t> _state;
+    uint32_t _lastPing;     // millis() when the last ping went out
+
+    uint16_t _buckets[CC3000_PING_BUCKETS];
+    uint16_t _lost;
+    bool     _haveReport;
+    netapp_pingreport_args_t _report;
+
+    void     next(void);
+    void     count(uint16_t *counter);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,358 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Pool.cpp
+
+  Pool of kept TCP connections, see Adafruit_CC3000_Pool.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_Pool.h"
+#include "utility/socket.h"
+#include "utility/evnt_handler.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates an empty pool for the given module
+*/
+/**************************************************************************/
+Adafruit_CC3000_Pool::Adafruit_CC3000_Pool(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _connects(0), _reuses(0)
+{
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    _entries[i].ip = 0;
+    _entries[i].port = 0;
+    _entries[i].lastUsed = 0;
+    _entries[i].inUse = false;
+    _entries[i].client.bufsiz = 0;
+    _entries[i].client._rx_buf_idx = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Hands out a connection to the server: an idle one that is
+            still open, else a new one
+
+    @args[in] reused
+              Set when the connection was open already, e.g. to send a
+              request again on a new one if the server closed it just now
+
+    @returns  The connection, NULL if it couldn't be opened or all
+              CC3000_POOL_SIZE connections are in use
+*/
+/**************************************************************************/
+Adafruit_CC3000_Client *Adafruit_CC3000_Pool::acquire(uint32_t ip, uint16_t port, bool *reused)
+{
+  entry_t *slot = NULL;
+
+  if (reused)
+  {
+    *reused = false;
+  }
+
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    entry_t *e = &_entries[i];
+
+    if (e->inUse || (e->client._socket < 0) || (e->ip != ip) || (e->port != port))
+    {
+      continue;
+    }
+    if (alive(e))
+    {
+      e->inUse = true;
+      _reuses++;
+      if (reused)
+      {
+        *reused = true;
+      }
+      return &e->client;
+    }
+    if (slot == NULL)
+    {
+      slot = e;   // stale and closed now, open it again
+    }
+  }
+
+  // A free entry, else the one idle the longest goes
+  for (uint8_t i = 0; (slot == NULL) && (i < CC3000_POOL_SIZE); i++)
+  {
+    if (!_entries[i].inUse && (_entries[i].client._socket < 0))
+    {
+      slot = &_entries[i];
+    }
+  }
+  if (slot == NULL)
+  {
+    slot = oldestIdle();
+    if (slot == NULL)
+    {
+      return NULL;
+    }
+    drop(slot);
+  }
+
+  slot->ip = ip;
+  slot->port = port;
+  slot->inUse = true;
+  if (!open(slot))
+  {
+    slot->inUse = false;
+    return NULL;
+  }
+  return &slot->client;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Opens a connection that failed in use again, to the same
+            server
+
+    @returns  The connection, NULL if it couldn't be opened (it still
+              has to be released then)
+*/
+/**************************************************************************/
+Adafruit_CC3000_Client *Adafruit_CC3000_Pool::reconnect(Adafruit_CC3000_Client *client)
+{
+  entry_t *e = find(client);
+
+  if ((e == NULL) || !e->inUse)
+  {
+    return NULL;
+  }
+
+  drop(e);
+  return open(e) ? &e->client : NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gives a connection back
+
+    @args[in] keep
+              False to close it, e.g. after a protocol error. It's closed
+              as well if it has unread data buffered.
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pool::release(Adafruit_CC3000_Client *client, bool keep)
+{
+  entry_t *e = find(client);
+
+  if (e == NULL)
+  {
+    return;
+  }
+
+  if (!keep || (client->bufsiz > client->_rx_buf_idx) || !alive(e))
+  {
+    drop(e);
+  }
+  e->inUse = false;
+  e->lastUsed = millis();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Frees the sockets of idle connections the server closed, and
+            of those idle for CC3000_POOL_IDLE. Call it from loop().
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pool::run(void)
+{
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    entry_t *e = &_entries[i];
+
+    if (e->inUse || (e->client._socket < 0))
+    {
+      continue;
+    }
+    if (alive(e) && (CC3000_POOL_IDLE > 0) && (millis() - e->lastUsed >= CC3000_POOL_IDLE))
+    {
+      drop(e);
+    }
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Closes every connection, also those handed out
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Pool::closeAll(void)
+{
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    drop(&_entries[i]);
+    _entries[i].inUse = false;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Pool accessors: the open idle connections, and how many
+            connections were opened and handed out again
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000_Pool::getIdle(void)
+{
+  uint8_t idle = 0;
+
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    if (!_entries[i].inUse && (_entries[i].client._socket >= 0))
+    {
+      idle++;
+    }
+  }
+  return idle;
+}
+
+uint16_t Adafruit_CC3000_Pool::getConnects(void)
+{
+  return _connects;
+}
+
+uint16_t Adafruit_CC3000_Pool::getReuses(void)
+{
+  return _reuses;
+}
+
+Adafruit_CC3000_Pool::entry_t *Adafruit_CC3000_Pool::find(Adafruit_CC3000_Client *client)
+{
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    if (&_entries[i].client == client)
+    {
+      return &_entries[i];
+    }
+  }
+  return NULL;
+}
+
+/* The open idle connection released the longest time ago, NULL if none */
+Adafruit_CC3000_Pool::entry_t *Adafruit_CC3000_Pool::oldestIdle(void)
+{
+  entry_t *oldest = NULL;
+  uint32_t now = millis();
+
+  for (uint8_t i = 0; i < CC3000_POOL_SIZE; i++)
+  {
+    entry_t *e = &_entries[i];
+
+    if (!e->inUse && (e->client._socket >= 0) &&
+        ((oldest == NULL) || (now - e->lastUsed > now - oldest->lastUsed)))
+    {
+      oldest = e;
+    }
+  }
+  return oldest;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks an open connection with what the driver knows, without
+            a call to the module, and closes it if it's stale
+
+    @returns  False if the server closed it, or the module lost it
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Pool::alive(entry_t *e)
+{
+  Adafruit_CC3000_Client *c = &e->client;
+
+  if (c->_socket < 0)
+  {
+    return false;
+  }
+
+  CC3000_SELECT(c->_ctx);
+  // Take a close-wait event the module may have raised meanwhile
+  cc3k_int_poll();
+
+  if ((c->_generation == cc3000_ctx->generation) && !closed_sockets[c->_socket] &&
+      (get_socket_active_status(c->_socket) == SOCKET_STATUS_ACTIVE))
+  {
+    return true;
+  }
+
+  drop(e);
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Opens the entry's connection. If the module has no socket left
+            for it, idle connections are closed, the oldest first.
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Pool::open(entry_t *e)
+{
+  sockaddr address;
+  long     sock;
+
+  _cc3000->select();
+  sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  // A module that didn't answer in time won't have a socket after a close
+  // either, only a refusal is worth an idle connection
+  while ((sock < 0) && (sock != ERROR_WAIT_TIMEOUT))
+  {
+    entry_t *oldest = oldestIdle();
+    if (oldest == NULL)
+    {
+      return false;
+    }
+    drop(oldest);
+
+    _cc3000->select();
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  }
+  if (sock < 0)
+  {
+    return false;
+  }
+
+  // A close-wait for the last socket of that number may never have been
+  // taken, a new one starts open
+  closed_sockets[sock] = false;
+
+  memset(&address, 0, sizeof(address));
+  address.sa_family = AF_INET;
+  address.sa_data[0] = e->port >> 8;
+  address.sa_data[1] = e->port;
+  address.sa_data[2] = e->ip >> 24;
+  address.sa_data[3] = e->ip >> 16;
+  address.sa_data[4] = e->ip >> 8;
+  address.sa_data[5] = e->ip;
+
+  if (connect(sock, &address, sizeof(address)) < 0)
+  {
+    closesocket(sock);
+    return false;
+  }
+
+  // The client takes the module whose context is selected
+  e->client = Adafruit_CC3000_Client(sock);
+  _connects++;
+  return true;
+}
+
+/* Closes the entry's connection, if it has one */
+void Adafruit_CC3000_Pool::drop(entry_t *e)
+{
+  Adafruit_CC3000_Client *c = &e->client;
+
+  // An entry that never had a connection doesn't know its module
+  if (c->_socket >= 0)
+  {
+    CC3000_SELECT(c->_ctx);
+    if (c->_generation == cc3000_ctx->generation)
+    {
+      closesocket(c->_socket);
+      closed_sockets[c->_socket] = false;
+    }
+  }
+  c->_socket = -1;
+  c->bufsiz = 0;
+  c->_rx_buf_idx = 0;
+}
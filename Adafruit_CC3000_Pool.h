@@ -0,0 +1,72 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Pool.h
+
+  Pool of TCP connections kept open between uses, one or more per
+  server (IP and port).
+
+  acquire() hands out an idle connection to the server if there is one,
+  else opens a new one; release() puts it back. Before an idle connection
+  is handed out it is checked with what the driver already knows, without
+  asking the module: the socket must not have been closed by the server
+  (the TCP close-wait event) or lost in a restart of the module. A stale
+  one is opened again in its place. reconnect() does the same for a
+  connection that failed in use, before the driver heard of it.
+
+  Every connection holds one of the module's few sockets. When the module
+  has none left for a new connection, the idle one used longest ago is
+  closed to make room, and so is an idle one when all CC3000_POOL_SIZE
+  entries are taken.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_POOL_H
+#define ADAFRUIT_CC3000_POOL_H
+
+#include "Adafruit_CC3000.h"
+
+#ifndef CC3000_POOL_SIZE
+#define CC3000_POOL_SIZE  3      // connections kept, in use or idle
+#endif
+#ifndef CC3000_POOL_IDLE
+#define CC3000_POOL_IDLE  60000  // run() closes connections idle this long, in milliseconds (0 never)
+#endif
+
+class Adafruit_CC3000_Pool {
+  public:
+    Adafruit_CC3000_Pool(Adafruit_CC3000 &cc3000);
+
+    Adafruit_CC3000_Client *acquire(uint32_t ip, uint16_t port, bool *reused = NULL);
+    Adafruit_CC3000_Client *reconnect(Adafruit_CC3000_Client *client);
+    void     release(Adafruit_CC3000_Client *client, bool keep = true);
+    void     run(void);
+    void     closeAll(void);
+
+    uint8_t  getIdle(void);
+    uint16_t getConnects(void);
+    uint16_t getReuses(void);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+
+    typedef struct
+    {
+      Adafruit_CC3000_Client client;
+      uint32_t ip;
+      uint16_t port;
+      uint32_t lastUsed;   // millis() of the last release()
+      bool     inUse;
+    } entry_t;
+
+    entry_t  _entries[CC3000_POOL_SIZE];
+    uint16_t _connects;
+    uint16_t _reuses;
+
+    entry_t *find(Adafruit_CC3000_Client *client);
+    entry_t *oldestIdle(void);
+    bool     alive(entry_t *e);
+    bool     open(entry_t *e);
+    void     drop(entry_t *e);
+};
+
+#endif
@@ -0,0 +1,424 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Resolver.cpp
+
+  DNS resolver over a UDP socket, see Adafruit_CC3000_Resolver.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_Resolver.h"
+#include "utility/socket.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#define DNS_HEADER_SIZE  12
+#define DNS_TYPE_A       1
+#define DNS_CLASS_IN     1
+#define DNS_RCODE_NXDOMAIN 3
+
+/* parseAnswer() results other than a resolve() result */
+#define ANSWER_IGNORE   -1    // not an answer to our query
+#define ANSWER_FAILED   -2    // the server couldn't answer (SERVFAIL, REFUSED, ...)
+
+/**************************************************************************/
+/*!
+    @brief  Creates a resolver for the given module, with no fallback
+            servers
+*/
+/**************************************************************************/
+Adafruit_CC3000_Resolver::Adafruit_CC3000_Resolver(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _count(0), _useDHCP(true), _id(0), _ttl(0), _server(0)
+{
+  memset(_servers, 0, sizeof(_servers));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a server that is asked along with the one from DHCP
+
+    @returns  False if there are CC3000_RESOLVER_SERVERS already
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Resolver::addServer(uint32_t ip, uint16_t port)
+{
+  if (_count >= CC3000_RESOLVER_SERVERS)
+  {
+    return false;
+  }
+
+  _count++;
+  _servers[_count].ip = ip;
+  _servers[_count].port = port;
+  return true;
+}
+
+void Adafruit_CC3000_Resolver::clearServers(void)
+{
+  _count = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets whether the DNS server from DHCP is asked (it is by
+            default), e.g. to only ask a local one
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Resolver::useDHCPServer(bool use)
+{
+  _useDHCP = use;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Looks up the A records of a name
+
+    @args[in] addrs
+              Filled with up to maxAddrs addresses, in the byte order of
+              Adafruit_CC3000::getHostByName()
+    @args[in] timeout
+              When to give up, in milliseconds
+
+    @returns  The number of addresses, CC3000_RESOLVER_NOT_FOUND,
+              CC3000_RESOLVER_TIMEOUT, CC3000_RESOLVER_ERROR or
+              CC3000_RESOLVER_TRUNCATED
+*/
+/**************************************************************************/
+int8_t Adafruit_CC3000_Resolver::resolve(const char *hostname, uint32_t *addrs, uint8_t maxAddrs, uint32_t timeout)
+{
+  uint8_t  buf[CC3000_RESOLVER_BUFFER_SIZE];
+  uint32_t start = millis(), lastSend = 0;
+  uint32_t ip, netmask, gateway, dhcpserv, dnsserv;
+  uint8_t  pending = 0;
+  int8_t   result = CC3000_RESOLVER_TIMEOUT;
+  bool     first = true;
+  sockaddr address;
+  long     sock;
+
+  // The server from DHCP goes first, unless it's one of the fallbacks
+  _servers[0].ip = 0;
+  _servers[0].port = 53;
+  if (_useDHCP && _cc3000->getIPAddress(&ip, &netmask, &gateway, &dhcpserv, &dnsserv))
+  {
+    _servers[0].ip = dnsserv;
+    for (uint8_t i = 1; i <= _count; i++)
+    {
+      if ((_servers[i].ip == dnsserv) && (_servers[i].port == 53))
+      {
+        _servers[0].ip = 0;
+      }
+    }
+  }
+
+  for (uint8_t i = 0; i <= _count; i++)
+  {
+    _servers[i].done = (_servers[i].ip == 0);
+    if (!_servers[i].done)
+    {
+      pending++;
+    }
+  }
+
+  _id = random(0x10000);
+  if ((pending == 0) || (buildQuery(buf, hostname) == 0))
+  {
+    return CC3000_RESOLVER_ERROR;
+  }
+
+  _cc3000->select();
+  sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (sock < 0)
+  {
+    return CC3000_RESOLVER_ERROR;
+  }
+
+  // A random local port, as sntp does, so stray answers to an earlier
+  // query don't land here
+  memset(&address, 0, sizeof(address));
+  address.sa_family = AF_INET;
+  for (uint8_t tries = 0; tries < 3; tries++)
+  {
+    uint16_t port = random(0xC000, 0xFFFF);
+    address.sa_data[0] = port >> 8;
+    address.sa_data[1] = port;
+    if (bind(sock, &address, sizeof(address)) == 0)
+    {
+      break;
+    }
+  }
+
+  while ((millis() - start < timeout) && pending)
+  {
+    // Ask every server that hasn't answered, again every CC3000_RESOLVER_RETRY
+    if (first || (millis() - lastSend >= CC3000_RESOLVER_RETRY))
+    {
+      uint16_t len = buildQuery(buf, hostname);  // the answers overwrite it
+
+      for (uint8_t i = 0; i <= _count; i++)
+      {
+        if (_servers[i].done)
+        {
+          continue;
+        }
+        address.sa_data[0] = _servers[i].port >> 8;
+        address.sa_data[1] = _servers[i].port;
+        address.sa_data[2] = _servers[i].ip >> 24;
+        address.sa_data[3] = _servers[i].ip >> 16;
+        address.sa_data[4] = _servers[i].ip >> 8;
+        address.sa_data[5] = _servers[i].ip;
+        sendto(sock, buf, len, 0, &address, sizeof(address));
+      }
+      lastSend = millis();
+      first = false;
+    }
+
+    // Wait for an answer until the next resend or the deadline, whichever
+    // comes first (select() takes 5 ms at least)
+    uint32_t wait = CC3000_RESOLVER_RETRY - (millis() - lastSend);
+    uint32_t left = timeout - (millis() - start);
+    if (left < wait)
+    {
+      wait = left;
+    }
+    if (wait < 5)
+    {
+      wait = 5;
+    }
+
+    timeval tv;
+    fd_set  fds;
+    tv.tv_sec = wait / 1000;
+    tv.tv_usec = (wait % 1000) * 1000;
+    memset(&fds, 0, sizeof(fds));
+    FD_SET(sock, &fds);
+    if (select(sock + 1, &fds, NULL, NULL, &tv) != 1)
+    {
+      continue;
+    }
+
+    socklen_t fromlen = sizeof(address);
+    int len = recvfrom(sock, buf, sizeof(buf), 0, &address, &fromlen);
+    if (len <= 0)
+    {
+      continue;
+    }
+
+    // Only answers from the servers we asked count
+    uint32_t from = ((uint32_t)(uint8_t)address.sa_data[2] << 24) |
+                    ((uint32_t)(uint8_t)address.sa_data[3] << 16) |
+                    ((uint32_t)(uint8_t)address.sa_data[4] << 8) |
+                    (uint8_t)address.sa_data[5];
+    uint16_t port = ((uint8_t)address.sa_data[0] << 8) | (uint8_t)address.sa_data[1];
+    uint8_t server;
+    for (server = 0; server <= _count; server++)
+    {
+      if (!_servers[server].done && (_servers[server].ip == from) &&
+          (_servers[server].port == port))
+      {
+        break;
+      }
+    }
+    if (server > _count)
+    {
+      continue;
+    }
+
+    int8_t ret = parseAnswer(buf, len, addrs, maxAddrs);
+    if (ret == ANSWER_IGNORE)
+    {
+      continue;
+    }
+    if (ret == ANSWER_FAILED)
+    {
+      // The others may still know
+      _servers[server].done = true;
+      pending--;
+      continue;
+    }
+
+    _server = from;
+    result = ret;
+    break;
+  }
+
+  closesocket(sock);
+  return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Answer accessors: the TTL of the last answer in seconds (the
+            lowest of its A records, 0 without any) and the server that
+            gave it
+*/
+/**************************************************************************/
+uint32_t Adafruit_CC3000_Resolver::getTTL(void)
+{
+  return _ttl;
+}
+
+uint32_t Adafruit_CC3000_Resolver::getServer(void)
+{
+  return _server;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the query for the A records of hostname to buf
+
+    @returns  The query length, 0 if the name is invalid or doesn't fit
+*/
+/**************************************************************************/
+uint16_t Adafruit_CC3000_Resolver::buildQuery(uint8_t *buf, const char *hostname)
+{
+  uint16_t pos = DNS_HEADER_SIZE;
+  const char *label = hostname;
+
+  // ID, recursion desired, one question
+  memset(buf, 0, DNS_HEADER_SIZE);
+  buf[0] = _id >> 8;
+  buf[1] = _id;
+  buf[2] = 0x01;
+  buf[5] = 1;
+
+  while (*label)
+  {
+    const char *dot = strchr(label, '.');
+    uint16_t len = dot ? (dot - label) : strlen(label);
+
+    // The root label, type and class have to fit after it
+    if ((len == 0) || (len > 63) ||
+        (pos + 1 + len + 5 > CC3000_RESOLVER_BUFFER_SIZE))
+    {
+      return 0;
+    }
+
+    buf[pos++] = len;
+    memcpy(buf + pos, label, len);
+    pos += len;
+
+    label += len;
+    if (*label == '.')
+    {
+      label++;
+    }
+  }
+
+  if (pos == DNS_HEADER_SIZE)
+  {
+    return 0;
+  }
+
+  buf[pos++] = 0;
+  buf[pos++] = 0;
+  buf[pos++] = DNS_TYPE_A;
+  buf[pos++] = 0;
+  buf[pos++] = DNS_CLASS_IN;
+  return pos;
+}
+
+/* Skips a (possibly compressed) name, returns past len if it's cut off */
+static uint16_t skipName(const uint8_t *buf, uint16_t len, uint16_t pos)
+{
+  while (pos < len)
+  {
+    uint8_t c = buf[pos];
+    if (c == 0)
+    {
+      return pos + 1;
+    }
+    if ((c & 0xC0) == 0xC0)
+    {
+      return pos + 2;
+    }
+    pos += c + 1;
+  }
+
+  return len + 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the A records of an answer to the query in flight.
+            Records cut off by the buffer are left out.
+
+    @returns  The number of addresses, CC3000_RESOLVER_NOT_FOUND,
+              CC3000_RESOLVER_TRUNCATED (records cut off, none read),
+              ANSWER_IGNORE or ANSWER_FAILED
+*/
+/**************************************************************************/
+int8_t Adafruit_CC3000_Resolver::parseAnswer(uint8_t *buf, uint16_t len, uint32_t *addrs, uint8_t maxAddrs)
+{
+  uint16_t pos = DNS_HEADER_SIZE;
+  uint16_t questions, answers;
+  int8_t   count = 0;
+  bool     cut = false;
+
+  // Ours, and an answer
+  if ((len < DNS_HEADER_SIZE) ||
+      ((uint16_t)((buf[0] << 8) | buf[1]) != _id) ||
+      !(buf[2] & 0x80))
+  {
+    return ANSWER_IGNORE;
+  }
+
+  _ttl = 0;
+  switch (buf[3] & 0x0F)
+  {
+    case 0:
+      break;
+    case DNS_RCODE_NXDOMAIN:
+      return CC3000_RESOLVER_NOT_FOUND;
+    default:
+      return ANSWER_FAILED;
+  }
+
+  questions = (buf[4] << 8) | buf[5];
+  answers = (buf[6] << 8) | buf[7];
+
+  while (questions--)
+  {
+    pos = skipName(buf, len, pos) + 4;  // type and class
+  }
+
+  while (answers-- && (count < maxAddrs))
+  {
+    pos = skipName(buf, len, pos);
+    if (pos + 10 > len)
+    {
+      cut = true;
+      break;
+    }
+
+    uint16_t type = (buf[pos] << 8) | buf[pos + 1];
+    uint16_t klass = (buf[pos + 2] << 8) | buf[pos + 3];
+    uint32_t ttl = ((uint32_t)buf[pos + 4] << 24) | ((uint32_t)buf[pos + 5] << 16) |
+                   ((uint32_t)buf[pos + 6] << 8) | buf[pos + 7];
+    uint16_t rdlen = (buf[pos + 8] << 8) | buf[pos + 9];
+    pos += 10;
+    if (pos + rdlen > len)
+    {
+      cut = true;
+      break;
+    }
+
+    // CNAMEs are skipped, the A records of their target follow them
+    if ((type == DNS_TYPE_A) && (klass == DNS_CLASS_IN) && (rdlen == 4))
+    {
+      addrs[count++] = ((uint32_t)buf[pos] << 24) | ((uint32_t)buf[pos + 1] << 16) |
+                       ((uint32_t)buf[pos + 2] << 8) | buf[pos + 3];
+      if ((count == 1) || (ttl < _ttl))
+      {
+        _ttl = ttl;
+      }
+    }
+    pos += rdlen;
+  }
+
+  // The name exists, a long CNAME took the room of its A records
+  if ((count == 0) && cut)
+  {
+    return CC3000_RESOLVER_TRUNCATED;
+  }
+  return count;
+}
+
+#endif
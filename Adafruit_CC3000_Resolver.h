@@ -0,0 +1,87 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Resolver.h
+
+  DNS resolver that builds its own queries over a UDP socket, instead of
+  the module's gethostbyname().
+
+  resolve() sends the same query to the DNS server from DHCP and to the
+  fallback servers given with addServer() at once, and takes the first
+  answer. Servers that haven't answered are asked again every
+  CC3000_RESOLVER_RETRY, and when the caller's timeout is over resolve()
+  gives up. It returns every A record of the answer (that fits the
+  receive buffer, see CC3000_RESOLVER_BUFFER_SIZE) and the TTL, or
+  CC3000_RESOLVER_TRUNCATED when a long CNAME leaves no room for any.
+
+  Not available with CC3000_TINY_DRIVER, the DNS server from DHCP isn't
+  known there.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_RESOLVER_H
+#define ADAFRUIT_CC3000_RESOLVER_H
+
+#include "Adafruit_CC3000.h"
+#include "utility/hci.h"
+#include "utility/socket.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#ifndef CC3000_RESOLVER_SERVERS
+#define CC3000_RESOLVER_SERVERS  2     // fallback servers, asked along with the one from DHCP
+#endif
+#ifndef CC3000_RESOLVER_RETRY
+#define CC3000_RESOLVER_RETRY    1000  // time before asking a silent server again, in milliseconds
+#endif
+
+// Largest query sendto() and answer recvfrom() can take: the SPI and HCI
+// data headers, the 24 bytes of sendto/recvfrom arguments, the destination
+// address sendto() copies after the data and the overrun guard byte come
+// off the smaller of the TX and RX buffers
+#define CC3000_RESOLVER_BUFFER_SIZE  (((CC3000_RX_BUFFER_SIZE < CC3000_TX_BUFFER_SIZE) ? \
+                                       CC3000_RX_BUFFER_SIZE : CC3000_TX_BUFFER_SIZE) - \
+                                      SPI_HEADER_SIZE - SIMPLE_LINK_HCI_DATA_HEADER_SIZE - 24 - \
+                                      sizeof(sockaddr) - 1)
+
+/* resolve() results other than the number of addresses */
+#define CC3000_RESOLVER_NOT_FOUND   0   // the name doesn't exist or has no A record
+#define CC3000_RESOLVER_TIMEOUT    -1   // no server could answer in time
+#define CC3000_RESOLVER_ERROR      -2   // no socket, no server, or the name is too long
+#define CC3000_RESOLVER_TRUNCATED  -3   // the name has records, but no A record fits the buffer
+
+class Adafruit_CC3000_Resolver {
+  public:
+    Adafruit_CC3000_Resolver(Adafruit_CC3000 &cc3000);
+
+    bool     addServer(uint32_t ip, uint16_t port = 53);
+    void     clearServers(void);
+    void     useDHCPServer(bool use);
+
+    int8_t   resolve(const char *hostname, uint32_t *addrs, uint8_t maxAddrs, uint32_t timeout);
+    uint32_t getTTL(void);
+    uint32_t getServer(void);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+
+    typedef struct
+    {
+      uint32_t ip;
+      uint16_t port;
+      bool     done;      // answered this query (or refused it)
+    } server_t;
+
+    server_t _servers[CC3000_RESOLVER_SERVERS + 1];  // the DHCP one first
+    uint8_t  _count;
+    bool     _useDHCP;
+    uint16_t _id;         // of the query in flight
+    uint32_t _ttl;        // of the last answer, in seconds
+    uint32_t _server;     // that gave the last answer
+
+    uint16_t buildQuery(uint8_t *buf, const char *hostname);
+    int8_t   parseAnswer(uint8_t *buf, uint16_t len, uint32_t *addrs, uint8_t maxAddrs);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,391 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Roaming.cpp
+
+  RSSI-driven roaming between the APs of one SSID, see
+  Adafruit_CC3000_Roaming.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_Roaming.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+/**************************************************************************/
+/*!
+    @brief  Creates a roaming manager for the given module
+*/
+/**************************************************************************/
+Adafruit_CC3000_Roaming::Adafruit_CC3000_Roaming(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000), _ssid(0), _key(0), _secmode(0),
+    _state(CC3000_ROAM_IDLE), _joined(0),
+    _known(false), _rssi(0), _fallback(false), _roaming(false), _backoff(0),
+    _roams(0), _callback(0)
+{ }
+
+/**************************************************************************/
+/*!
+    @brief  Starts watching the signal, call it once connected to the SSID
+            and then call run() from loop()
+
+    @note   Only the pointers are kept, ssid and key are read again on
+            every rejoin until stop()
+
+    @returns  False if the connection policy couldn't be set or the scan
+              couldn't be started
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Roaming::begin(const char *ssid, const char *key, uint8_t secmode)
+{
+  _ssid = ssid;
+  _key = key;
+  _secmode = secmode;
+  _known = false;
+  _joined = millis();
+  _roaming = false;
+  _backoff = 0;
+
+  // Roaming picks the AP, the module mustn't reconnect on its own
+  _cc3000->select();
+  if (wlan_ioctl_set_connection_policy(0, 0, 0) != 0)
+  {
+    return false;
+  }
+
+  // The module scans by itself from now on, samples only read the results
+  if (!_cc3000->scanSSIDs(CC3000_ROAM_INTERVAL))
+  {
+    return false;
+  }
+
+  cc3000_scan_config_t config;
+  _cc3000->getScanConfig(&config);
+  _state.enter(CC3000_ROAM_SCANNING, config.scanTime);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stops roaming. Don't call it in the middle of a roam.
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Roaming::stop(void)
+{
+  if (_state != CC3000_ROAM_IDLE)
+  {
+    _cc3000->scanSSIDs(0);
+  }
+  _state.enter(CC3000_ROAM_IDLE, 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advances the state machine, call it from loop(). Only reading
+            the scan results takes a while (one HCI command per AP in
+            range), everything else returns right away.
+
+    @returns  The current state
+*/
+/**************************************************************************/
+cc3000_roam_state_t Adafruit_CC3000_Roaming::run(void)
+{
+  if (_state == CC3000_ROAM_IDLE)
+  {
+    return _state;
+  }
+
+  _cc3000->poll();
+  bool expired = _state.expired();
+
+  switch (_state)
+  {
+    case CC3000_ROAM_WAIT:
+      // The module doesn't reconnect by itself, see begin()
+      if (!_cc3000->checkConnected())
+      {
+        rejoin();
+        break;
+      }
+      if (!expired)
+      {
+        break;
+      }
+      // Nothing to compare while we're off the network
+      if (!_cc3000->checkDHCP())
+      {
+        _state.enter(CC3000_ROAM_WAIT, CC3000_ROAM_INTERVAL);
+        break;
+      }
+      sample();
+      break;
+
+    case CC3000_ROAM_SCANNING:
+      if (expired)
+      {
+        sample();
+      }
+      break;
+
+    case CC3000_ROAM_DRAINING:
+      // Servers keep listening, only the connections have to finish
+      if ((_cc3000->openSockets(false) == 0) || expired)
+      {
+        _cc3000->dropSockets();
+        _cc3000->disconnect();
+        _state.enter(CC3000_ROAM_DISCONNECTING, WLAN_CONNECT_TIMEOUT);
+      }
+      break;
+
+    case CC3000_ROAM_DISCONNECTING:
+      if (!_cc3000->checkConnected() || expired)
+      {
+        _fallback = false;
+        if (!connect(_target))
+        {
+          rejoin();
+        }
+      }
+      break;
+
+    case CC3000_ROAM_CONNECTING:
+      if (_cc3000->checkConnected())
+      {
+        _state.enter(CC3000_ROAM_DHCP, WLAN_CONNECT_TIMEOUT);
+      }
+      else if (_cc3000->waitFor(CC3000_EVENT_DISCONNECTED, 0) || expired)
+      {
+        // The target refused us, take any AP of the SSID instead
+        if (_fallback)
+        {
+          rejoin();
+        }
+        else
+        {
+          _fallback = true;
+          if (!connect(NULL))
+          {
+            rejoin();
+          }
+        }
+      }
+      break;
+
+    case CC3000_ROAM_DHCP:
+      if (_cc3000->checkDHCP())
+      {
+        if (!_fallback)
+        {
+          memcpy(_bssid, _target, 6);
+          _known = true;
+        }
+        if (_roaming)
+        {
+          _roams++;
+        }
+        finish();
+      }
+      else if (!_cc3000->checkConnected() || expired)
+      {
+        rejoin();
+      }
+      break;
+
+    case CC3000_ROAM_REJOINING:
+      if (_cc3000->checkDHCP())
+      {
+        finish();
+      }
+      else if (expired)
+      {
+        _fallback = true;
+        if (!connect(NULL))
+        {
+          rejoin();
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return _state;
+}
+
+/**************************************************************************/
+/*!
+    @brief  State accessors. getCurrentRSSI() is the last sample of the
+            current AP, getCurrentBSSID() is NULL while it isn't known.
+*/
+/**************************************************************************/
+cc3000_roam_state_t Adafruit_CC3000_Roaming::getState(void)
+{
+  return _state;
+}
+
+uint8_t Adafruit_CC3000_Roaming::getCurrentRSSI(void)
+{
+  return _rssi;
+}
+
+const uint8_t *Adafruit_CC3000_Roaming::getCurrentBSSID(void)
+{
+  return _known ? _bssid : NULL;
+}
+
+uint16_t Adafruit_CC3000_Roaming::getRoamCount(void)
+{
+  return _roams;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the function called with true when a roam starts (the
+            sketch should finish up and close its sockets) and with false
+            when it's over and the module is back on the network, on the
+            target AP or any other of the SSID
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Roaming::onRoam(cc3000_roam_callback_t callback)
+{
+  _callback = callback;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the latest scan, compares the current AP with the
+            strongest one and starts a roam when the thresholds are
+            crossed
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Roaming::sample(void)
+{
+  uint8_t count = _cc3000->readScanResults(_table, CC3000_ROAM_SLOTS, _ssid, false);
+  uint8_t current = 0;  // not seen counts as no signal
+
+  _state.enter(CC3000_ROAM_WAIT, CC3000_ROAM_INTERVAL);
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  if (!_known)
+  {
+    memcpy(_bssid, _table[0].bssid, 6);
+    _known = true;
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (memcmp(_table[i].bssid, _bssid, 6) == 0)
+    {
+      current = _table[i].rssi;
+      break;
+    }
+  }
+  _rssi = current;
+
+  // The table is sorted, the first entry is the strongest AP
+  if ((memcmp(_table[0].bssid, _bssid, 6) != 0) &&
+      (current < CC3000_ROAM_TRIGGER) &&
+      (_table[0].rssi >= current + CC3000_ROAM_HYSTERESIS) &&
+      (millis() - _joined >= CC3000_ROAM_HOLDOFF))
+  {
+    memcpy(_target, _table[0].bssid, 6);
+    _roaming = true;
+    if (_callback)
+    {
+      _callback(true);
+    }
+    _state.enter(CC3000_ROAM_DRAINING, CC3000_ROAM_DRAIN_TIMEOUT);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Queues a connect to the given AP of the SSID (any AP for NULL)
+
+    @returns  False if the module refused the request
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Roaming::connect(const uint8_t *bssid)
+{
+  long ret;
+
+  _cc3000->clearEvents(CC3000_EVENT_CONNECTED | CC3000_EVENT_DISCONNECTED | CC3000_EVENT_DHCP);
+
+  _cc3000->select();
+  if ((_secmode == 0) || (strlen(_key) == 0))
+  {
+    ret = wlan_connect(WLAN_SEC_UNSEC, _ssid, strlen(_ssid),
+                       (unsigned char *)bssid, NULL, 0);
+  }
+  else
+  {
+    ret = wlan_connect(_secmode, _ssid, strlen(_ssid), (unsigned char *)bssid,
+                       (unsigned char *)_key, strlen(_key));
+  }
+
+  if (ret != 0)
+  {
+    return false;
+  }
+
+  _state.enter(CC3000_ROAM_CONNECTING, WLAN_CONNECT_TIMEOUT);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gives up on the connect in flight: the module is off the
+            network, so any AP of the SSID is joined again after the
+            backoff, which doubles with every try
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Roaming::rejoin(void)
+{
+  if (_backoff == 0)
+  {
+    _backoff = CC3000_ROAM_REJOIN_MIN;
+  }
+  else if (_backoff < CC3000_ROAM_REJOIN_MAX / 2)
+  {
+    _backoff *= 2;
+  }
+  else
+  {
+    _backoff = CC3000_ROAM_REJOIN_MAX;
+  }
+
+  _known = false;
+  _state.enter(CC3000_ROAM_REJOINING, _backoff);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Ends a roam or a rejoin back on the network and goes back to
+            sampling. Unless the target took us, the AP we are on isn't
+            known.
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Roaming::finish(void)
+{
+  if (_fallback || (_state != CC3000_ROAM_DHCP))
+  {
+    _known = false;
+  }
+  _joined = millis();
+  _backoff = 0;
+  _state.enter(CC3000_ROAM_WAIT, CC3000_ROAM_INTERVAL);
+
+  if (_roaming)
+  {
+    _roaming = false;
+    if (_callback)
+    {
+      _callback(false);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,125 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Roaming.h
+
+  RSSI-driven roaming between the APs of one SSID.
+
+  The CC3000 stays on the AP it joined until the link drops, however weak
+  it gets. begin() starts the module's periodic scan, every
+  CC3000_ROAM_INTERVAL, and stop() ends it: setting the scan up writes the
+  module's NVMEM, so that is done once and not for every sample. Call
+  run() from loop(): every CC3000_ROAM_INTERVAL it reads the APs of the
+  SSID from the latest scan and compares the current AP with the
+  strongest one. When the current AP is below CC3000_ROAM_TRIGGER and
+  another one is at least CC3000_ROAM_HYSTERESIS stronger, it roams: the
+  sketch is asked to finish up its sockets, and once they are closed (or
+  CC3000_ROAM_DRAIN_TIMEOUT is over) the module reconnects to the
+  stronger AP by its BSSID. Sockets that servers listen on aren't waited
+  for.
+
+  begin() turns off the module's own reconnecting, so the manager takes
+  that over: when a roam fails, or the link drops between samples, it
+  joins any AP of the SSID again, backing off from
+  CC3000_ROAM_REJOIN_MIN up to CC3000_ROAM_REJOIN_MAX between tries.
+
+  The current AP is only known once the manager has connected to it;
+  after a connect by other means the strongest AP of the first scan is
+  taken as the current one. Use either this or
+  Adafruit_CC3000_ConnectionManager, they would both reconnect.
+
+  Not available with CC3000_TINY_DRIVER, the scan results can't be read.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_ROAMING_H
+#define ADAFRUIT_CC3000_ROAMING_H
+
+#include "Adafruit_CC3000.h"
+#include "utility/cc3000_state.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#ifndef CC3000_ROAM_INTERVAL
+#define CC3000_ROAM_INTERVAL      30000  // time between signal samples, in milliseconds
+#endif
+#ifndef CC3000_ROAM_HOLDOFF
+#define CC3000_ROAM_HOLDOFF       60000  // shortest time on an AP before roaming away, in milliseconds
+#endif
+#ifndef CC3000_ROAM_TRIGGER
+#define CC3000_ROAM_TRIGGER          55  // only roam while the current AP is weaker than this (scan RSSI)
+#endif
+#ifndef CC3000_ROAM_HYSTERESIS
+#define CC3000_ROAM_HYSTERESIS        8  // how much stronger the new AP must be
+#endif
+#ifndef CC3000_ROAM_DRAIN_TIMEOUT
+#define CC3000_ROAM_DRAIN_TIMEOUT  5000  // how long the sketch gets to close its sockets, in milliseconds
+#endif
+#ifndef CC3000_ROAM_SLOTS
+#define CC3000_ROAM_SLOTS             4  // APs of the SSID tracked per sample
+#endif
+#ifndef CC3000_ROAM_REJOIN_MIN
+#define CC3000_ROAM_REJOIN_MIN     1000  // first wait before joining the SSID again when off it, in milliseconds
+#endif
+#ifndef CC3000_ROAM_REJOIN_MAX
+#define CC3000_ROAM_REJOIN_MAX    60000  // the wait doubles on every failed try up to this, in milliseconds
+#endif
+
+typedef enum
+{
+  CC3000_ROAM_IDLE,
+  CC3000_ROAM_WAIT,        // until the next sample
+  CC3000_ROAM_SCANNING,    // until the first scan is done
+  CC3000_ROAM_DRAINING,    // waiting for the sockets to close
+  CC3000_ROAM_DISCONNECTING,
+  CC3000_ROAM_CONNECTING,
+  CC3000_ROAM_DHCP,
+  CC3000_ROAM_REJOINING    // off the network, waiting to join the SSID again
+} cc3000_roam_state_t;
+
+/* Called with true before a roam (close your sockets), false after it */
+typedef void (*cc3000_roam_callback_t)(bool starting);
+
+class Adafruit_CC3000_Roaming {
+  public:
+    Adafruit_CC3000_Roaming(Adafruit_CC3000 &cc3000);
+
+    bool     begin(const char *ssid, const char *key, uint8_t secmode);
+    void     stop(void);
+    cc3000_roam_state_t run(void);
+
+    cc3000_roam_state_t getState(void);
+    void     onRoam(cc3000_roam_callback_t callback);
+    uint8_t  getCurrentRSSI(void);
+    const uint8_t *getCurrentBSSID(void);
+    uint16_t getRoamCount(void);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+
+    const char *_ssid, *_key;
+    uint8_t  _secmode;
+
+    cc3000_state<cc3000_roam_state_t> _state;
+    uint32_t _joined;       // millis() when we got on the current AP
+
+    bool     _known;        // _bssid is the AP we are on
+    uint8_t  _bssid[6];
+    uint8_t  _rssi;         // last sample of the current AP
+    uint8_t  _target[6];    // the AP we are roaming to
+    bool     _fallback;     // the target refused us, joined any AP of the SSID
+    bool     _roaming;      // the callback was told that a roam started
+    uint32_t _backoff;      // wait before the next rejoin, 0 while on the network
+    uint16_t _roams;
+
+    cc3000_scan_entry_t _table[CC3000_ROAM_SLOTS];
+    cc3000_roam_callback_t _callback;
+
+    void     sample(void);
+    bool     connect(const uint8_t *bssid);
+    void     rejoin(void);
+    void     finish(void);
+};
+
+#endif
+
+#endif
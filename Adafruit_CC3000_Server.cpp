@@ -81,6 +81,11 @@ int16_t Adafruit_CC3000_ClientRef::read(void *buf, uint16_t len, uint32_t flags)
   HANDLE_NULL(_client, 0);
   return _client->read(buf, len, flags);
 }
+
+int16_t Adafruit_CC3000_ClientRef::writeFill(tSendFill fill, void *arg, uint16_t len, uint32_t flags) {
+  HANDLE_NULL(_client, 0);
+  return _client->writeFill(fill, arg, len, flags);
+}
 #endif
 
 uint8_t Adafruit_CC3000_ClientRef::read(void) {
@@ -126,8 +131,13 @@ Adafruit_CC3000_ClientRef Adafruit_CC3000_Server::available() {
   return Adafruit_CC3000_ClientRef(NULL);
 }
 
-// Initialize the server and start listening for connections.
+// Initialize the server and start listening for connections.  With several
+// CC3000 modules the server listens on the one selected last (see
+// Adafruit_CC3000::select()).
 void Adafruit_CC3000_Server::begin() {
+#if CC3000_MAX_INSTANCES > 1
+  _ctx = cc3000_ctx;
+#endif
   // Set the CC3000 inactivity timeout to 0 (never timeout).  This will ensure 
   // the CC3000 does not close the listening socket when it's idle for more than 
   // 60 seconds (the default timeout).  See more information from:
@@ -208,6 +218,7 @@ void Adafruit_CC3000_Server::acceptNewConnections() {
       // socket this call will not block and instead return SOC_IN_PROGRESS (-2) 
       // if there are no pending client connections. Also, the address of the 
       // connected client is not needed, so those parameters are set to NULL.
+      CC3000_SELECT(_ctx);
       cc3k_int_poll();
       int soc = accept(_listenSocket, NULL, NULL);
       if (soc > -1) {
@@ -57,6 +57,7 @@ class Adafruit_CC3000_ClientRef : public Print {
   size_t fastrprintln(const __FlashStringHelper *ifsh);
   int16_t write(const void *buf, uint16_t len, uint32_t flags = 0);
   int16_t read(void *buf, uint16_t len, uint32_t flags = 0);
+  int16_t writeFill(tSendFill fill, void *arg, uint16_t len, uint32_t flags = 0);
 #endif
 
   uint8_t read(void);
@@ -93,12 +94,17 @@ public:
   using Print::write;
 
 private:
+  // Adafruit_CC3000::recover() drops the clients and listens again.
+  friend class Adafruit_CC3000;
   // Store the clients in a simple array.
   Adafruit_CC3000_Client _clients[MAX_SERVER_CLIENTS];
   // The port this server will listen for connections on.
   uint16_t _port;
   // The id of the listening socket.
   uint16_t _listenSocket;
+#if CC3000_MAX_INSTANCES > 1
+  tCC3000Context *_ctx;
+#endif
 
   // Accept new connections and update the connected clients.
   void acceptNewConnections();
@@ -0,0 +1,208 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Worker.cpp
+
+  Single-owner execution model for the CC3000 driver, see
+  Adafruit_CC3000_Worker.h.
+*/
+/**************************************************************************/
+#include "Adafruit_CC3000_Worker.h"
+
+#include "utility/socket.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates a worker for the given module. The module must be
+            begun (and connected) by the worker task before ops are run.
+*/
+/**************************************************************************/
+Adafruit_CC3000_Worker::Adafruit_CC3000_Worker(Adafruit_CC3000 &cc3000)
+  : _cc3000(&cc3000)
+{ }
+
+/**************************************************************************/
+/*!
+    @brief  Queues a prepared op for the worker: code, arguments and
+            complete all filled in
+
+    @returns  False if the queue is full (the op is left untouched)
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Worker::submit(Adafruit_CC3000_Op *op)
+{
+  __atomic_store_n(&op->done, 0, __ATOMIC_RELAXED);
+  return _queue.push(op);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Helpers that fill in an op and submit it, see the matching
+            functions in utility/socket.h for the results. complete is
+            called from the worker task once the op is run, if NULL the
+            op's done flag is set instead.
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Worker::socket(Adafruit_CC3000_Op *op, bool udp, cc3000_op_complete_t complete)
+{
+  op->code = CC3000_OP_SOCKET;
+  op->port = udp ? SOCK_DGRAM : SOCK_STREAM;
+  op->complete = complete;
+  return submit(op);
+}
+
+bool Adafruit_CC3000_Worker::connect(Adafruit_CC3000_Op *op, int32_t sd, uint32_t ip, uint16_t port,
+                                     cc3000_op_complete_t complete)
+{
+  op->code = CC3000_OP_CONNECT;
+  op->sd = sd;
+  op->ip = ip;
+  op->port = port;
+  op->complete = complete;
+  return submit(op);
+}
+
+bool Adafruit_CC3000_Worker::send(Adafruit_CC3000_Op *op, int32_t sd, const void *buf, uint16_t len, uint32_t flags,
+                                  cc3000_op_complete_t complete)
+{
+  op->code = CC3000_OP_SEND;
+  op->sd = sd;
+  op->buf = (void *)buf;
+  op->len = len;
+  op->flags = flags;
+  op->complete = complete;
+  return submit(op);
+}
+
+bool Adafruit_CC3000_Worker::recv(Adafruit_CC3000_Op *op, int32_t sd, void *buf, uint16_t len, uint32_t flags,
+                                  cc3000_op_complete_t complete)
+{
+  op->code = CC3000_OP_RECV;
+  op->sd = sd;
+  op->buf = buf;
+  op->len = len;
+  op->flags = flags;
+  op->complete = complete;
+  return submit(op);
+}
+
+bool Adafruit_CC3000_Worker::close(Adafruit_CC3000_Op *op, int32_t sd, cc3000_op_complete_t complete)
+{
+  op->code = CC3000_OP_CLOSE;
+  op->sd = sd;
+  op->complete = complete;
+  return submit(op);
+}
+
+#ifndef CC3000_TINY_DRIVER
+bool Adafruit_CC3000_Worker::gethostbyname(Adafruit_CC3000_Op *op, const char *hostname,
+                                           cc3000_op_complete_t complete)
+{
+  op->code = CC3000_OP_GETHOSTBYNAME;
+  op->buf = (void *)hostname;
+  op->len = strlen(hostname);
+  op->complete = complete;
+  return submit(op);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  True once the worker has run the op and its result is valid
+*/
+/**************************************************************************/
+bool Adafruit_CC3000_Worker::isDone(const Adafruit_CC3000_Op *op)
+{
+  return __atomic_load_n(&op->done, __ATOMIC_ACQUIRE) != 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs queued ops back to back, at most maxOps of them. Call it
+            from the worker task's loop.
+
+    @returns  The number of ops that were run
+*/
+/**************************************************************************/
+uint8_t Adafruit_CC3000_Worker::process(uint8_t maxOps)
+{
+  Adafruit_CC3000_Op *op;
+  uint8_t count = 0;
+
+  _cc3000->select();
+
+  // Pick up unsolicited events (free buffers, closed sockets) once for
+  // the whole batch instead of once per op
+  cc3k_int_poll();
+
+  while ((count < maxOps) && _queue.pop(op))
+  {
+    execute(op);
+    count++;
+  }
+
+  return count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs a single op in the worker task and completes it
+*/
+/**************************************************************************/
+void Adafruit_CC3000_Worker::execute(Adafruit_CC3000_Op *op)
+{
+  sockaddr address;
+
+  switch (op->code)
+  {
+    case CC3000_OP_SOCKET:
+      op->result = ::socket(AF_INET, op->port,
+                            (op->port == SOCK_DGRAM) ? IPPROTO_UDP : IPPROTO_TCP);
+      break;
+
+    case CC3000_OP_CONNECT:
+      memset(&address, 0x00, sizeof(address));
+      address.sa_family = AF_INET;
+      address.sa_data[0] = (op->port & 0xFF00) >> 8;  // Set the Port Number
+      address.sa_data[1] = (op->port & 0x00FF);
+      address.sa_data[2] = op->ip >> 24;
+      address.sa_data[3] = op->ip >> 16;
+      address.sa_data[4] = op->ip >> 8;
+      address.sa_data[5] = op->ip;
+      op->result = ::connect(op->sd, &address, sizeof(address));
+      break;
+
+    case CC3000_OP_SEND:
+      op->result = ::send(op->sd, op->buf, op->len, op->flags);
+      break;
+
+    case CC3000_OP_RECV:
+      op->result = ::recv(op->sd, op->buf, op->len, op->flags);
+      break;
+
+    case CC3000_OP_CLOSE:
+      op->result = ::closesocket(op->sd);
+      break;
+
+#ifndef CC3000_TINY_DRIVER
+    case CC3000_OP_GETHOSTBYNAME:
+      op->ip = 0;
+      op->result = ::gethostbyname((const char *)op->buf, op->len, &op->ip);
+      break;
+#endif
+
+    default:
+      op->result = EFAIL;
+      break;
+  }
+
+  // An op with a callback is handed back through the callback alone, so
+  // the callback is free to resubmit it
+  if (op->complete)
+  {
+    op->complete(op);
+  }
+  else
+  {
+    __atomic_store_n(&op->done, 1, __ATOMIC_RELEASE);
+  }
+}
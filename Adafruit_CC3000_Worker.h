@@ -0,0 +1,96 @@
+/**************************************************************************/
+/*!
+  @file     Adafruit_CC3000_Worker.h
+
+  Single-owner execution model for the CC3000 driver.
+
+  One task (the worker) owns the SPI/HCI layers and calls process(). Other
+  tasks never call into the driver themselves; they fill in an
+  Adafruit_CC3000_Op and submit it through a lock-free queue, then poll
+  isDone() or get a completion callback from the worker task. This keeps
+  producers off the SPI bus entirely and serializes driver access without
+  a lock.
+
+  Ops are owned by the submitter and must stay alive until they are done.
+*/
+/**************************************************************************/
+
+#ifndef ADAFRUIT_CC3000_WORKER_H
+#define ADAFRUIT_CC3000_WORKER_H
+
+#include "Adafruit_CC3000.h"
+#include "utility/cc3000_queue.h"
+
+#ifndef CC3000_WORKER_QUEUE_SIZE
+#define CC3000_WORKER_QUEUE_SIZE 8  // pending ops, must be a power of two
+#endif
+#ifndef CC3000_WORKER_BATCH
+#define CC3000_WORKER_BATCH      4  // most ops run per process() call
+#endif
+
+typedef enum
+{
+  CC3000_OP_SOCKET,
+  CC3000_OP_CONNECT,
+  CC3000_OP_SEND,
+  CC3000_OP_RECV,
+  CC3000_OP_CLOSE,
+#ifndef CC3000_TINY_DRIVER
+  CC3000_OP_GETHOSTBYNAME,
+#endif
+} cc3000_opcode_t;
+
+struct Adafruit_CC3000_Op;
+typedef void (*cc3000_op_complete_t)(Adafruit_CC3000_Op *op);
+
+struct Adafruit_CC3000_Op
+{
+  uint8_t          code;        // cc3000_opcode_t
+  volatile uint8_t done;        // set by the worker once result is valid
+
+  int32_t          sd;          // socket for connect/send/recv/close
+  void            *buf;         // send/recv data, gethostbyname name
+  uint16_t         len;
+  uint32_t         flags;
+  uint32_t         ip;          // connect address, gethostbyname result
+  uint16_t         port;        // connect port, socket type
+
+  int32_t          result;      // return value of the driver call
+
+  cc3000_op_complete_t complete; // optional, called from the worker task
+                                 // instead of setting done
+  void            *user;
+};
+
+class Adafruit_CC3000_Worker {
+  public:
+    Adafruit_CC3000_Worker(Adafruit_CC3000 &cc3000);
+
+    /* Producer side, safe from any task; false if the queue is full.
+       The helpers set the op's callback, NULL to poll isDone() instead. */
+    bool     submit(Adafruit_CC3000_Op *op);
+    bool     socket(Adafruit_CC3000_Op *op, bool udp = false, cc3000_op_complete_t complete = NULL);
+    bool     connect(Adafruit_CC3000_Op *op, int32_t sd, uint32_t ip, uint16_t port,
+                     cc3000_op_complete_t complete = NULL);
+    bool     send(Adafruit_CC3000_Op *op, int32_t sd, const void *buf, uint16_t len, uint32_t flags = 0,
+                  cc3000_op_complete_t complete = NULL);
+    bool     recv(Adafruit_CC3000_Op *op, int32_t sd, void *buf, uint16_t len, uint32_t flags = 0,
+                  cc3000_op_complete_t complete = NULL);
+    bool     close(Adafruit_CC3000_Op *op, int32_t sd, cc3000_op_complete_t complete = NULL);
+#ifndef CC3000_TINY_DRIVER
+    bool     gethostbyname(Adafruit_CC3000_Op *op, const char *hostname,
+                           cc3000_op_complete_t complete = NULL);
+#endif
+    static bool isDone(const Adafruit_CC3000_Op *op);
+
+    /* Worker side, only from the task that owns the driver */
+    uint8_t  process(uint8_t maxOps = CC3000_WORKER_BATCH);
+
+  private:
+    Adafruit_CC3000 *_cc3000;
+    cc3000_mpsc_queue<Adafruit_CC3000_Op *, CC3000_WORKER_QUEUE_SIZE> _queue;
+
+    void     execute(Adafruit_CC3000_Op *op);
+};
+
+#endif
@@ -47,8 +47,16 @@
 #include "utility/evnt_handler.h"
 #include "utility/cc3000_common.h"
 #include "utility/debug.h"
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
 
-extern uint8_t g_csPin, g_irqPin, g_vbatPin, g_IRQnum, g_SPIspeed;
+/* Driver state of every module, the current one is cc3000_ctx */
+tCC3000Context cc3000_contexts[CC3000_MAX_INSTANCES];
+#if CC3000_MAX_INSTANCES > 1
+tCC3000Context * volatile cc3000_ctx = &cc3000_contexts[0];
+#endif
+static uint8_t ccspi_num_contexts = 0;
 
 #define READ                            (3)
 #define WRITE                           (1)
@@ -74,8 +82,12 @@ this is so that we can have multiple SPI devices
 on the same bus, so they can operate at different speeds
 and in different modes
 */
+#define ccspi_mySPCR      (cc3000_ctx->mySPCR)
+#define ccspi_mySPSR      (cc3000_ctx->mySPSR)
+#define ccspi_mySPICTRL   (cc3000_ctx->mySPCR)
+
 #if defined(SPI2X) && defined(__AVR__) // most likely AVR8
-uint8_t ccspi_mySPCR, ccspi_mySPSR, ccspi_oldSPSR, ccspi_oldSPCR;
+uint8_t ccspi_oldSPSR, ccspi_oldSPCR;
 #define SpiConfigStoreOld() {             \
   ccspi_oldSPCR = SPCR;                   \
   ccspi_oldSPSR = SPSR & _BV(SPI2X); }
@@ -94,7 +106,7 @@ uint8_t ccspi_mySPCR, ccspi_mySPSR, ccspi_oldSPSR, ccspi_oldSPCR;
   else              SPSR &= ~_BV(SPI2X); }
 
 #elif defined(__AVR_XMEGA__) // most likely XMEGA
-uint8_t ccspi_mySPICTRL, ccspi_oldSPICTRL;
+uint8_t ccspi_oldSPICTRL;
 #define SpiConfigStoreOld()		do { ccspi_oldSPICTRL = SPCR; } while (0)
 #define SpiConfigStoreMy()		do { ccspi_mySPICTRL = SPCR; } while (0)
 #define SpiConfigPush()			do { ccspi_oldSPICTRL = SPCR; SPCR = ccspi_mySPICTRL; } while (0)
@@ -108,36 +120,78 @@ uint8_t ccspi_mySPICTRL, ccspi_oldSPICTRL;
 #define SpiConfigPop()			do {  } while (0)
 #endif
 
+/*
+the CS and IRQ pins are resolved to their port registers in init_spi when
+CC3000_FAST_PINS is set (see cc3000_context.h)
+*/
+#ifdef CC3000_FAST_PINS
+#define ccspi_csPort      (cc3000_ctx->csPort)
+#define ccspi_csMask      (cc3000_ctx->csMask)
+#define ccspi_irqPort     (cc3000_ctx->irqPort)
+#define ccspi_irqMask     (cc3000_ctx->irqMask)
+
+#if defined(__AVR__)
+// same as digitalWrite: the port may be shared with pins changed from ISRs
+#define CC3000_CS_WRITE(op) {          \
+  uint8_t ccspi_oldSREG = SREG;        \
+  cli();                               \
+  *ccspi_csPort op;                    \
+  SREG = ccspi_oldSREG; }
+#else
+#define CC3000_CS_WRITE(op)     { *ccspi_csPort op; }
+#endif
+#define CC3000_CS_LOW()         CC3000_CS_WRITE(&= ~ccspi_csMask)
+#define CC3000_CS_HIGH()        CC3000_CS_WRITE(|= ccspi_csMask)
+#define CC3000_READ_IRQ()       ((*ccspi_irqPort & ccspi_irqMask) ? HIGH : LOW)
+#else
+#define CC3000_CS_LOW()         digitalWrite(g_csPin, LOW)
+#define CC3000_CS_HIGH()        digitalWrite(g_csPin, HIGH)
+#define CC3000_READ_IRQ()       digitalRead(g_irqPin)
+#endif
+
+/*
+with several modules on one bus, the module that has CS asserted owns the
+bus until it deasserts; an interrupt from another module is left pending
+and picked up by cc3k_int_poll afterwards (the IRQ line stays low)
+*/
+#if CC3000_MAX_INSTANCES > 1
+static tCC3000Context * volatile ccspi_bus_owner = 0;
+#define CC3000_BUS_TAKE()       (ccspi_bus_owner = cc3000_ctx)
+#define CC3000_BUS_RELEASE()    (ccspi_bus_owner = 0)
+#define CC3000_BUS_BUSY()       (ccspi_bus_owner && ccspi_bus_owner != cc3000_ctx)
+#else
+#define CC3000_BUS_TAKE()
+#define CC3000_BUS_RELEASE()
+#define CC3000_BUS_BUSY()       (0)
+#endif
+
 // CC3000 chip select + SPI config
 #define CC3000_ASSERT_CS {     \
-  digitalWrite(g_csPin, LOW);  \
+  CC3000_BUS_TAKE();           \
+  CC3000_CS_LOW();             \
   SpiConfigPush(); }
 // CC3000 chip deselect + SPI restore
 #define CC3000_DEASSERT_CS {   \
-  digitalWrite(g_csPin, HIGH); \
-  SpiConfigPop(); }
+  CC3000_CS_HIGH();            \
+  SpiConfigPop();              \
+  CC3000_BUS_RELEASE(); }
 
 
 /* smartconfig flags (defined in Adafruit_CC3000.cpp) */
 // extern unsigned long ulSmartConfigFinished, ulCC3000DHCP;
 
-typedef struct
-{
-  gcSpiHandleRx  SPIRxHandler;
-
-  unsigned short usTxPacketLength;
-  unsigned short usRxPacketLength;
-  unsigned long  ulSpiState;
-  unsigned char *pTxPacket;
-  unsigned char *pRxPacket;
-
-} tSpiInformation;
-
-tSpiInformation sSpiInformation;
-
 /* Static buffer for 5 bytes of SPI HEADER */
 unsigned char tSpiReadHeader[] = {READ, 0, 0, 0, 0};
 
+/* Work to do while spinning on the SPI state, in case nothing else drives it */
+#if defined(CC3000_POLLED)
+#define SpiWaitPoll()     { cc3k_int_poll(); cc3000_idle(); }
+#elif defined(CC3000_DEFERRED_RX)
+#define SpiWaitPoll()     { SpiIrqBottomHalf(); cc3000_idle(); }
+#else
+#define SpiWaitPoll()     { cc3000_idle(); }
+#endif
+
 void SpiWriteDataSynchronous(unsigned char *data, unsigned short size);
 #ifndef CC3000_TINY_DRIVER
 void SpiWriteAsync(const unsigned char *data, unsigned short size);
@@ -153,11 +207,80 @@ void cc3k_int_poll(void);
 // or send function will stuck forever.
 #define CC3000_BUFFER_MAGIC_NUMBER (0xDE)
 
-char spi_buffer[CC3000_RX_BUFFER_SIZE];
-unsigned char wlan_tx_buffer[CC3000_TX_BUFFER_SIZE];
+#define ccspi_is_in_irq         (cc3000_ctx->isInIrq)
+#define ccspi_int_enabled       (cc3000_ctx->intEnabled)
+#ifdef CC3000_DEFERRED_RX
+#define ccspi_irq_pending       (cc3000_ctx->irqPending)
+#define ccspi_in_bottom_half    (cc3000_ctx->inBottomHalf)
+#endif
+#ifdef CC3000_ISR_TIMING
+static volatile unsigned long ccspi_isr_max_us = 0;
+#endif
+
+#if CC3000_MAX_INSTANCES > 1
+/* One interrupt handler per module, each running SPI_IRQ on its own context */
+template <uint8_t N>
+static void SpiIrqInstance(void)
+{
+  tCC3000Context *prev = cc3000_ctx;
+  cc3000_ctx = &cc3000_contexts[N];
+  SPI_IRQ();
+  cc3000_ctx = prev;
+}
+
+static void (* const ccspi_irq_handlers[CC3000_MAX_INSTANCES])(void) = {
+  SpiIrqInstance<0>, SpiIrqInstance<1>,
+#if CC3000_MAX_INSTANCES > 2
+  SpiIrqInstance<2>,
+#endif
+#if CC3000_MAX_INSTANCES > 3
+  SpiIrqInstance<3>,
+#endif
+};
+#define CC3000_IRQ_HANDLER      ccspi_irq_handlers[cc3000_ctx - cc3000_contexts]
+#else
+#define CC3000_IRQ_HANDLER      SPI_IRQ
+#endif
+
+/**************************************************************************/
+/*!
+    Hands out the driver context for a new Adafruit_CC3000, or NULL once
+    all CC3000_MAX_INSTANCES contexts are taken (two modules must never
+    share one).
+ */
+/**************************************************************************/
+tCC3000Context *cc3000_ctx_alloc(void)
+{
+  if (ccspi_num_contexts >= CC3000_MAX_INSTANCES)
+  {
+    return 0;
+  }
+  tCC3000Context *ctx = &cc3000_contexts[ccspi_num_contexts++];
+
+  ctx->socketActiveStatus = SOCKET_STATUS_INIT_VAL;
+  ctx->waitTimeout = CC3000_WAIT_TIMEOUT_MS;
+  return ctx;
+}
+
+/* Deadlines for the blocking waits, see cc3000_common.h */
+unsigned long cc3000_set_wait_timeout(unsigned long ulTimeout)
+{
+  unsigned long old = cc3000_ctx->waitTimeout;
+
+  cc3000_ctx->waitTimeout = ulTimeout;
+  return old;
+}
+
+unsigned long cc3000_wait_start(void)
+{
+  return millis();
+}
 
-static volatile char ccspi_is_in_irq = 0;
-static volatile char ccspi_int_enabled = 0;
+int cc3000_wait_expired(unsigned long ulStart)
+{
+  return (cc3000_ctx->waitTimeout != 0) &&
+         ((millis() - ulStart) >= cc3000_ctx->waitTimeout);
+}
 
 /* Mandatory functions are:
     - SpiOpen
@@ -188,6 +311,14 @@ void SpiClose(void)
 
   /*  Disable Interrupt in GPIOA module... */
   tSLInformation.WlanInterruptDisable();
+
+  /* A transfer cut short (the module was stopped to recover it) mustn't
+   * leave the chip selected */
+  if (sSpiInformation.ulSpiState >= eSPI_STATE_WRITE_IRQ)
+  {
+    sSpiInformation.ulSpiState = eSPI_STATE_IDLE;
+    CC3000_DEASSERT_CS;
+  }
 }
 
 /**************************************************************************/
@@ -219,6 +350,10 @@ void SpiOpen(gcSpiHandleRx pfRxHandler)
   DEBUGPRINT_F("\tCC3000: Finished SpiOpen\n\r");
 }
 
+#ifndef CC3000_POWER_OFF_MS
+#define CC3000_POWER_OFF_MS 500   // see cc3000_common.h
+#endif
+
 /**************************************************************************/
 /*!
 
@@ -232,7 +367,7 @@ int init_spi(void)
   /* Set POWER_EN pin to output and disable the CC3000 by default */
   pinMode(g_vbatPin, OUTPUT);
   digitalWrite(g_vbatPin, 0);
-  delay(500);
+  delay(CC3000_POWER_OFF_MS);
 
   /* Set CS pin to output (don't de-assert yet) */
   pinMode(g_csPin, OUTPUT);
@@ -245,6 +380,13 @@ int init_spi(void)
   digitalWrite(g_irqPin, HIGH); // w/weak pullup
 #endif
 
+#ifdef CC3000_FAST_PINS
+  ccspi_csPort  = portOutputRegister(digitalPinToPort(g_csPin));
+  ccspi_csMask  = digitalPinToBitMask(g_csPin);
+  ccspi_irqPort = portInputRegister(digitalPinToPort(g_irqPin));
+  ccspi_irqMask = digitalPinToBitMask(g_irqPin);
+#endif
+
   SpiConfigStoreOld(); // prime ccspi_old* values for DEASSERT
 
   /* Initialise SPI (Mode 1) */
@@ -305,6 +447,7 @@ long SpiFirstWrite(unsigned char *ucBuf, unsigned short usLength)
 long SpiWrite(unsigned char *pUserBuffer, unsigned short usLength)
 {
   unsigned char ucPad = 0;
+  unsigned long ulStart = cc3000_wait_start();
 
   DEBUGPRINT_F("\tCC3000: SpiWrite\n\r");
   
@@ -324,16 +467,28 @@ long SpiWrite(unsigned char *pUserBuffer, unsigned short usLength)
 
   /* The magic number that resides at the end of the TX/RX buffer (1 byte after the allocated size)
    * for the purpose of overrun detection. If the magic number is overwritten - buffer overrun
-   * occurred - and we will be stuck here forever! */
+   * occurred - and the module has to be restarted, see Adafruit_CC3000::recover() */
   if (wlan_tx_buffer[CC3000_TX_BUFFER_SIZE - 1] != CC3000_BUFFER_MAGIC_NUMBER)
   {
     DEBUGPRINT_F("\tCC3000: Error - No magic number found in SpiWrite\n\r");
-    while (1);
+    cc3000_ctx->fault = CC3000_FAULT_OVERRUN;
+    cc3000_ctx->txTimedOut = 1;
+    return(EFAIL);
   }
 
+  cc3000_ctx->txTimedOut = 0;
+
   if (sSpiInformation.ulSpiState == eSPI_STATE_POWERUP)
   {
-    while (sSpiInformation.ulSpiState != eSPI_STATE_INITIALIZED);
+    while (sSpiInformation.ulSpiState != eSPI_STATE_INITIALIZED)
+    {
+      SpiWaitPoll();
+      if (cc3000_wait_expired(ulStart))
+      {
+        cc3000_ctx->txTimedOut = 1;
+        return(ERROR_WAIT_TIMEOUT);
+      }
+    }
   }
 
   if (sSpiInformation.ulSpiState == eSPI_STATE_INITIALIZED)
@@ -347,7 +502,17 @@ long SpiWrite(unsigned char *pUserBuffer, unsigned short usLength)
      * device, so the state will move to IDLE and once again to not IDLE due to IRQ */
     tSLInformation.WlanInterruptDisable();
 
-    while (sSpiInformation.ulSpiState != eSPI_STATE_IDLE);
+    while (sSpiInformation.ulSpiState != eSPI_STATE_IDLE)
+    {
+      /* A read may have been signalled but not clocked in yet */
+      SpiWaitPoll();
+      if (cc3000_wait_expired(ulStart))
+      {
+        tSLInformation.WlanInterruptEnable();
+        cc3000_ctx->txTimedOut = 1;
+        return(ERROR_WAIT_TIMEOUT);
+      }
+    }
 
     sSpiInformation.ulSpiState = eSPI_STATE_WRITE_IRQ;
     sSpiInformation.pTxPacket = pUserBuffer;
@@ -372,7 +537,29 @@ long SpiWrite(unsigned char *pUserBuffer, unsigned short usLength)
 
   /* Due to the fact that we are currently implementing a blocking situation
    * here we will wait till end of transaction */
-  while (eSPI_STATE_IDLE != sSpiInformation.ulSpiState);
+  while (eSPI_STATE_IDLE != sSpiInformation.ulSpiState)
+  {
+    SpiWaitPoll();
+    if (cc3000_wait_expired(ulStart))
+    {
+      tSLInformation.WlanInterruptDisable();
+      if (eSPI_STATE_IDLE == sSpiInformation.ulSpiState)
+      {
+        /* Finished just now after all */
+        tSLInformation.WlanInterruptEnable();
+        break;
+      }
+      if (sSpiInformation.ulSpiState == eSPI_STATE_WRITE_IRQ)
+      {
+        /* The IRQ for our write never came: drop the packet, free the bus */
+        sSpiInformation.ulSpiState = eSPI_STATE_IDLE;
+        CC3000_DEASSERT_CS;
+      }
+      tSLInformation.WlanInterruptEnable();
+      cc3000_ctx->txTimedOut = 1;
+      return(ERROR_WAIT_TIMEOUT);
+    }
+  }
 
   return(0);
 }
@@ -508,7 +695,9 @@ void SpiPauseSpi(void)
   DEBUGPRINT_F("\tCC3000: SpiPauseSpi\n\r");
 
   ccspi_int_enabled = 0;
+#ifndef CC3000_POLLED
   detachInterrupt(g_IRQnum);
+#endif
 }
 
 /**************************************************************************/
@@ -521,7 +710,9 @@ void SpiResumeSpi(void)
   DEBUGPRINT_F("\tCC3000: SpiResumeSpi\n\r");
 
   ccspi_int_enabled = 1;
-  attachInterrupt(g_IRQnum, SPI_IRQ, FALLING);
+#ifndef CC3000_POLLED
+  attachInterrupt(g_IRQnum, CC3000_IRQ_HANDLER, FALLING);
+#endif
 }
 
 /**************************************************************************/
@@ -540,12 +731,14 @@ void SpiTriggerRxProcessing(void)
   //DEBUGPRINT_F("Magic?\n\r");
   /* The magic number that resides at the end of the TX/RX buffer (1 byte after the allocated size)
    * for the purpose of detection of the overrun. If the magic number is overriten - buffer overrun
-   * occurred - and we will stuck here forever! */
+   * occurred - the packet is dropped and the SPI stays paused until the module is restarted */
   if (sSpiInformation.pRxPacket[CC3000_RX_BUFFER_SIZE - 1] != CC3000_BUFFER_MAGIC_NUMBER)
   {
     /* You've got problems if you're here! */
     DEBUGPRINT_F("\tCC3000: ERROR - magic number missing!\n\r");
-    while (1);
+    cc3000_ctx->fault = CC3000_FAULT_OVERRUN;
+    sSpiInformation.ulSpiState = eSPI_STATE_IDLE;
+    return;
   }
 
   //DEBUGPRINT_F("OK!\n\r");
@@ -572,6 +765,39 @@ void SSIContReadOperation(void)
   }
 }
 
+/**************************************************************************/
+/*!
+    Changes the SPI clock used for CC3000 transactions. The other SPI
+    settings stay as set up by init_spi(), and the bus is handed back in
+    the state it was found in. Only call this between transactions.
+ */
+/**************************************************************************/
+void SpiSetClockDivider(uint8_t div)
+{
+  g_SPIspeed = div;
+
+  SpiConfigPush();
+  SPI.setClockDivider(div);
+  SpiConfigStoreMy();
+  SpiConfigPop();
+}
+
+/**************************************************************************/
+/*!
+    Selects/deselects the CC3000 (including the SPI settings switch), the
+    same way the transfer functions do. Mostly useful for benchmarking.
+ */
+/**************************************************************************/
+void SpiAssertCS(void)
+{
+  CC3000_ASSERT_CS;
+}
+
+void SpiDeassertCS(void)
+{
+  CC3000_DEASSERT_CS;
+}
+
 /**************************************************************************/
 /*!
 
@@ -604,10 +830,10 @@ void WriteWlanPin( unsigned char val )
 long ReadWlanInterruptPin(void)
 {
   DEBUGPRINT_F("\tCC3000: ReadWlanInterruptPin - ");
-  DEBUGPRINT_DEC(digitalRead(g_irqPin));
+  DEBUGPRINT_DEC(CC3000_READ_IRQ());
   DEBUGPRINT_F("\n\r");
 
-  return(digitalRead(g_irqPin));
+  return(CC3000_READ_IRQ());
 }
 
 /**************************************************************************/
@@ -620,7 +846,9 @@ void WlanInterruptEnable()
   DEBUGPRINT_F("\tCC3000: WlanInterruptEnable.\n\r");
   // delay(100);
   ccspi_int_enabled = 1;
-  attachInterrupt(g_IRQnum, SPI_IRQ, FALLING);
+#ifndef CC3000_POLLED
+  attachInterrupt(g_IRQnum, CC3000_IRQ_HANDLER, FALLING);
+#endif
 }
 
 /**************************************************************************/
@@ -632,7 +860,9 @@ void WlanInterruptDisable()
 {
   DEBUGPRINT_F("\tCC3000: WlanInterruptDisable\n\r");
   ccspi_int_enabled = 0;
+#ifndef CC3000_POLLED
   detachInterrupt(g_IRQnum);
+#endif
 }
 
 #ifndef CC3000_NO_PATCH
@@ -696,6 +926,16 @@ char *sendWLFWPatch(unsigned long *Length) {
 
 void SPI_IRQ(void)
 {
+#ifdef CC3000_ISR_TIMING
+  unsigned long ulIsrStart = micros();
+#endif
+
+  /* Another module is mid-transaction, cc3k_int_poll will get back to us */
+  if (CC3000_BUS_BUSY())
+  {
+    return;
+  }
+
   ccspi_is_in_irq = 1;
 
   DEBUGPRINT_F("\tCC3000: Entering SPI_IRQ\n\r");
@@ -711,6 +951,10 @@ void SPI_IRQ(void)
     sSpiInformation.ulSpiState = eSPI_STATE_READ_IRQ;    
     /* IRQ line goes down - start reception */
 
+#ifdef CC3000_DEFERRED_RX
+    /* Only note the edge, the frame is clocked in by SpiIrqBottomHalf */
+    ccspi_irq_pending = 1;
+#else
     CC3000_ASSERT_CS;
 
     // Wait for TX/RX Compete which will come as DMA interrupt
@@ -718,20 +962,110 @@ void SPI_IRQ(void)
     sSpiInformation.ulSpiState = eSPI_STATE_READ_EOT;
     //DEBUGPRINT_F("SSICont\n\r");
     SSIContReadOperation();
+#endif
   }
   else if (sSpiInformation.ulSpiState == eSPI_STATE_WRITE_IRQ)
   {
+#ifdef CC3000_DEFERRED_RX
+    ccspi_irq_pending = 1;
+#else
     SpiWriteDataSynchronous(sSpiInformation.pTxPacket, sSpiInformation.usTxPacketLength);
     sSpiInformation.ulSpiState = eSPI_STATE_IDLE;
     CC3000_DEASSERT_CS;
+#endif
   }
 
   DEBUGPRINT_F("\tCC3000: Leaving SPI_IRQ\n\r");
 
   ccspi_is_in_irq = 0;
+
+  /* Wake up whoever waits on the SPI state or a received frame */
+  CC3000_OS_SIGNAL_EVENT();
+
+#ifdef CC3000_ISR_TIMING
+  unsigned long ulIsrTime = micros() - ulIsrStart;
+  if (ulIsrTime > ccspi_isr_max_us)
+  {
+    ccspi_isr_max_us = ulIsrTime;
+  }
+#endif
   return;
 }
 
+#ifdef CC3000_DEFERRED_RX
+/**************************************************************************/
+/*!
+    Performs the SPI transfer that SPI_IRQ only signalled. This runs in
+    task context (from cc3k_int_poll and the SpiWrite wait loops), so
+    other interrupts stay enabled while the frame is clocked in or out.
+ */
+/**************************************************************************/
+void SpiIrqBottomHalf(void)
+{
+  if (ccspi_irq_pending == 0 || ccspi_in_bottom_half != 0)
+  {
+    return;
+  }
+
+  ccspi_in_bottom_half = 1;
+  ccspi_irq_pending = 0;
+
+  if (sSpiInformation.ulSpiState == eSPI_STATE_READ_IRQ)
+  {
+    CC3000_ASSERT_CS;
+
+    SpiReadHeader();
+    sSpiInformation.ulSpiState = eSPI_STATE_READ_EOT;
+    SSIContReadOperation();
+  }
+  else if (sSpiInformation.ulSpiState == eSPI_STATE_WRITE_IRQ)
+  {
+    SpiWriteDataSynchronous(sSpiInformation.pTxPacket, sSpiInformation.usTxPacketLength);
+    sSpiInformation.ulSpiState = eSPI_STATE_IDLE;
+    CC3000_DEASSERT_CS;
+  }
+
+  ccspi_in_bottom_half = 0;
+}
+#endif
+
+#ifdef CC3000_ISR_TIMING
+/**************************************************************************/
+/*!
+    Returns the longest time (in microseconds) spent in SPI_IRQ since the
+    last call to SpiResetMaxIsrTime
+ */
+/**************************************************************************/
+unsigned long SpiGetMaxIsrTime(void)
+{
+  unsigned long ulMax;
+
+  noInterrupts();
+  ulMax = ccspi_isr_max_us;
+  interrupts();
+
+  return ulMax;
+}
+
+void SpiResetMaxIsrTime(void)
+{
+  noInterrupts();
+  ccspi_isr_max_us = 0;
+  interrupts();
+}
+#endif
+
+/* Checks the IRQ line of the current module (its pins may not be set up yet) */
+static void SpiPollContext(void)
+{
+  if (ccspi_int_enabled != 0 && ccspi_is_in_irq == 0 && CC3000_READ_IRQ() == LOW) {
+    SPI_IRQ();
+  }
+#ifdef CC3000_DEFERRED_RX
+  SpiIrqBottomHalf();
+#endif
+}
+
 //*****************************************************************************
 //
 //!  cc3k_int_poll
@@ -744,7 +1078,61 @@ void SPI_IRQ(void)
 
 void cc3k_int_poll()
 {
-  if (digitalRead(g_irqPin) == LOW && ccspi_is_in_irq == 0 && ccspi_int_enabled != 0) {
-    SPI_IRQ();
+  CC3000_DRIVER_LOCK();
+
+#if CC3000_MAX_INSTANCES > 1
+  /* Keep every module going, not just the one we are waiting on */
+  tCC3000Context *prev = cc3000_ctx;
+  for (uint8_t i = 0; i < ccspi_num_contexts; i++)
+  {
+    cc3000_ctx = &cc3000_contexts[i];
+    SpiPollContext();
+  }
+  cc3000_ctx = prev;
+#else
+  SpiPollContext();
+#endif
+}
+
+//*****************************************************************************
+//
+//  Idle hook, see cc3000_common.h
+//
+//*****************************************************************************
+
+static cc3000_idle_hook_t ccspi_idle_hook = 0;
+
+void cc3000_set_idle_hook(cc3000_idle_hook_t hook)
+{
+  ccspi_idle_hook = hook;
+}
+
+void cc3000_idle(void)
+{
+  if (ccspi_idle_hook)
+  {
+    ccspi_idle_hook();
+  }
+  CC3000_OS_WAIT_EVENT();
+}
+
+void cc3k_delay(unsigned long ms)
+{
+  unsigned long start = millis();
+
+  while (millis() - start < ms)
+  {
+    cc3000_idle();
   }
 }
+
+void cc3000_idle_sleep(void)
+{
+#if defined(__AVR__)
+  /* Any interrupt wakes us: the CC3000 IRQ, or at the latest the millis() tick */
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#elif defined(__arm__)
+  __asm__ volatile ("wfi");
+#endif
+}
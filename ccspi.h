@@ -61,8 +61,6 @@
 typedef void (*gcSpiHandleRx)(void *p);
 typedef void (*gcSpiHandleTx)(void);
 
-extern unsigned char wlan_tx_buffer[];
-
 //*****************************************************************************
 //
 // Prototypes for the APIs.
@@ -81,12 +79,22 @@ extern void WriteWlanPin( unsigned char val );
 extern long ReadWlanInterruptPin(void);
 extern void WlanInterruptEnable();
 extern void WlanInterruptDisable();
+extern void SpiAssertCS(void);
+extern void SpiDeassertCS(void);
+extern void SpiSetClockDivider(uint8_t div);
 #ifndef CC3000_NO_PATCH
 extern char *sendDriverPatch(unsigned long *Length);
 extern char *sendBootLoaderPatch(unsigned long *Length);
 extern char *sendWLFWPatch(unsigned long *Length);
 #endif
 extern void SPI_IRQ(void);
+#ifdef CC3000_DEFERRED_RX
+extern void SpiIrqBottomHalf(void);
+#endif
+#ifdef CC3000_ISR_TIMING
+extern unsigned long SpiGetMaxIsrTime(void);
+extern void SpiResetMaxIsrTime(void);
+#endif
 
 #endif
 
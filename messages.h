@@ -81,5 +81,10 @@
 #define CC3000_MSG_FAIL_SOCKET_BIND_ADDR    CC3000_MESSAGE("D", "Error binding listen socket to address!")
 #define CC3000_MSG_ERR_OPEN_SOCKET_LISTEN   CC3000_MESSAGE("E", "Error opening socket for listening!")
 #define CC3000_MSG_FAIL_SSID_PARAMS         CC3000_MESSAGE("F", "Failed setting params for SSID scan")
+#define CC3000_MSG_TIMEOUT_START            CC3000_MESSAGE("G", "Timed out starting the CC3000")
+#define CC3000_MSG_FAIL_SET_FAST_CONNECT    CC3000_MESSAGE("H", "Failed setting the fast connect policy")
+#define CC3000_MSG_FAIL_SET_IP_CONFIG       CC3000_MESSAGE("I", "Failed setting the IP configuration")
+#define CC3000_MSG_NO_CONTEXT_LEFT         CC3000_MESSAGE("J", "More modules than CC3000_MAX_INSTANCES")
+#define CC3000_MSG_FAIL_CONNECT_AP          CC3000_MESSAGE("K", "Gave up connecting to the AP")
 
 #endif
@@ -0,0 +1,157 @@
+/***************************************************
+  DnsResolver test
+
+  Designed specifically to work with the Adafruit WiFi products:
+  ----> https://www.adafruit.com/products/1469
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  Checks Adafruit_CC3000_Resolver against two copies of dns_responder.py
+  on the machine at SERVER_IP: a silent one on port 5353 and an answering
+  one on port 5354, e.g.
+
+    python dns_responder.py 5353 --silent
+    python dns_responder.py 5354
+
+  The DNS server from DHCP is left out, it would answer NXDOMAIN for the
+  .test names.  Needs the full driver (CC3000_TINY_DRIVER
+  undefined in utility/cc3000_common.h).
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+
+#include <Adafruit_CC3000.h>
+#include <Adafruit_CC3000_Resolver.h>
+#include <ccspi.h>
+#include <SPI.h>
+#include <string.h>
+#include "utility/debug.h"
+
+#ifdef CC3000_TINY_DRIVER
+#error "Undefine CC3000_TINY_DRIVER in utility/cc3000_common.h to run this test"
+#endif
+
+// These are the interrupt and control pins
+#define ADAFRUIT_CC3000_IRQ   3  // MUST be an interrupt pin!
+// These can be any two pins
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+// Use hardware SPI for the remaining pins
+// On an UNO, SCK = 13, MISO = 12, and MOSI = 11
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT,
+                                         SPI_CLOCK_DIV2); // you can change this clock speed
+Adafruit_CC3000_Resolver resolver = Adafruit_CC3000_Resolver(cc3000);
+
+#define WLAN_SSID       "myNetwork"           // cannot be longer than 32 characters!
+#define WLAN_PASS       "myPassword"
+
+// Security can be WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or WLAN_SEC_WPA2
+#define WLAN_SECURITY   WLAN_SEC_WPA2
+
+// Machine running dns_responder.py
+const uint8_t   SERVER_IP[4]   = { 192, 168, 1, 101 };
+
+#define TIMEOUT  3000
+
+// Resolves a name and checks the number of addresses (or the error)
+void check(const char *name, int8_t expected) {
+  uint32_t addrs[4];
+  unsigned long start = millis();
+  int8_t n = resolver.resolve(name, addrs, 4, TIMEOUT);
+  unsigned long took = millis() - start;
+
+  Serial.print(name); Serial.print(F(": ")); Serial.print(n, DEC);
+  Serial.print(F(" in ")); Serial.print(took, DEC); Serial.print(F(" ms"));
+  for (int8_t i = 0; i < n; i++) {
+    Serial.print(' ');
+    cc3000.printIPdotsRev(addrs[i]);
+  }
+  if (n > 0) {
+    Serial.print(F(" TTL ")); Serial.print(resolver.getTTL(), DEC);
+    Serial.print(F(" from ")); cc3000.printIPdotsRev(resolver.getServer());
+  }
+  Serial.println();
+
+  if (n != expected) {
+    Serial.print(F("FAILURE: Expected ")); Serial.println(expected, DEC);
+  }
+  if ((n == CC3000_RESOLVER_TIMEOUT) && (took > TIMEOUT + 500)) {
+    Serial.println(F("FAILURE: Deadline overrun"));
+  }
+}
+
+// A name of len characters: labels of 'a's ending in .test
+void makeName(char *name, uint16_t len) {
+  memset(name, 'a', len);
+  for (uint16_t i = 40; i < len - 6; i += 41) {
+    name[i] = '.';
+  }
+  memcpy(name + len - 5, ".test", 5);
+  name[len] = 0;
+}
+
+// Set up the HW and the CC3000 module (called automatically on startup)
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println(F("Hello, CC3000!\n"));
+
+  /* Initialise the module */
+  Serial.println(F("\nInitializing..."));
+  if (!cc3000.begin())
+  {
+    Serial.println(F("Couldn't begin()! Check your wiring?"));
+    while(1);
+  }
+
+  if (!cc3000.connectToAP(WLAN_SSID, WLAN_PASS, WLAN_SECURITY)) {
+    Serial.println(F("Failed!"));
+    while(1);
+  }
+  while (!cc3000.checkDHCP())
+  {
+    delay(100);
+  }
+
+  uint32_t server = cc3000.IP2U32(SERVER_IP[0], SERVER_IP[1], SERVER_IP[2], SERVER_IP[3]);
+  resolver.useDHCPServer(false);
+  resolver.addServer(server, 5353);
+  resolver.addServer(server, 5354);
+
+  // The silent server mustn't hold up the answer of the other one
+  check("one.test", 1);
+  check("three.test", 3);
+  // The CNAME takes room in the buffer, the default one only fits two A records
+  check("alias.test", (CC3000_RESOLVER_BUFFER_SIZE >= 100) ? 3 : 2);
+  // A long CNAME leaves no room for the A record: the name exists all the same
+  check("longalias.test", (CC3000_RESOLVER_BUFFER_SIZE >= 126) ? 1 : CC3000_RESOLVER_TRUNCATED);
+  check("empty.test", CC3000_RESOLVER_NOT_FOUND);
+  check("missing.test", CC3000_RESOLVER_NOT_FOUND);
+  check("bad..name", CC3000_RESOLVER_ERROR);
+
+  // The longest name whose query fits the TX buffer (header, length bytes,
+  // root label, type and class come on top of it), and one too long
+  char name[CC3000_RESOLVER_BUFFER_SIZE];
+  makeName(name, CC3000_RESOLVER_BUFFER_SIZE - 18);
+  check(name, CC3000_RESOLVER_NOT_FOUND);
+  makeName(name, CC3000_RESOLVER_BUFFER_SIZE - 17);
+  check(name, CC3000_RESOLVER_ERROR);
+  if (cc3000.getFault() != CC3000_FAULT_NONE) {
+    Serial.println(F("FAILURE: The query overran the TX buffer"));
+  }
+
+  // Nobody answers: the resolver has to give up at the deadline
+  resolver.clearServers();
+  resolver.addServer(server, 5353);
+  Serial.println(F("Only the silent server now"));
+  check("one.test", CC3000_RESOLVER_TIMEOUT);
+
+  Serial.println(F("Done"));
+}
+
+void loop(void)
+{
+ delay(1000);
+}
@@ -0,0 +1,221 @@
+/***************************************************
+  HttpClient test
+
+  Designed specifically to work with the Adafruit WiFi products:
+  ----> https://www.adafruit.com/products/1469
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  Checks Adafruit_CC3000_HTTP against http_server.py on the machine at
+  SERVER_IP, e.g.
+
+    python http_server.py 8080
+
+  Bodies with a Content-Length and chunked ones are checked against the
+  checksum the server sends along, uploads against the length and checksum
+  the server answers with, and the connection count shows whether the
+  connection was kept.  Needs the full driver (CC3000_TINY_DRIVER
+  undefined in utility/cc3000_common.h).
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+
+#include <Adafruit_CC3000.h>
+#include <Adafruit_CC3000_HTTP.h>
+#include <ccspi.h>
+#include <SPI.h>
+#include <string.h>
+#include "utility/debug.h"
+
+#ifdef CC3000_TINY_DRIVER
+#error "Undefine CC3000_TINY_DRIVER in utility/cc3000_common.h to run this test"
+#endif
+
+// These are the interrupt and control pins
+#define ADAFRUIT_CC3000_IRQ   3  // MUST be an interrupt pin!
+// These can be any two pins
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+// Use hardware SPI for the remaining pins
+// On an UNO, SCK = 13, MISO = 12, and MOSI = 11
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT,
+                                         SPI_CLOCK_DIV2); // you can change this clock speed
+Adafruit_CC3000_HTTP http = Adafruit_CC3000_HTTP(cc3000);
+
+#define WLAN_SSID       "myNetwork"           // cannot be longer than 32 characters!
+#define WLAN_PASS       "myPassword"
+
+// Security can be WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or WLAN_SEC_WPA2
+#define WLAN_SECURITY   WLAN_SEC_WPA2
+
+// Machine running http_server.py
+const uint8_t   SERVER_IP[4]   = { 192, 168, 1, 101 };
+#define SERVER_PORT     8080
+#define IDLE_TIMEOUT    5000  // after which the server closes a kept connection
+
+char     checksum[8];
+uint32_t received;
+uint16_t sum;
+
+bool count(const uint8_t *data, uint16_t len) {
+  received += len;
+  while (len--) {
+    sum += *data++;
+  }
+  return true;
+}
+
+bool print(const uint8_t *data, uint16_t len) {
+  Serial.write(data, len);
+  received += len;
+  return true;
+}
+
+// Upload body: byte i is i % 251, like the server's /large
+uint32_t produced, uploadSize;
+
+uint16_t produce(uint8_t *buf, uint16_t len) {
+  uint16_t n = 0;
+  while ((n < len) && (produced < uploadSize)) {
+    buf[n++] = produced++ % 251;
+  }
+  return n;
+}
+
+// Uploads uploadSize bytes (chunked if length is -1) and checks the answer
+void checkUpload(const __FlashStringHelper *name, int32_t length, int16_t expected) {
+  char answer[24];
+  uint16_t expectedSum = 0;
+  int16_t status, n, got = 0;
+
+  for (uint32_t i = 0; i < uploadSize; i++) {
+    expectedSum += i % 251;
+  }
+  produced = 0;
+  unsigned long start = millis();
+  status = http.upload("POST", "/upload", "application/octet-stream", produce, length);
+  while ((status == 200) && ((n = http.read(answer + got, sizeof(answer) - 1 - got)) > 0)) {
+    got += n;
+  }
+  answer[got] = 0;
+
+  Serial.print(name); Serial.print(F(": ")); Serial.print(status, DEC);
+  Serial.print(F(", server got ")); Serial.print(answer);
+  Serial.print(F(" in ")); Serial.print(millis() - start, DEC); Serial.println(F(" ms"));
+
+  if (status != expected) {
+    Serial.print(F("FAILURE: Expected status ")); Serial.println(expected, DEC);
+  }
+  if ((status == 200) && ((uint32_t)atol(answer) != uploadSize ||
+                          (uint16_t)atol(strchr(answer, ' ') + 1) != expectedSum)) {
+    Serial.print(F("FAILURE: Expected ")); Serial.print(uploadSize, DEC);
+    Serial.print(' '); Serial.println(expectedSum, DEC);
+  }
+}
+
+// Checks the status, body length, checksum (if the server sent one) and connections
+void check(const __FlashStringHelper *name, int16_t status, int16_t expected,
+           int32_t length, uint16_t connects) {
+  Serial.print(name); Serial.print(F(": ")); Serial.print(status, DEC);
+  Serial.print(F(", ")); Serial.print(received, DEC); Serial.print(F(" bytes"));
+  Serial.print(F(", connections ")); Serial.println(http.getConnects(), DEC);
+
+  if (status != expected) {
+    Serial.print(F("FAILURE: Expected status ")); Serial.println(expected, DEC);
+  }
+  if ((length >= 0) && (received != (uint32_t)length)) {
+    Serial.print(F("FAILURE: Expected length ")); Serial.println(length, DEC);
+  }
+  if (checksum[0] && received && (sum != (uint16_t)atol(checksum))) {
+    Serial.print(F("FAILURE: Checksum ")); Serial.print(sum, DEC);
+    Serial.print(F(", server says ")); Serial.println(checksum);
+  }
+  if (http.getConnects() != connects) {
+    Serial.print(F("FAILURE: Expected connections ")); Serial.println(connects, DEC);
+  }
+
+  received = 0;
+  sum = 0;
+}
+
+// Set up the HW and the CC3000 module (called automatically on startup)
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println(F("Hello, CC3000!\n"));
+
+  /* Initialise the module */
+  Serial.println(F("\nInitializing..."));
+  if (!cc3000.begin())
+  {
+    Serial.println(F("Couldn't begin()! Check your wiring?"));
+    while(1);
+  }
+
+  if (!cc3000.connectToAP(WLAN_SSID, WLAN_PASS, WLAN_SECURITY)) {
+    Serial.println(F("Failed!"));
+    while(1);
+  }
+  while (!cc3000.checkDHCP())
+  {
+    delay(100);
+  }
+
+  uint32_t server = cc3000.IP2U32(SERVER_IP[0], SERVER_IP[1], SERVER_IP[2], SERVER_IP[3]);
+  http.begin(server, SERVER_PORT, "cc3000.test");
+  http.captureHeader("X-Checksum", checksum, sizeof(checksum));
+
+  // All on one connection
+  check(F("Content-Length"), http.get("/hello", print), 200, 15, 1);
+  check(F("Chunked"), http.get("/chunked", print), 200, 550, 1);
+  unsigned long start = millis();
+  check(F("Large"), http.get("/large?n=20000", count), 200, 20000, 1);
+  Serial.print(F("  took ")); Serial.print(millis() - start, DEC); Serial.println(F(" ms"));
+  check(F("Large chunked"), http.get("/large?n=7777&chunked=1", count), 200, 7777, 1);
+
+  char body[200];
+  memset(body, 'x', sizeof(body));
+  check(F("POST"), http.post("/echo", "text/plain", body, sizeof(body), count), 200, 200, 1);
+  check(F("HEAD"), http.request("HEAD", "/hello", NULL, NULL, 0), 200, 0, 1);
+
+  // Reading the body with read() instead of a callback
+  int16_t status = http.get("/large?n=1000");
+  uint8_t buf[32];
+  int16_t n;
+  while ((n = http.read(buf, sizeof(buf))) > 0) {
+    count(buf, n);
+  }
+  check(F("read()"), status, 200, 1000, 1);
+
+  // A short unread body is skipped, a long one costs the connection
+  check(F("Short unread"), http.get("/large?n=100"), 200, -1, 1);
+  check(F("After it"), http.get("/hello", count), 200, 15, 1);
+  check(F("Long unread"), http.get("/large?n=5000"), 200, -1, 1);
+  check(F("After it"), http.get("/hello", count), 200, 15, 2);
+
+  // Uploads straight from a producer
+  uploadSize = 10000;
+  checkUpload(F("Upload chunked"), -1, 200);
+  checkUpload(F("Upload with length"), uploadSize, 200);
+  uploadSize = 100;
+  checkUpload(F("Upload ending early"), 200, CC3000_HTTP_ERR_BODY);
+  received = 0;
+
+  // The server closes the connection after this one
+  check(F("Until close"), http.get("/close", print), 200, 29, 3);
+  check(F("Not found"), http.get("/missing", count), 404, -1, 4);
+
+  // The server drops the kept connection while we're idle
+  delay(IDLE_TIMEOUT + 1000);
+  check(F("Stale connection"), http.get("/hello", print), 200, 15, 5);
+
+  http.stop();
+  Serial.println(F("Done"));
+}
+
+void loop(void)
+{
+ delay(1000);
+}
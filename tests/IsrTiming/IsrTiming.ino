@@ -0,0 +1,121 @@
+/*************************************************** 
+  IsrTiming test
+
+  Designed specifically to work with the Adafruit WiFi products:
+  ----> https://www.adafruit.com/products/1469
+
+  Adafruit invests time and resources providing this open source code, 
+  please support Adafruit and open-source hardware by purchasing 
+  products from Adafruit!
+
+  Measures the longest time spent in the CC3000 SPI interrupt handler while
+  streaming data to a server running listener.py.  The library must be built
+  with CC3000_ISR_TIMING defined in utility/cc3000_common.h.  Run it once
+  without and once with CC3000_DEFERRED_RX defined to compare the interrupt
+  latency of both modes.
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+ 
+#include <Adafruit_CC3000.h>
+#include <ccspi.h>
+#include <SPI.h>
+#include <string.h>
+#include "utility/debug.h"
+
+#ifndef CC3000_ISR_TIMING
+#error "Define CC3000_ISR_TIMING in utility/cc3000_common.h to run this test"
+#endif
+
+// These are the interrupt and control pins
+#define ADAFRUIT_CC3000_IRQ   3  // MUST be an interrupt pin!
+// These can be any two pins
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+// Use hardware SPI for the remaining pins
+// On an UNO, SCK = 13, MISO = 12, and MOSI = 11
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT,
+                                         SPI_CLOCK_DIV2); // you can change this clock speed
+
+#define WLAN_SSID       "myNetwork"           // cannot be longer than 32 characters!
+#define WLAN_PASS       "myPassword"
+
+// Security can be WLAN_SEC_UNSEC, WLAN_SEC_WEP, WLAN_SEC_WPA or WLAN_SEC_WPA2
+#define WLAN_SECURITY   WLAN_SEC_WPA2
+
+// Test server configuration
+const uint8_t   SERVER_IP[4]   = { 192, 168, 1, 101 };
+const uint16_t  SERVER_PORT    = 9000;
+
+#define PACKET_COUNT    100
+
+// Run the test
+void runTest(void) {
+  Serial.println(F("Connecting to server..."));
+  Adafruit_CC3000_Client client = cc3000.connectTCP(cc3000.IP2U32(SERVER_IP[0], SERVER_IP[1], SERVER_IP[2], SERVER_IP[3]), 
+                                                    SERVER_PORT);
+  if (!client.connected()) {
+    Serial.println(F("Couldn't connect to server! Make sure listener.py is running on the server."));
+    while(1);
+  }
+  Serial.println(F("Connected!"));
+
+#ifdef CC3000_DEFERRED_RX
+  Serial.println(F("Mode: deferred RX (bottom half)"));
+#else
+  Serial.println(F("Mode: transfer in SPI_IRQ"));
+#endif
+
+  SpiResetMaxIsrTime();
+  unsigned long start = millis();
+
+  // Every send produces a write transaction and at least one event frame
+  // (send complete, free buffers) that goes through the interrupt handler.
+  for (uint16_t i = 0; i < PACKET_COUNT; i++) {
+    client.fastrprint(F("The quick brown fox jumps over the lazy dog 0123456789\r\n"));
+  }
+
+  unsigned long finish = millis();
+  Serial.print(F("Packets sent: ")); Serial.println(PACKET_COUNT, DEC);
+  Serial.print(F("Time taken (MS): ")); Serial.println(finish - start, DEC);
+  Serial.print(F("Max SPI ISR time (US): ")); Serial.println(SpiGetMaxIsrTime(), DEC);
+
+  client.close();
+  cc3000.disconnect();
+}
+
+// Set up the HW and the CC3000 module (called automatically on startup)
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println(F("Hello, CC3000!\n")); 
+  
+  /* Initialise the module */
+  Serial.println(F("\nInitializing..."));
+  if (!cc3000.begin())
+  {
+    Serial.println(F("Couldn't begin()! Check your wiring?"));
+    while(1);
+  }
+  
+  if (!cc3000.connectToAP(WLAN_SSID, WLAN_PASS, WLAN_SECURITY)) {
+    Serial.println(F("Failed!"));
+    while(1);
+  }
+   
+  Serial.println(F("Connected!"));
+  
+  /* Wait for DHCP to complete */
+  Serial.println(F("Request DHCP"));
+  while (!cc3000.checkDHCP())
+  {
+    delay(100);
+  }  
+
+  runTest();
+}
+
+void loop(void)
+{
+ delay(1000);
+}
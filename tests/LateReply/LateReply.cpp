@@ -0,0 +1,125 @@
+/*
+  Host test of the replies that come after their wait timed out (see
+  CC3000_WAIT_TIMEOUT_MS in utility/cc3000_common.h).
+
+  Two sockets hold different option values and different data.  A call on
+  the first one is made to time out, its reply arriving late, then the same
+  command is called on the second one: it has to get the second socket's
+  value or data, with the late reply dropped, not the first one's.  Then a
+  reply is lost altogether: that may cost the next call of the command,
+  but no more than that.
+
+  Build and run from this folder:
+
+    g++ -std=c++11 -O1 -g -c ../host/host_thread.cpp ../host/cc3000_sim.cpp
+    g++ -std=c++11 -O1 -g -pthread -U_GNU_SOURCE -D_ISOC11_SOURCE -DARDUINO=105 \
+        -DCC3000_POLLED -I../host -I../.. \
+        LateReply.cpp ../host/arduino.cpp ../../Adafruit_CC3000.cpp ../../ccspi.cpp \
+        ../../utility/cc3000_common.cpp ../../utility/cc3000_dns.cpp ../../utility/cc3000_os_pthread.cpp \
+        ../../utility/debug.cpp ../../utility/evnt_handler.cpp ../../utility/hci.cpp ../../utility/netapp.cpp \
+        ../../utility/nvmem.cpp ../../utility/security.cpp ../../utility/sntp.cpp ../../utility/socket.cpp \
+        ../../utility/wlan.cpp host_thread.o cc3000_sim.o -o LateReply
+    ./LateReply
+*/
+#include <Arduino.h>
+#include <stdio.h>
+
+#include "Adafruit_CC3000.h"
+#include "utility/socket.h"
+#include "cc3000_sim.h"
+
+#define ADAFRUIT_CC3000_IRQ   3
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+
+#define WAIT_TIMEOUT  100      // ms
+#define LATE          150000   // us: after the wait, before the next one ends
+
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT);
+
+static int           module;
+static unsigned long failures;
+
+static void check(const char *what, long got, long expected)
+{
+  printf("%-40s %ld", what, got);
+  if (got != expected)
+  {
+    printf(", expected %ld", expected);
+    failures++;
+  }
+  printf("\n");
+}
+
+static long option(long sd)
+{
+  uint32_t  value = 0;
+  socklen_t optlen = sizeof(value);
+  long      n = getsockopt(sd, SOL_SOCKET, SOCKOPT_RECV_TIMEOUT, &value, &optlen);
+
+  return (n == 0) ? (long)value : n;
+}
+
+static long option_late(long sd)
+{
+  long n;
+
+  cc3000_sim_set_latency(module, LATE);
+  n = option(sd);
+  cc3000_sim_set_latency(module, 0);
+  return n;
+}
+
+int main(void)
+{
+  uint32_t value1 = 1111, value2 = 2222;
+  uint8_t  buf[8];
+  long     sd1, sd2, n;
+
+  module = cc3000_sim_add(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT);
+  if (!cc3000.begin())
+  {
+    printf("FAILURE: begin()\n");
+    return 1;
+  }
+  cc3000.setTimeout(WAIT_TIMEOUT);
+
+  sd1 = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  sd2 = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  setsockopt(sd1, SOL_SOCKET, SOCKOPT_RECV_TIMEOUT, &value1, sizeof(value1));
+  setsockopt(sd2, SOL_SOCKET, SOCKOPT_RECV_TIMEOUT, &value2, sizeof(value2));
+
+  // Same command after a timeout
+  check("getsockopt() 1, late", option_late(sd1), ERROR_WAIT_TIMEOUT);
+  check("getsockopt() 2", option(sd2), value2);
+  check("getsockopt() 1", option(sd1), value1);
+
+  // With data following the late reply
+  send(sd1, "one", 3, 0);
+  send(sd2, "two", 3, 0);
+  cc3000_sim_set_latency(module, LATE);
+  check("recv() 1, late", recv(sd1, buf, sizeof(buf), 0), ERROR_WAIT_TIMEOUT);
+  cc3000_sim_set_latency(module, 0);
+  n = recv(sd2, buf, sizeof(buf), 0);
+  check("recv() 2", n, 3);
+  check("recv() 2 data", (n == 3) && !memcmp(buf, "two", 3), 1);
+
+  // A lost reply takes the next call's with it, the one after that works
+  cc3000_sim_lose_events(module, 1);
+  check("getsockopt() 1, lost", option(sd1), ERROR_WAIT_TIMEOUT);
+  check("getsockopt() 2, after a lost reply", option(sd2), ERROR_WAIT_TIMEOUT);
+  check("getsockopt() 2", option(sd2), value2);
+  check("getsockopt() 1", option(sd1), value1);
+
+  check("closesocket() 1", closesocket(sd1), 0);
+  check("closesocket() 2", closesocket(sd2), 0);
+  check("simulator errors", cc3000_sim_errors(module), 0);
+
+  if (failures)
+  {
+    printf("FAILURE: %lu\n", failures);
+    return 1;
+  }
+  printf("Done\n");
+  return 0;
+}
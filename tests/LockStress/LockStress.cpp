@@ -0,0 +1,204 @@
+/*
+  Host stress test of CC3000_THREAD_SAFE (see utility/cc3000_os.h).
+
+  Brings up a simulated module (tests/host) with Adafruit_CC3000::begin()
+  and lets several threads use it at once, each on a socket of its own:
+  socket(), setsockopt() with a value of its own, getsockopt() to read it
+  back, send() of a pattern, recv() of the echo and closesocket().  One
+  more thread calls cc3k_int_poll() all along, as an idle loop would, and
+  takes the free buffer events between the calls.  Every value and byte
+  that comes back is checked, and the simulator checks every frame the
+  driver writes.  Both only hold if the driver lock keeps the command
+  buffer and the reply state to one call at a time.
+
+  Build and run from this folder (the driver is built without _GNU_SOURCE,
+  see tests/host/host_thread.h):
+
+    g++ -std=c++11 -O1 -g -pthread -c ../host/host_thread.cpp ../host/cc3000_sim.cpp
+    g++ -std=c++11 -O1 -g -pthread -U_GNU_SOURCE -D_ISOC11_SOURCE -DARDUINO=105 \
+        -DCC3000_THREAD_SAFE -DCC3000_OS_PTHREAD -DCC3000_POLLED -I../host -I../.. \
+        LockStress.cpp ../host/arduino.cpp ../../Adafruit_CC3000.cpp ../../ccspi.cpp \
+        ../../utility/cc3000_common.cpp ../../utility/cc3000_dns.cpp ../../utility/cc3000_os_pthread.cpp \
+        ../../utility/debug.cpp ../../utility/evnt_handler.cpp ../../utility/hci.cpp ../../utility/netapp.cpp \
+        ../../utility/nvmem.cpp ../../utility/security.cpp ../../utility/sntp.cpp ../../utility/socket.cpp \
+        ../../utility/wlan.cpp host_thread.o cc3000_sim.o -o LockStress
+    ./LockStress [threads] [rounds] [module latency in us]
+
+  Add -fsanitize=thread to both lines to run it under ThreadSanitizer.
+  Built without CC3000_THREAD_SAFE it fails within the first rounds.
+*/
+#include <Arduino.h>
+#include <stdio.h>
+
+#include "Adafruit_CC3000.h"
+#include "ccspi.h"
+#include "utility/socket.h"
+#include "cc3000_sim.h"
+#include "host_thread.h"
+
+#define ADAFRUIT_CC3000_IRQ   3
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+
+#define MAX_THREADS  (CC3000_SIM_SOCKETS - 1)  // one socket left for a thread that leaked one
+#define MAX_PATTERN  48                        // fits the RX buffer with the recv arguments
+#define WAIT_TIMEOUT 2000                      // a lost reply fails the call instead of hanging
+
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT);
+
+struct stress_t
+{
+  int           id;
+  unsigned long rounds;
+  unsigned long failures;
+};
+
+static volatile bool stopping;
+
+static bool fail(stress_t *t, unsigned long round, const char *what, long got, long expected)
+{
+  printf("thread %d round %lu: %s gave %ld, expected %ld\n", t->id, round, what, got, expected);
+  t->failures++;
+  return false;
+}
+
+static bool round_trip(stress_t *t, unsigned long round)
+{
+  uint8_t   out[MAX_PATTERN], in[MAX_PATTERN];
+  uint32_t  value = ((uint32_t)t->id << 24) | round, back = 0;
+  socklen_t optlen = sizeof(back);
+  long      len = 1 + (round * 7 + t->id) % MAX_PATTERN;
+  long      got = 0, n, sd;
+
+  sd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (sd < 0)
+  {
+    return fail(t, round, "socket()", sd, 0);
+  }
+
+  if ((n = setsockopt(sd, SOL_SOCKET, SOCKOPT_RECV_TIMEOUT, &value, sizeof(value))) != 0)
+  {
+    fail(t, round, "setsockopt()", n, 0);
+  }
+  else if ((n = getsockopt(sd, SOL_SOCKET, SOCKOPT_RECV_TIMEOUT, &back, &optlen)) != 0)
+  {
+    fail(t, round, "getsockopt()", n, 0);
+  }
+  else if (back != value)
+  {
+    fail(t, round, "getsockopt() value", back, value);
+  }
+
+  for (long i = 0; i < len; i++)
+  {
+    out[i] = t->id ^ round ^ i;
+  }
+  if ((n = send(sd, out, len, 0)) != len)
+  {
+    fail(t, round, "send()", n, len);
+  }
+  else
+  {
+    while (got < len)
+    {
+      n = recv(sd, in + got, len - got, 0);
+      if (n <= 0)
+      {
+        fail(t, round, "recv()", n, len - got);
+        break;
+      }
+      got += n;
+    }
+    for (long i = 0; i < got; i++)
+    {
+      if (in[i] != out[i])
+      {
+        fail(t, round, "recv() byte", in[i], out[i]);
+        break;
+      }
+    }
+  }
+
+  if ((n = closesocket(sd)) != 0)
+  {
+    fail(t, round, "closesocket()", n, 0);
+  }
+  return true;
+}
+
+static void stress(void *arg)
+{
+  stress_t *t = (stress_t *)arg;
+
+  for (unsigned long round = 0; (round < t->rounds) && (t->failures < 10); round++)
+  {
+    round_trip(t, round);
+  }
+}
+
+static void poll(void *arg)
+{
+  (void)arg;
+  while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE))
+  {
+    cc3k_int_poll();
+    host_thread_yield();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  int           threads = (argc > 1) ? atoi(argv[1]) : 4;
+  unsigned long rounds = (argc > 2) ? atol(argv[2]) : 2000;
+  unsigned long latency = (argc > 3) ? atol(argv[3]) : 0;
+  stress_t      t[MAX_THREADS];
+  void         *handles[MAX_THREADS];
+  unsigned long failures = 0;
+
+  if ((threads < 1) || (threads > MAX_THREADS))
+  {
+    printf("1 to %d threads\n", MAX_THREADS);
+    return 2;
+  }
+
+  int module = cc3000_sim_add(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT);
+  cc3000_sim_set_latency(module, latency);
+  if (!cc3000.begin())
+  {
+    printf("FAILURE: begin()\n");
+    return 1;
+  }
+  cc3000.setTimeout(WAIT_TIMEOUT);
+
+  printf("%d threads, %lu rounds each, module latency %lu us\n", threads, rounds, latency);
+  unsigned long long start = host_nanos();
+
+  void *poller = host_thread_start(poll, NULL);
+  for (int i = 0; i < threads; i++)
+  {
+    t[i].id = i + 1;
+    t[i].rounds = rounds;
+    t[i].failures = 0;
+    handles[i] = host_thread_start(stress, &t[i]);
+  }
+  for (int i = 0; i < threads; i++)
+  {
+    host_thread_join(handles[i]);
+    failures += t[i].failures;
+  }
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  host_thread_join(poller);
+
+  unsigned long long elapsed = host_nanos() - start;
+  printf("%lu packets in %llu ms, %lu malformed or refused\n", cc3000_sim_packets(module),
+         elapsed / 1000000ULL, cc3000_sim_errors(module));
+  failures += cc3000_sim_errors(module);
+
+  if (failures)
+  {
+    printf("FAILURE: %lu\n", failures);
+    return 1;
+  }
+  printf("Done\n");
+  return 0;
+}
@@ -0,0 +1,128 @@
+/***************************************************
+  PinTiming test
+
+  Designed specifically to work with the Adafruit WiFi products:
+  ----> https://www.adafruit.com/products/1469
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  Measures the cost of a chip-select toggle and of an IRQ pin sample as done
+  by the SPI transport, and compares them with plain digitalWrite/digitalRead.
+  The module is initialised (so the pins are resolved) and then powered down
+  with stop(), so toggling CS doesn't start a transaction.  Build the library
+  once without and once with CC3000_SLOW_PINS defined in
+  utility/cc3000_common.h to compare both modes.
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+
+#include <Adafruit_CC3000.h>
+#include <ccspi.h>
+#include <SPI.h>
+#include "utility/debug.h"
+
+// These are the interrupt and control pins
+#define ADAFRUIT_CC3000_IRQ   3  // MUST be an interrupt pin!
+// These can be any two pins
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+// Use hardware SPI for the remaining pins
+// On an UNO, SCK = 13, MISO = 12, and MOSI = 11
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT,
+                                         SPI_CLOCK_DIV2); // you can change this clock speed
+
+#define ITERATIONS      10000
+
+// Print the average time per iteration in nanoseconds
+void report(const __FlashStringHelper *name, unsigned long us) {
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print((us * 1000UL) / ITERATIONS, DEC);
+  Serial.println(F(" ns"));
+}
+
+// Run the test
+void runTest(void) {
+  unsigned long start;
+  volatile long sink = 0;
+
+#ifdef CC3000_SLOW_PINS
+  Serial.println(F("Mode: digitalWrite/digitalRead"));
+#else
+  Serial.println(F("Mode: cached port registers"));
+#endif
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    SpiAssertCS();
+    SpiDeassertCS();
+  }
+  report(F("CS toggle (driver)"), micros() - start);
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    digitalWrite(ADAFRUIT_CC3000_CS, LOW);
+    digitalWrite(ADAFRUIT_CC3000_CS, HIGH);
+  }
+  report(F("CS toggle (digitalWrite)"), micros() - start);
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    sink += ReadWlanInterruptPin();
+  }
+  report(F("IRQ sample (driver)"), micros() - start);
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+    sink += digitalRead(ADAFRUIT_CC3000_IRQ);
+  }
+  report(F("IRQ sample (digitalRead)"), micros() - start);
+
+  // cc3k_int_poll is what every driver wait loop spins on. It only samples
+  // the pin while the interrupt is enabled, and the powered down module
+  // leaves the line high, so no transfer starts.
+  if (ReadWlanInterruptPin() == HIGH) {
+    WlanInterruptEnable();
+    start = micros();
+    for (uint16_t i = 0; i < ITERATIONS; i++) {
+      cc3k_int_poll();
+    }
+    report(F("cc3k_int_poll"), micros() - start);
+    WlanInterruptDisable();
+  } else {
+    Serial.println(F("cc3k_int_poll: skipped, the IRQ line is low"));
+  }
+
+  start = micros();
+  for (uint16_t i = 0; i < ITERATIONS; i++) {
+  }
+  report(F("Empty loop"), micros() - start);
+}
+
+// Set up the HW and the CC3000 module (called automatically on startup)
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println(F("Hello, CC3000!\n"));
+
+  /* Initialise the module */
+  Serial.println(F("\nInitializing..."));
+  if (!cc3000.begin())
+  {
+    Serial.println(F("Couldn't begin()! Check your wiring?"));
+    while(1);
+  }
+
+  /* Power the module down, CS is only toggled locally from here on */
+  cc3000.stop();
+  WlanInterruptDisable();
+
+  runTest();
+}
+
+void loop(void)
+{
+ delay(1000);
+}
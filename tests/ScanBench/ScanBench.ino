@@ -0,0 +1,132 @@
+/***************************************************
+  ScanBench test
+
+  Designed specifically to work with the Adafruit WiFi products:
+  ----> https://www.adafruit.com/products/1469
+
+  Adafruit invests time and resources providing this open source code,
+  please support Adafruit and open-source hardware by purchasing
+  products from Adafruit!
+
+  Measures how long an SSID scan takes with each scan preset: the full
+  survey and the fast scan of the channels in FAST_CHANNELS.  A scan counts
+  as done once the CC3000 reports valid results.  Doesn't need a network,
+  but set FAST_CHANNELS to the channels your APs are on.  Needs the full
+  driver (CC3000_TINY_DRIVER undefined in utility/cc3000_common.h).
+
+  BSD license, all text above must be included in any redistribution
+ ****************************************************/
+
+#include <Adafruit_CC3000.h>
+#include <ccspi.h>
+#include <SPI.h>
+#include <string.h>
+#include "utility/debug.h"
+
+#ifdef CC3000_TINY_DRIVER
+#error "Undefine CC3000_TINY_DRIVER in utility/cc3000_common.h to run this test"
+#endif
+
+// These are the interrupt and control pins
+#define ADAFRUIT_CC3000_IRQ   3  // MUST be an interrupt pin!
+// These can be any two pins
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+// Use hardware SPI for the remaining pins
+// On an UNO, SCK = 13, MISO = 12, and MOSI = 11
+Adafruit_CC3000 cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT,
+                                         SPI_CLOCK_DIV2); // you can change this clock speed
+
+// The channels the fast preset scans
+#define FAST_CHANNELS   (CC3000_SCAN_CHANNEL(1) | CC3000_SCAN_CHANNEL(6) | CC3000_SCAN_CHANNEL(11))
+
+#define SCAN_ROUNDS     5
+#define SCAN_TIMEOUT    10000
+
+ResultStruct_t results;
+
+// Runs one scan, returns its duration in ms (0 on a timeout)
+unsigned long timeScan(uint32_t *networks) {
+  cc3000.scanSSIDs(0);
+  delay(100);
+
+  unsigned long start = millis();
+  cc3000.scanSSIDs(1000);
+
+  while (millis() - start < SCAN_TIMEOUT) {
+    if ((wlan_ioctl_get_scan_results(0, (uint8_t *)&results) == 0) &&
+        (results.scan_status == 1) && (results.num_networks > 0)) {
+      *networks = results.num_networks;
+      return millis() - start;
+    }
+    delay(10);
+  }
+
+  return 0;
+}
+
+void runPreset(uint8_t preset, const __FlashStringHelper *name) {
+  cc3000_scan_config_t config;
+  unsigned long total = 0;
+  uint8_t done = 0;
+  uint32_t networks = 0;
+
+  cc3000.setScanPreset(preset, FAST_CHANNELS);
+  cc3000.getScanConfig(&config);
+
+  Serial.print(F("Preset: ")); Serial.println(name);
+  Serial.print(F("Channel mask: 0x")); Serial.println(config.channelMask, HEX);
+  Serial.print(F("Configured scan time (MS): ")); Serial.println(config.scanTime, DEC);
+  if ((preset == CC3000_SCAN_SURVEY) && (config.channelMask != CC3000_SCAN_ALL_CHANNELS)) {
+    Serial.println(F("FAILURE: The survey doesn't scan all channels"));
+  }
+
+  for (uint8_t i = 0; i < SCAN_ROUNDS; i++) {
+    unsigned long t = timeScan(&networks);
+    if (t) {
+      total += t;
+      done++;
+    }
+  }
+
+  Serial.print(F("Scans completed: ")); Serial.print(done, DEC);
+  Serial.print(F(" of ")); Serial.println(SCAN_ROUNDS, DEC);
+  if (done) {
+    Serial.print(F("Average scan time (MS): ")); Serial.println(total / done, DEC);
+    Serial.print(F("Networks found (last scan): ")); Serial.println(networks, DEC);
+  }
+  Serial.println();
+}
+
+// Set up the HW and the CC3000 module (called automatically on startup)
+void setup(void)
+{
+  Serial.begin(115200);
+  Serial.println(F("Hello, CC3000!\n"));
+
+  /* Initialise the module */
+  Serial.println(F("\nInitializing..."));
+  if (!cc3000.begin())
+  {
+    Serial.println(F("Couldn't begin()! Check your wiring?"));
+    while(1);
+  }
+
+  // What begin() read back from the NVMEM, the survey unless a sketch left another preset
+  cc3000_scan_config_t saved;
+  cc3000.getScanConfig(&saved);
+  Serial.print(F("Saved channel mask: 0x")); Serial.print(saved.channelMask, HEX);
+  Serial.print(F(", scan time (MS): ")); Serial.println(saved.scanTime, DEC);
+  Serial.println();
+
+  runPreset(CC3000_SCAN_SURVEY, F("survey"));
+  runPreset(CC3000_SCAN_FAST, F("fast"));
+
+  // Leave the default behind in the module's NVMEM
+  cc3000.setScanPreset(CC3000_SCAN_SURVEY);
+}
+
+void loop(void)
+{
+ delay(1000);
+}
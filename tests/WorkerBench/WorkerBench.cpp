@@ -0,0 +1,277 @@
+/*
+  Host benchmark of the driver worker model (Adafruit_CC3000_Worker).
+
+  Runs the library and the driver against a simulated module (tests/host)
+  and lets N producer threads send a pattern on a socket of their own and
+  recv() its echo, two ways:
+
+    lock    each thread calls the driver itself, CC3000_THREAD_SAFE's
+            driver lock keeps the calls apart
+    worker  each thread submits the calls to Adafruit_CC3000_Worker and
+            waits for isDone(), one more thread calls process()
+
+  Prints the driver calls per second and the latency of one call, from the
+  call or the submit until its result is there.  Every echo is checked.
+
+  Build and run from this folder (the driver is built without _GNU_SOURCE,
+  see tests/host/host_thread.h):
+
+    g++ -std=c++11 -O2 -pthread -c ../host/host_thread.cpp ../host/cc3000_sim.cpp
+    g++ -std=c++11 -O2 -pthread -U_GNU_SOURCE -D_ISOC11_SOURCE -DARDUINO=105 \
+        -DCC3000_THREAD_SAFE -DCC3000_OS_PTHREAD -DCC3000_POLLED -I../host -I../.. \
+        WorkerBench.cpp ../host/arduino.cpp ../../Adafruit_CC3000.cpp \
+        ../../Adafruit_CC3000_Worker.cpp ../../ccspi.cpp \
+        ../../utility/cc3000_common.cpp ../../utility/cc3000_dns.cpp ../../utility/cc3000_os_pthread.cpp \
+        ../../utility/debug.cpp ../../utility/evnt_handler.cpp ../../utility/hci.cpp ../../utility/netapp.cpp \
+        ../../utility/nvmem.cpp ../../utility/security.cpp ../../utility/sntp.cpp ../../utility/socket.cpp \
+        ../../utility/wlan.cpp host_thread.o cc3000_sim.o -o WorkerBench
+    ./WorkerBench [producers] [rounds per producer] [module latency in us]
+*/
+#include <Arduino.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Adafruit_CC3000.h"
+#include "Adafruit_CC3000_Worker.h"
+#include "ccspi.h"
+#include "utility/socket.h"
+#include "cc3000_sim.h"
+#include "host_thread.h"
+
+#define ADAFRUIT_CC3000_IRQ   3
+#define ADAFRUIT_CC3000_VBAT  5
+#define ADAFRUIT_CC3000_CS    10
+
+#define MAX_PRODUCERS  (CC3000_SIM_SOCKETS - 1)
+#define PATTERN        32     // fits the RX buffer with the recv arguments
+#define WAIT_TIMEOUT   2000   // a lost reply fails the call instead of hanging
+
+Adafruit_CC3000        cc3000 = Adafruit_CC3000(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT);
+Adafruit_CC3000_Worker worker(cc3000);
+
+struct producer_t
+{
+  int                 id;
+  bool                useWorker;
+  unsigned long       rounds;
+  unsigned long       failures;
+  unsigned long long *lat;     // one per driver call
+  unsigned long       calls;
+  unsigned long       maxCalls;
+};
+
+static volatile bool stopping;
+
+/* Runs the call in this thread, or hands it to the worker and waits */
+static long run(producer_t *p, Adafruit_CC3000_Op *op, long sd, uint8_t code, void *buf, uint16_t len)
+{
+  unsigned long long start = host_nanos();
+  long               result;
+
+  if (p->useWorker)
+  {
+    bool queued = false;
+
+    while (!queued)
+    {
+      switch (code)
+      {
+        case CC3000_OP_SOCKET: queued = worker.socket(op); break;
+        case CC3000_OP_SEND:   queued = worker.send(op, sd, buf, len); break;
+        case CC3000_OP_RECV:   queued = worker.recv(op, sd, buf, len); break;
+        default:               queued = worker.close(op, sd); break;
+      }
+      if (!queued)
+      {
+        host_thread_yield();
+      }
+    }
+    while (!Adafruit_CC3000_Worker::isDone(op))
+    {
+      host_thread_yield();
+    }
+    result = op->result;
+  }
+  else
+  {
+    switch (code)
+    {
+      case CC3000_OP_SOCKET: result = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP); break;
+      case CC3000_OP_SEND:   result = send(sd, buf, len, 0); break;
+      case CC3000_OP_RECV:   result = recv(sd, buf, len, 0); break;
+      default:               result = closesocket(sd); break;
+    }
+  }
+
+  if (p->calls < p->maxCalls)
+  {
+    p->lat[p->calls++] = host_nanos() - start;
+  }
+  return result;
+}
+
+static void produce(void *arg)
+{
+  producer_t         *p = (producer_t *)arg;
+  Adafruit_CC3000_Op  op;   // left as it comes, the helpers fill it in
+  uint8_t             out[PATTERN], in[PATTERN];
+  long                sd, n;
+
+  sd = run(p, &op, 0, CC3000_OP_SOCKET, NULL, 0);
+  if (sd < 0)
+  {
+    printf("producer %d: socket() gave %ld\n", p->id, sd);
+    p->failures++;
+    return;
+  }
+
+  for (unsigned long round = 0; (round < p->rounds) && (p->failures < 10); round++)
+  {
+    long got = 0;
+
+    for (int i = 0; i < PATTERN; i++)
+    {
+      out[i] = p->id ^ round ^ i;
+    }
+    if ((n = run(p, &op, sd, CC3000_OP_SEND, out, PATTERN)) != PATTERN)
+    {
+      printf("producer %d round %lu: send() gave %ld\n", p->id, round, n);
+      p->failures++;
+      continue;
+    }
+    while (got < PATTERN)
+    {
+      if ((n = run(p, &op, sd, CC3000_OP_RECV, in + got, PATTERN - got)) <= 0)
+      {
+        printf("producer %d round %lu: recv() gave %ld\n", p->id, round, n);
+        p->failures++;
+        break;
+      }
+      got += n;
+    }
+    if ((got == PATTERN) && memcmp(in, out, PATTERN))
+    {
+      printf("producer %d round %lu: wrong echo\n", p->id, round);
+      p->failures++;
+    }
+  }
+
+  run(p, &op, sd, CC3000_OP_CLOSE, NULL, 0);
+}
+
+static int by_time(const void *a, const void *b)
+{
+  unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+
+  return (x > y) - (x < y);
+}
+
+static void consume(void *arg)
+{
+  (void)arg;
+  while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE))
+  {
+    if (worker.process() == 0)
+    {
+      host_thread_yield();
+    }
+  }
+}
+
+static unsigned long bench(const char *name, bool useWorker, int producers, unsigned long rounds)
+{
+  producer_t    p[MAX_PRODUCERS];
+  void         *handles[MAX_PRODUCERS];
+  void         *consumer = NULL;
+  unsigned long failures = 0, calls = 0;
+
+  __atomic_store_n(&stopping, false, __ATOMIC_RELEASE);
+  if (useWorker)
+  {
+    consumer = host_thread_start(consume, NULL);
+  }
+
+  unsigned long long start = host_nanos();
+  for (int i = 0; i < producers; i++)
+  {
+    p[i].id = i + 1;
+    p[i].useWorker = useWorker;
+    p[i].rounds = rounds;
+    p[i].failures = 0;
+    // recv() may take the echo in parts, calls past these aren't timed
+    p[i].maxCalls = 4 * rounds + 2;
+    p[i].lat = new unsigned long long[p[i].maxCalls];
+    p[i].calls = 0;
+    handles[i] = host_thread_start(produce, &p[i]);
+  }
+  for (int i = 0; i < producers; i++)
+  {
+    host_thread_join(handles[i]);
+  }
+  unsigned long long elapsed = host_nanos() - start;
+
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  if (consumer)
+  {
+    host_thread_join(consumer);
+  }
+
+  for (int i = 0; i < producers; i++)
+  {
+    calls += p[i].calls;
+  }
+  unsigned long long *all = new unsigned long long[calls];
+  calls = 0;
+  for (int i = 0; i < producers; i++)
+  {
+    for (unsigned long c = 0; c < p[i].calls; c++)
+    {
+      all[calls++] = p[i].lat[c];
+    }
+    failures += p[i].failures;
+    delete[] p[i].lat;
+  }
+  qsort(all, calls, sizeof(all[0]), by_time);
+
+  printf("%-8s %8.0f calls/s   p50 %7llu ns   p99 %7llu ns   max %9llu ns\n", name,
+         calls * 1e9 / elapsed, all[calls / 2], all[calls * 99 / 100], all[calls - 1]);
+  delete[] all;
+  return failures;
+}
+
+int main(int argc, char **argv)
+{
+  int           producers = (argc > 1) ? atoi(argv[1]) : 4;
+  unsigned long rounds = (argc > 2) ? atol(argv[2]) : 5000;
+  unsigned long latency = (argc > 3) ? atol(argv[3]) : 0;
+  unsigned long failures = 0;
+
+  if ((producers < 1) || (producers > MAX_PRODUCERS))
+  {
+    printf("1 to %d producers\n", MAX_PRODUCERS);
+    return 2;
+  }
+
+  int module = cc3000_sim_add(ADAFRUIT_CC3000_CS, ADAFRUIT_CC3000_IRQ, ADAFRUIT_CC3000_VBAT);
+  cc3000_sim_set_latency(module, latency);
+  if (!cc3000.begin())
+  {
+    printf("FAILURE: begin()\n");
+    return 1;
+  }
+  cc3000.setTimeout(WAIT_TIMEOUT);
+
+  printf("%d producers, %lu rounds each, module latency %lu us\n", producers, rounds, latency);
+  failures += bench("lock", false, producers, rounds);
+  failures += bench("worker", true, producers, rounds);
+  failures += cc3000_sim_errors(module);
+
+  if (failures)
+  {
+    printf("FAILURE: %lu\n", failures);
+    return 1;
+  }
+  printf("Done\n");
+  return 0;
+}
@@ -0,0 +1,105 @@
+# Adafruit CC3000 Library Test DNS Responder
+# Released with the same license as the Adafruit CC3000 library (BSD)
+
+# Stand-in DNS server for the DnsResolver test.  Listens for UDP queries by default on
+# port 5353 (or on the port given in the first command line parameter) and answers A
+# queries from the table below.  Prints every query to standard output.  Must be
+# terminated by hitting ctrl-c to kill the process!
+#
+# Options after the port:
+#   --silent      never answer, to stand in for a dead server
+#   --delay=MS    wait MS milliseconds before every answer, to stand in for a slow one
+#
+# e.g. run "python dns_responder.py 5353 --silent" and "python dns_responder.py 5354"
+# to check that the resolver takes the answer of the second server.
+
+from socket import *
+import struct
+import sys
+import time
+
+# Names the responder knows; everything else gets NXDOMAIN
+RECORDS = {
+	'one.test':   ['10.0.0.1'],
+	'three.test': ['10.0.0.1', '10.0.0.2', '10.0.0.3'],
+	'empty.test': [],                          # exists, but no A record
+	'edge-4711.eu-west.cdn-provider-with-a-long-hostname.example.test': ['10.0.0.4'],
+}
+ALIAS = {
+	'alias.test': 'three.test',                # answered with a CNAME and its A records
+	# a CNAME long enough to push the A record past the resolver's buffer
+	'longalias.test': 'edge-4711.eu-west.cdn-provider-with-a-long-hostname.example.test',
+}
+TTL = 60
+
+SERVER_PORT = 5353
+SILENT = False
+DELAY = 0
+for arg in sys.argv[1:]:
+	if arg == '--silent':
+		SILENT = True
+	elif arg.startswith('--delay='):
+		DELAY = int(arg[len('--delay='):]) / 1000.0
+	else:
+		SERVER_PORT = int(arg)
+
+def read_name(data, pos):
+	labels = []
+	while data[pos] != 0:
+		length = data[pos]
+		labels.append(data[pos + 1:pos + 1 + length].decode('ascii'))
+		pos += length + 1
+	return '.'.join(labels).lower(), pos + 1
+
+def encode_name(name):
+	out = b''
+	for label in name.split('.'):
+		out += struct.pack('B', len(label)) + label.encode('ascii')
+	return out + b'\0'
+
+def answer(query):
+	ident, flags, qdcount = struct.unpack('>HHH', query[:6])
+	name, pos = read_name(query, 12)
+	qtype, qclass = struct.unpack('>HH', query[pos:pos + 4])
+	question = query[12:pos + 4]
+
+	records = b''
+	count = 0
+	rcode = 0
+	target = ALIAS.get(name, name)
+	if target != name:
+		cname = encode_name(target)
+		records += b'\xc0\x0c' + struct.pack('>HHIH', 5, 1, TTL, len(cname)) + cname
+		count += 1
+	if target in RECORDS:
+		if qtype == 1:
+			for address in RECORDS[target]:
+				records += b'\xc0\x0c' + struct.pack('>HHIH', 1, 1, TTL, 4) + inet_aton(address)
+				count += 1
+	else:
+		rcode = 3
+
+	header = struct.pack('>HHHHHH', ident, 0x8180 | rcode, 1, count, 0, 0)
+	return name, header + question + records
+
+server = socket(AF_INET, SOCK_DGRAM)
+server.setsockopt(SOL_SOCKET, SO_REUSEADDR, 1)
+server.bind(('', SERVER_PORT))
+
+try:
+	while True:
+		query, client = server.recvfrom(512)
+		try:
+			name, reply = answer(bytearray(query))
+		except Exception as e:
+			sys.stdout.write('%s: bad query (%s)\n' % (client[0], e))
+			continue
+		sys.stdout.write('%s: %s%s\n' % (client[0], name, ' (not answered)' if SILENT else ''))
+		sys.stdout.flush()
+		if SILENT:
+			continue
+		time.sleep(DELAY)
+		server.sendto(bytes(reply), client)
+except KeyboardInterrupt:
+	pass
+server.close()
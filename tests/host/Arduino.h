@@ -0,0 +1,88 @@
+/*
+  Arduino core stand-in for building the library on the host (see the
+  host entry in tests/README.md).  Pins, SPI and time are implemented in
+  arduino.cpp: the CS, IRQ and VBAT pins and the SPI bus lead to the
+  simulated modules of cc3000_sim.cpp.
+
+  No port register macros are given, so the SPI layer uses digitalWrite and
+  digitalRead for the CS and IRQ pins.  Like the IDE, build with
+  -DARDUINO=105: the library sources look at it before any include.
+*/
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The driver's socket.h sets its own select() set size, the host's goes
+// unused
+#undef __FD_SETSIZE
+
+#ifndef ARDUINO
+#define ARDUINO 105
+#endif
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0
+#define OUTPUT          1
+#define INPUT_PULLUP    2
+#define FALLING         2
+#define DEC             10
+#define HEX             16
+#define MSBFIRST        1
+
+#define PROGMEM
+#define PSTR(s)               (s)
+#define pgm_read_byte(p)      (*(const uint8_t *)(p))
+#define pgm_read_word(p)      (*(const uint16_t *)(p))
+#define strlen_P              strlen
+#define strcpy_P              strcpy
+#define memcpy_P              memcpy
+
+typedef uint8_t byte;
+typedef bool    boolean;
+
+class __FlashStringHelper;
+#define F(s)  (reinterpret_cast<const __FlashStringHelper *>(s))
+
+#ifndef min
+#define min(a,b) ((a)<(b)?(a):(b))
+#endif
+#ifndef max
+#define max(a,b) ((a)>(b)?(a):(b))
+#endif
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t num, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t num);
+void noInterrupts(void);
+void interrupts(void);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+#include "Print.h"
+#include "Stream.h"
+
+class HardwareSerial : public Stream
+{
+  public:
+    void   begin(unsigned long baud);
+    size_t write(uint8_t c);
+    int    available(void);
+    int    read(void);
+    int    peek(void);
+    void   flush(void);
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
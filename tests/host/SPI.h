@@ -0,0 +1,31 @@
+/*
+  Arduino SPI stand-in for host builds, see Arduino.h.  transfer() clocks a
+  byte to and from the simulated module that has its CS pin low.
+*/
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include <stdint.h>
+
+#define SPI_MODE1         0x04
+#define SPI_CLOCK_DIV4    0x00
+#define SPI_CLOCK_DIV16   0x01
+#define SPI_CLOCK_DIV64   0x02
+#define SPI_CLOCK_DIV128  0x03
+#define SPI_CLOCK_DIV2    0x04
+#define SPI_CLOCK_DIV8    0x05
+#define SPI_CLOCK_DIV32   0x06
+
+class SPIClass
+{
+  public:
+    void    begin(void);
+    uint8_t transfer(uint8_t data);
+    void    setDataMode(uint8_t mode);
+    void    setBitOrder(uint8_t order);
+    void    setClockDivider(uint8_t div);
+};
+
+extern SPIClass SPI;
+
+#endif
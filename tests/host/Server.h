@@ -0,0 +1,15 @@
+/*
+  Arduino Server stand-in for host builds, see Arduino.h
+*/
+#ifndef HOST_SERVER_H
+#define HOST_SERVER_H
+
+#include "Print.h"
+
+class Server : public Print
+{
+  public:
+    virtual void begin(void) = 0;
+};
+
+#endif
@@ -0,0 +1,18 @@
+/*
+  Arduino Stream stand-in for host builds, see Arduino.h
+*/
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print
+{
+  public:
+    virtual int  available(void) = 0;
+    virtual int  read(void) = 0;
+    virtual int  peek(void) = 0;
+    virtual void flush(void) = 0;
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+  Arduino core stand-in for host builds, see Arduino.h.  Pins and SPI lead
+  to the simulated modules, Serial goes to standard output.
+*/
+#include <stdio.h>
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "cc3000_sim.h"
+#include "host_thread.h"
+
+HardwareSerial Serial;
+SPIClass       SPI;
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  cc3000_sim_pin_write(pin, val);
+}
+
+int digitalRead(uint8_t pin)
+{
+  int val = cc3000_sim_pin_read(pin);
+
+  return (val < 0) ? HIGH : val;
+}
+
+void attachInterrupt(uint8_t num, void (*handler)(void), int mode)
+{
+  // There are no interrupts on the host, the IRQ line must be polled
+  (void)num;
+  (void)handler;
+  (void)mode;
+  fprintf(stderr, "attachInterrupt: build with CC3000_POLLED on the host\n");
+  abort();
+}
+
+void detachInterrupt(uint8_t num)
+{
+  (void)num;
+}
+
+void noInterrupts(void) { }
+void interrupts(void) { }
+
+unsigned long millis(void)
+{
+  return host_nanos() / 1000000ULL;
+}
+
+unsigned long micros(void)
+{
+  return host_nanos() / 1000ULL;
+}
+
+void delay(unsigned long ms)
+{
+  host_sleep_us(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  host_sleep_us(us);
+}
+
+void SPIClass::begin(void) { }
+void SPIClass::setDataMode(uint8_t mode) { (void)mode; }
+void SPIClass::setBitOrder(uint8_t order) { (void)order; }
+void SPIClass::setClockDivider(uint8_t div) { (void)div; }
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  return cc3000_sim_spi_transfer(data);
+}
+
+void HardwareSerial::begin(unsigned long baud) { (void)baud; }
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  return (fputc(c, stdout) == EOF) ? 0 : 1;
+}
+
+int  HardwareSerial::available(void) { return 0; }
+int  HardwareSerial::read(void) { return -1; }
+int  HardwareSerial::peek(void) { return -1; }
+void HardwareSerial::flush(void) { fflush(stdout); }
+
+size_t Print::write(const uint8_t *buf, size_t len)
+{
+  size_t n = 0;
+
+  while (len--)
+  {
+    n += write(*buf++);
+  }
+  return n;
+}
+
+static size_t print_number(Print *p, unsigned long n, int base, bool negative)
+{
+  char buf[8 * sizeof(long) + 2];
+  char *s = &buf[sizeof(buf) - 1];
+
+  if (base < 2)
+  {
+    base = 10;
+  }
+  *s = 0;
+  do
+  {
+    unsigned long digit = n % base;
+    *--s = (digit < 10) ? '0' + digit : 'A' + digit - 10;
+    n /= base;
+  } while (n);
+  if (negative)
+  {
+    *--s = '-';
+  }
+  return p->write(s);
+}
+
+size_t Print::print(const __FlashStringHelper *str) { return write((const char *)str); }
+size_t Print::print(const char *str) { return write(str); }
+size_t Print::print(char c) { return write((uint8_t)c); }
+size_t Print::print(unsigned char n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(int n, int base) { return print((long)n, base); }
+size_t Print::print(unsigned int n, int base) { return print((unsigned long)n, base); }
+size_t Print::print(unsigned long n, int base) { return print_number(this, n, base, false); }
+
+size_t Print::print(long n, int base)
+{
+  if ((base == 10) && (n < 0))
+  {
+    return print_number(this, -(unsigned long)n, 10, true);
+  }
+  return print_number(this, (unsigned long)n, base, false);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[32];
+
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::println(void) { return write("\r\n"); }
+size_t Print::println(const __FlashStringHelper *str) { return print(str) + println(); }
+size_t Print::println(const char *str) { return print(str) + println(); }
+size_t Print::println(char c) { return print(c) + println(); }
+size_t Print::println(unsigned char n, int base) { return print(n, base) + println(); }
+size_t Print::println(int n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned int n, int base) { return print(n, base) + println(); }
+size_t Print::println(long n, int base) { return print(n, base) + println(); }
+size_t Print::println(unsigned long n, int base) { return print(n, base) + println(); }
+size_t Print::println(double n, int digits) { return print(n, digits) + println(); }
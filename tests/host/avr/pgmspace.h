@@ -0,0 +1 @@
+/* Nothing to include on the host, see ../Arduino.h */
@@ -0,0 +1,2 @@
+/* Watchdog stand-in for host builds, see ../Arduino.h */
+#define wdt_reset()
@@ -0,0 +1,463 @@
+/*
+  Simulated CC3000 modules for host tests, see cc3000_sim.h.  Built without
+  the driver headers, so the opcodes are repeated here.
+*/
+#include "cc3000_sim.h"
+#include "host_thread.h"
+
+#include <stddef.h>
+
+#include <deque>
+#include <vector>
+
+#define SPI_WRITE                 0x01
+#define SPI_READ                  0x03
+#define SPI_HEADER_SIZE           5
+
+#define HCI_TYPE_CMND             0x01
+#define HCI_TYPE_DATA             0x02
+#define HCI_TYPE_EVNT             0x04
+
+#define HCI_CMND_SOCKET           0x1001
+#define HCI_EVNT_SEND             0x1003
+#define HCI_CMND_RECV             0x1004
+#define HCI_CMND_SETSOCKOPT       0x1009
+#define HCI_CMND_GETSOCKOPT       0x100A
+#define HCI_CMND_CLOSE_SOCKET     0x100B
+#define HCI_CMND_NVMEM_READ       0x0201
+#define HCI_CMND_READ_BUFFER_SIZE 0x400B
+#define HCI_EVNT_FREE_BUFF        0x4100
+
+#define HCI_DATA_SEND             0x81
+#define HCI_DATA_RECV             0x85
+#define HCI_DATA_NVMEM            0x91
+
+#define RECV_ARGS_SIZE            24   // ahead of the data, as the module sends them
+
+typedef std::vector<uint8_t> packet_t;
+
+struct sim_socket_t
+{
+  bool                open;
+  uint32_t            option;
+  std::deque<uint8_t> echo;
+};
+
+struct sim_packet_t
+{
+  packet_t           bytes;
+  unsigned long long ready;   // host_nanos() from which IRQ shows it
+};
+
+struct sim_module_t
+{
+  uint8_t csPin, irqPin, vbatPin;
+  unsigned long latency;
+  unsigned      lose;       // events still to lose
+
+  bool powered;
+  bool started;     // the first write after power-up came
+  bool selected;    // CS low
+  int  transfer;    // 0 until the first byte, then SPI_WRITE or SPI_READ
+
+  packet_t                 in;
+  size_t                   outPos;
+  std::deque<sim_packet_t> out;
+
+  sim_socket_t  sockets[CC3000_SIM_SOCKETS];
+  unsigned long packets, errors;
+};
+
+static std::vector<sim_module_t> sim_modules;
+
+int cc3000_sim_add(uint8_t csPin, uint8_t irqPin, uint8_t vbatPin)
+{
+  sim_module_t m = sim_module_t();
+
+  m.csPin = csPin;
+  m.irqPin = irqPin;
+  m.vbatPin = vbatPin;
+  sim_modules.push_back(m);
+  return sim_modules.size() - 1;
+}
+
+void cc3000_sim_set_latency(int module, unsigned long us)
+{
+  sim_modules[module].latency = us;
+}
+
+void cc3000_sim_lose_events(int module, unsigned count)
+{
+  sim_modules[module].lose = count;
+}
+
+unsigned long cc3000_sim_packets(int module)
+{
+  return sim_modules[module].packets;
+}
+
+unsigned long cc3000_sim_errors(int module)
+{
+  return sim_modules[module].errors;
+}
+
+static void put16(packet_t &p, uint16_t v)
+{
+  p.push_back(v);
+  p.push_back(v >> 8);
+}
+
+static void put32(packet_t &p, uint32_t v)
+{
+  put16(p, v);
+  put16(p, v >> 16);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+/* Queues an HCI packet for the host behind the SPI header of a read */
+static void queue(sim_module_t *m, const packet_t &hci)
+{
+  sim_packet_t p;
+
+  p.bytes.push_back(SPI_READ);
+  p.bytes.push_back(0);
+  p.bytes.push_back(0);
+  p.bytes.push_back(hci.size() >> 8);
+  p.bytes.push_back(hci.size());
+  p.bytes.insert(p.bytes.end(), hci.begin(), hci.end());
+  p.ready = host_nanos() + m->latency * 1000ULL;
+  m->out.push_back(p);
+}
+
+static void event(sim_module_t *m, uint16_t opcode, uint8_t status, const packet_t &params)
+{
+  packet_t hci;
+
+  if (m->lose)
+  {
+    m->lose--;
+    return;
+  }
+  hci.push_back(HCI_TYPE_EVNT);
+  put16(hci, opcode);
+  hci.push_back(1 + params.size());
+  hci.push_back(status);
+  hci.insert(hci.end(), params.begin(), params.end());
+  queue(m, hci);
+}
+
+static void data(sim_module_t *m, uint8_t opcode, uint8_t argsSize, const packet_t &payload)
+{
+  packet_t hci;
+
+  hci.push_back(HCI_TYPE_DATA);
+  hci.push_back(opcode);
+  hci.push_back(argsSize);
+  put16(hci, argsSize + payload.size());
+  hci.insert(hci.end(), argsSize, 0);
+  hci.insert(hci.end(), payload.begin(), payload.end());
+  queue(m, hci);
+}
+
+static sim_socket_t *find_socket(sim_module_t *m, uint32_t sd)
+{
+  if ((sd < CC3000_SIM_SOCKETS) && m->sockets[sd].open)
+  {
+    return &m->sockets[sd];
+  }
+  m->errors++;
+  return NULL;
+}
+
+static void command(sim_module_t *m, uint16_t opcode, const uint8_t *args, uint8_t len)
+{
+  packet_t      params;
+  sim_socket_t *s;
+  uint32_t      sd = (len >= 4) ? get32(args) : 0;
+
+  switch (opcode)
+  {
+    case HCI_CMND_READ_BUFFER_SIZE:
+      params.push_back(CC3000_SIM_BUFFERS);
+      put16(params, CC3000_SIM_BUFFER_LEN);
+      event(m, opcode, 0, params);
+      break;
+
+    case HCI_CMND_SOCKET:
+      for (sd = 0; (sd < CC3000_SIM_SOCKETS) && m->sockets[sd].open; sd++) { }
+      if (sd < CC3000_SIM_SOCKETS)
+      {
+        m->sockets[sd].open = true;
+        m->sockets[sd].option = 0;
+        m->sockets[sd].echo.clear();
+      }
+      else
+      {
+        m->errors++;
+        sd = (uint32_t)-1;
+      }
+      put32(params, sd);
+      event(m, opcode, 0, params);
+      break;
+
+    case HCI_CMND_CLOSE_SOCKET:
+      s = find_socket(m, sd);
+      if (s)
+      {
+        s->open = false;
+      }
+      put32(params, s ? 0 : (uint32_t)-1);
+      event(m, opcode, 0, params);
+      break;
+
+    case HCI_CMND_SETSOCKOPT:
+      // sd, level, optname, 8, optlen, then the value
+      s = find_socket(m, sd);
+      if (s && (len >= 24))
+      {
+        s->option = get32(args + 20);
+      }
+      put32(params, s ? 0 : (uint32_t)-1);
+      event(m, opcode, 0, params);
+      break;
+
+    case HCI_CMND_GETSOCKOPT:
+      s = find_socket(m, sd);
+      put32(params, s ? s->option : 0);
+      event(m, opcode, s ? 0 : 0xFF, params);
+      break;
+
+    case HCI_CMND_RECV:
+      {
+        // sd, length, flags: the event, then the data if there is any
+        uint32_t want = (len >= 8) ? get32(args + 4) : 0;
+        packet_t payload;
+
+        s = find_socket(m, sd);
+        while (s && !s->echo.empty() && (payload.size() < want))
+        {
+          payload.push_back(s->echo.front());
+          s->echo.pop_front();
+        }
+        put32(params, sd);
+        put32(params, s ? payload.size() : (uint32_t)-1);
+        put32(params, 0);
+        event(m, opcode, 0, params);
+        if (!payload.empty())
+        {
+          data(m, HCI_DATA_RECV, RECV_ARGS_SIZE, payload);
+        }
+      }
+      break;
+
+    case HCI_CMND_NVMEM_READ:
+      // Nothing is stored: an error, and the data packet that always follows
+      put32(params, 0);
+      event(m, opcode, 1, params);
+      data(m, HCI_DATA_NVMEM, 0, packet_t());
+      break;
+
+    default:
+      put32(params, 0);
+      event(m, opcode, 0, params);
+      break;
+  }
+}
+
+static void send_data(sim_module_t *m, const uint8_t *args, const uint8_t *payload, uint16_t len)
+{
+  uint32_t      sd = get32(args);
+  sim_socket_t *s = find_socket(m, sd);
+  packet_t      params;
+
+  if (s)
+  {
+    s->echo.insert(s->echo.end(), payload, payload + len);
+  }
+  put32(params, sd);
+  put32(params, s ? len : (uint32_t)-1);
+  event(m, HCI_EVNT_SEND, 0, params);
+
+  // The buffer is free again once the frame is out
+  params.clear();
+  put16(params, 1);
+  put16(params, sd);
+  put16(params, 1);
+  event(m, HCI_EVNT_FREE_BUFF, 0, params);
+}
+
+/* Checks a packet the host wrote against its length fields and serves it */
+static void received(sim_module_t *m)
+{
+  const packet_t &in = m->in;
+  uint16_t spiLen;
+
+  m->packets++;
+  if ((in.size() < SPI_HEADER_SIZE + 4) || (in[0] != SPI_WRITE))
+  {
+    m->errors++;
+    return;
+  }
+  spiLen = (in[1] << 8) | in[2];
+  if (in.size() != (size_t)SPI_HEADER_SIZE + spiLen)
+  {
+    m->errors++;
+    return;
+  }
+
+  const uint8_t *hci = &in[SPI_HEADER_SIZE];
+
+  // The SPI length is padded to make the whole packet odd
+  if (hci[0] == HCI_TYPE_CMND)
+  {
+    uint8_t argsLen = hci[3];
+
+    if ((4 + argsLen != spiLen) && (4 + argsLen + 1 != spiLen))
+    {
+      m->errors++;
+      return;
+    }
+    m->started = true;
+    command(m, get16(hci + 1), hci + 4, argsLen);
+  }
+  else if ((hci[0] == HCI_TYPE_DATA) && (spiLen >= 5))
+  {
+    uint8_t  argsSize = hci[2];
+    uint16_t total = get16(hci + 3);
+
+    if (((5 + total != spiLen) && (5 + total + 1 != spiLen)) || (argsSize < 4) ||
+        (argsSize > total) || (hci[1] != HCI_DATA_SEND))
+    {
+      m->errors++;
+      return;
+    }
+    send_data(m, hci + 5, hci + 5 + argsSize, total - argsSize);
+  }
+  else
+  {
+    m->errors++;
+  }
+}
+
+static void power(sim_module_t *m, bool on)
+{
+  m->powered = on;
+  m->started = false;
+  m->transfer = 0;
+  m->in.clear();
+  m->out.clear();
+  m->outPos = 0;
+  for (int i = 0; i < CC3000_SIM_SOCKETS; i++)
+  {
+    m->sockets[i].open = false;
+    m->sockets[i].echo.clear();
+  }
+}
+
+bool cc3000_sim_pin_write(uint8_t pin, uint8_t val)
+{
+  for (size_t i = 0; i < sim_modules.size(); i++)
+  {
+    sim_module_t *m = &sim_modules[i];
+
+    if (pin == m->vbatPin)
+    {
+      if ((val != 0) != m->powered)
+      {
+        power(m, val != 0);
+      }
+      return true;
+    }
+    if (pin == m->csPin)
+    {
+      bool select = (val == 0);
+
+      if (m->selected && !select)
+      {
+        // End of a transfer
+        if (m->transfer == SPI_WRITE)
+        {
+          received(m);
+        }
+        else if ((m->transfer == SPI_READ) && !m->out.empty())
+        {
+          m->out.pop_front();
+        }
+        m->transfer = 0;
+        m->in.clear();
+        m->outPos = 0;
+      }
+      m->selected = select;
+      return true;
+    }
+    if (pin == m->irqPin)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+int cc3000_sim_pin_read(uint8_t pin)
+{
+  for (size_t i = 0; i < sim_modules.size(); i++)
+  {
+    sim_module_t *m = &sim_modules[i];
+
+    if (pin != m->irqPin)
+    {
+      continue;
+    }
+    if (!m->powered)
+    {
+      return 1;   // pulled up
+    }
+    // Low: ready for the first write, for the write the host selected us
+    // for, or with a packet for the host
+    if (!m->started || m->selected ||
+        (!m->out.empty() && (m->out.front().ready <= host_nanos())))
+    {
+      return 0;
+    }
+    return 1;
+  }
+  return -1;
+}
+
+uint8_t cc3000_sim_spi_transfer(uint8_t byte)
+{
+  for (size_t i = 0; i < sim_modules.size(); i++)
+  {
+    sim_module_t *m = &sim_modules[i];
+
+    if (!m->selected || !m->powered)
+    {
+      continue;
+    }
+    if (m->transfer == 0)
+    {
+      // The host clocks out its header on a write, READ bytes on a read
+      m->transfer = (byte == SPI_READ) ? SPI_READ : SPI_WRITE;
+    }
+    if (m->transfer == SPI_WRITE)
+    {
+      m->in.push_back(byte);
+      return 0;
+    }
+    if (!m->out.empty() && (m->outPos < m->out.front().bytes.size()))
+    {
+      return m->out.front().bytes[m->outPos++];
+    }
+    return 0;
+  }
+  return 0xFF;
+}
@@ -0,0 +1,47 @@
+/*
+  Simulated CC3000 modules for host tests.
+
+  A module sits on three pins and the SPI bus, and speaks the SPI and HCI
+  framing of the real one: it powers up with VBAT, pulls IRQ low when it
+  has a packet for the host or the host selected it to write, and answers
+  the commands the library sends during begin() and the socket calls.
+  Sockets echo what is sent on them: recv() gets back the oldest bytes
+  sent on the same socket.  setsockopt() values are kept per socket and
+  returned by getsockopt().
+
+  Every packet written is checked against its SPI and HCI length fields,
+  so a frame that two threads wrote into at once shows up as an error.
+
+  There is no lock inside: the module is only ever driven by the SPI layer,
+  which runs under the driver lock.  A race in the driver then also races
+  here, where ThreadSanitizer sees it.
+*/
+#ifndef CC3000_SIM_H
+#define CC3000_SIM_H
+
+#include <stdint.h>
+
+#define CC3000_SIM_SOCKETS      8     // the module's socket limit
+#define CC3000_SIM_BUFFERS      6     // free TX buffers reported at start
+#define CC3000_SIM_BUFFER_LEN   1468  // and their size
+
+/* Adds a module on the given pins, returns its number */
+int  cc3000_sim_add(uint8_t csPin, uint8_t irqPin, uint8_t vbatPin);
+
+/* How long the module takes to answer, in microseconds (0 by default) */
+void cc3000_sim_set_latency(int module, unsigned long us);
+
+/* The module never sends the next count events, as if they were lost */
+void cc3000_sim_lose_events(int module, unsigned count);
+
+/* Packets the module took from the host, and those it found malformed or
+   couldn't serve (a closed socket, no socket left) */
+unsigned long cc3000_sim_packets(int module);
+unsigned long cc3000_sim_errors(int module);
+
+/* Pin and bus side, for arduino.cpp */
+bool    cc3000_sim_pin_write(uint8_t pin, uint8_t val);  // false if no module's pin
+int     cc3000_sim_pin_read(uint8_t pin);                // -1 if no module's pin
+uint8_t cc3000_sim_spi_transfer(uint8_t data);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+  Threads, a mutex and the clock for host tests, see host_thread.h.  Built
+  without the driver headers, with the host's normal flags.
+*/
+#include "host_thread.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+void *host_thread_start(host_thread_fn_t fn, void *arg)
+{
+  return new std::thread(fn, arg);
+}
+
+void host_thread_join(void *thread)
+{
+  std::thread *t = static_cast<std::thread *>(thread);
+
+  t->join();
+  delete t;
+}
+
+void host_thread_yield(void)
+{
+  std::this_thread::yield();
+}
+
+void *host_mutex_create(void)
+{
+  return new std::mutex;
+}
+
+void host_mutex_lock(void *mutex)
+{
+  static_cast<std::mutex *>(mutex)->lock();
+}
+
+void host_mutex_unlock(void *mutex)
+{
+  static_cast<std::mutex *>(mutex)->unlock();
+}
+
+void host_mutex_destroy(void *mutex)
+{
+  delete static_cast<std::mutex *>(mutex);
+}
+
+unsigned long long host_nanos(void)
+{
+  static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now() - start).count();
+}
+
+void host_sleep_us(unsigned long us)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
@@ -0,0 +1,26 @@
+/*
+  Threads, a mutex and the clock for host tests.
+
+  A TU that includes the driver headers can't include <pthread.h>, <time.h>
+  or <thread>: the driver's own time_t, timeval and socket functions clash
+  with the host C library.  These declarations stand in for them, and
+  host_thread.cpp, built without the driver headers, implements them.
+*/
+#ifndef HOST_THREAD_H
+#define HOST_THREAD_H
+
+typedef void (*host_thread_fn_t)(void *arg);
+
+void *host_thread_start(host_thread_fn_t fn, void *arg);
+void  host_thread_join(void *thread);
+void  host_thread_yield(void);
+
+void *host_mutex_create(void);
+void  host_mutex_lock(void *mutex);
+void  host_mutex_unlock(void *mutex);
+void  host_mutex_destroy(void *mutex);
+
+unsigned long long host_nanos(void);   // monotonic
+void  host_sleep_us(unsigned long us);
+
+#endif
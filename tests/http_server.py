@@ -0,0 +1,144 @@
+# Adafruit CC3000 Library Test HTTP Server
+# Released with the same license as the Adafruit CC3000 library (BSD)
+
+# HTTP/1.1 server for the HttpClient test.  Listens by default on port 8080 (or on the port
+# given in the first command line parameter) and keeps connections open between requests,
+# closing them after IDLE_TIMEOUT seconds without one.  Prints every request and the number
+# of the connection it came on to standard output.  Must be terminated by hitting ctrl-c to
+# kill the process!
+#
+# Paths:
+#   /hello          short body with a Content-Length
+#   /chunked        body in chunks of different sizes, with a chunk extension and a trailer
+#   /large?n=N      N bytes (byte i is i % 251) with a Content-Length and an X-Checksum
+#                   header (sum of the bytes modulo 65536), chunked with &chunked=1
+#   /close          body without a length, ended by closing the connection
+#   /echo           (POST) answers with the request body
+#   /upload         (POST or PUT) answers with the length and the checksum (sum of the bytes
+#                   modulo 65536) of the request body, which may be chunked
+
+try:
+	from http.server import BaseHTTPRequestHandler, HTTPServer
+	from socketserver import ThreadingMixIn
+	from urllib.parse import urlparse, parse_qs
+except ImportError:
+	from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+	from SocketServer import ThreadingMixIn
+	from urlparse import urlparse, parse_qs
+import socket
+import sys
+import threading
+
+SERVER_PORT = 8080
+if len(sys.argv) > 1:
+	SERVER_PORT = int(sys.argv[1])
+
+IDLE_TIMEOUT = 5
+
+connections = [0]
+lock = threading.Lock()
+
+class Handler(BaseHTTPRequestHandler):
+	protocol_version = 'HTTP/1.1'
+	timeout = IDLE_TIMEOUT
+
+	def setup(self):
+		BaseHTTPRequestHandler.setup(self)
+		with lock:
+			connections[0] += 1
+			self.connection_number = connections[0]
+
+	def handle(self):
+		try:
+			BaseHTTPRequestHandler.handle(self)
+		except socket.error:
+			pass  # the client gave up on the connection, e.g. to skip a long body
+
+	def log_message(self, format, *args):
+		sys.stdout.write('#%d %s: %s\n' % (self.connection_number, self.client_address[0], format % args))
+		sys.stdout.flush()
+
+	def send_body(self, body, chunked=False, headers={}):
+		self.send_response(200)
+		self.send_header('Content-Type', 'application/octet-stream')
+		for name, value in headers.items():
+			self.send_header(name, value)
+		if chunked:
+			self.send_header('Transfer-Encoding', 'chunked')
+			self.end_headers()
+			sizes = [1, 10, 100, 7, 300, 2]
+			pos = 0
+			i = 0
+			while pos < len(body):
+				piece = body[pos:pos + sizes[i % len(sizes)]]
+				extension = ';part=%d' % i if i % 2 else ''
+				self.wfile.write(('%x%s\r\n' % (len(piece), extension)).encode('ascii') + piece + b'\r\n')
+				pos += len(piece)
+				i += 1
+			self.wfile.write(b'0\r\nX-Trailer: done\r\n\r\n')
+		else:
+			self.send_header('Content-Length', str(len(body)))
+			self.end_headers()
+			self.wfile.write(body)
+
+	def do_GET(self):
+		url = urlparse(self.path)
+		query = parse_qs(url.query)
+		if url.path == '/hello':
+			self.send_body(b'Hello, CC3000!\n')
+		elif url.path == '/chunked':
+			self.send_body(b''.join([('line %d of the chunked body\n' % i).encode('ascii') for i in range(20)]), True)
+		elif url.path == '/large':
+			n = int(query.get('n', ['4096'])[0])
+			body = bytearray([i % 251 for i in range(n)])
+			self.send_body(bytes(body), query.get('chunked', ['0'])[0] == '1',
+			               {'X-Checksum': str(sum(body) % 65536)})
+		elif url.path == '/close':
+			self.send_response(200)
+			self.send_header('Connection', 'close')
+			self.end_headers()
+			self.wfile.write(b'Body ended by the connection\n')
+			self.close_connection = True
+		else:
+			self.send_error(404)
+
+	def do_HEAD(self):
+		self.send_response(200)
+		self.send_header('Content-Length', '1000')
+		self.end_headers()
+
+	def read_body(self):
+		if self.headers.get('Transfer-Encoding', '').lower() == 'chunked':
+			body = b''
+			while True:
+				size = int(self.rfile.readline().split(b';')[0], 16)
+				if size == 0:
+					break
+				body += self.rfile.read(size)
+				self.rfile.readline()
+			while self.rfile.readline() not in (b'\r\n', b'\n', b''):
+				pass  # trailers
+			return body
+		return self.rfile.read(int(self.headers.get('Content-Length', '0')))
+
+	def do_POST(self):
+		body = self.read_body()
+		if self.path == '/echo':
+			self.send_body(body)
+		elif self.path == '/upload':
+			self.send_body(('%d %d\n' % (len(body), sum(bytearray(body)) % 65536)).encode('ascii'))
+		else:
+			self.send_error(404)
+
+	do_PUT = do_POST
+
+class Server(ThreadingMixIn, HTTPServer):
+	daemon_threads = True
+	allow_reuse_address = True
+
+server = Server(('', SERVER_PORT), Handler)
+try:
+	server.serve_forever()
+except KeyboardInterrupt:
+	pass
+server.server_close()
@@ -114,6 +114,88 @@ extern "C" {
  */
 #define CC3000_NO_PATCH
 
+/*
+ * Define CC3000_DEFERRED_RX to keep the SPI interrupt handler as short as
+ * possible. The IRQ handler then only records the falling edge of the IRQ line
+ * and the SPI transfer itself (reading or writing a whole frame) is done later
+ * from cc3k_int_poll(), which the driver calls from all of its wait loops.
+ * This keeps other interrupts (UART RX, timers) from being blocked for the
+ * duration of a full frame at the cost of a slightly higher event latency.
+ */
+//#define CC3000_DEFERRED_RX
+
+/*
+ * Define CC3000_ISR_TIMING to record the longest time (in microseconds) spent
+ * in the SPI interrupt handler. Use SpiGetMaxIsrTime() to read the value. This
+ * is useful to compare the interrupt latency with and without
+ * CC3000_DEFERRED_RX.
+ */
+//#define CC3000_ISR_TIMING
+
+/*
+ * Define CC3000_POLLED to run the SPI transport without an external interrupt.
+ * attachInterrupt/detachInterrupt are never called and the IRQ line is only
+ * sampled from cc3k_int_poll() (or Adafruit_CC3000::poll()), which handles at
+ * most one SPI frame per call. The IRQ pin can then be any digital pin, and
+ * the interrupt latency of other peripherals isn't affected by the CC3000.
+ * Note that unsolicited events (connect, DHCP, ...) are only processed while
+ * the driver is polled, so call poll() from your main loop.
+ */
+//#define CC3000_POLLED
+
+/*
+ * Define CC3000_SLOW_PINS to drive the CS pin and sample the IRQ pin through
+ * digitalWrite/digitalRead. By default the pins are resolved once in init_spi()
+ * to their port register and bit mask, so every chip-select toggle and IRQ
+ * sample in the wait loops is a single port access. Only needed for cores
+ * where direct port access misbehaves.
+ */
+//#define CC3000_SLOW_PINS
+
+/*
+ * Define CC3000_MAX_INSTANCES to the number of CC3000 modules (up to 4) that
+ * are driven from one MCU, each through its own Adafruit_CC3000 object with
+ * its own CS, IRQ and VBAT pins. Every module gets its own driver state and
+ * buffers (see cc3000_context.h), so RAM use grows accordingly; begin()
+ * fails for any module beyond that number. Leave it undefined (1) for a
+ * single module, which costs nothing over the plain global state.
+ */
+//#define CC3000_MAX_INSTANCES 2
+
+/*
+ * Define CC3000_THREAD_SAFE to share the driver between several RTOS tasks or
+ * threads. Every driver API then runs under a driver lock and the wait loops
+ * block on an event signalled by the SPI layer instead of spinning. The lock
+ * and event functions come from an OS port, see cc3000_os.h; define
+ * CC3000_OS_PTHREAD as well to use the POSIX threads port.
+ */
+//#define CC3000_THREAD_SAFE
+
+/*
+ * Define CC3000_WAIT_TIMEOUT_MS to give every blocking wait in the driver
+ * (SPI transfers, command replies, free TX buffers, wlan_start) a deadline
+ * in milliseconds. A wait that runs out makes the API return
+ * ERROR_WAIT_TIMEOUT instead of hanging on a missed interrupt. Left
+ * undefined (0) the waits are unbounded. The deadline can also be changed
+ * at runtime with cc3000_set_wait_timeout() or Adafruit_CC3000::setTimeout().
+ */
+//#define CC3000_WAIT_TIMEOUT_MS 10000
+
+/*
+ * Define CC3000_FAULT_TIMEOUTS to change after how many waits in a row that
+ * ran out, with nothing at all heard from the module in between, the driver
+ * takes the SPI link for lost and flags CC3000_FAULT_TIMEOUT (3 by default).
+ * A single timeout only fails the call, see Adafruit_CC3000::supervise().
+ */
+//#define CC3000_FAULT_TIMEOUTS 3
+
+/*
+ * Define CC3000_POWER_OFF_MS to change how long init_spi() holds the module
+ * powered down before begin() starts it, in milliseconds (500 by default).
+ * A board that powers the module up cold can use much less and boot faster.
+ */
+//#define CC3000_POWER_OFF_MS 50
+
 //*****************************************************************************
 //                  ERROR CODES
 //*****************************************************************************
@@ -125,6 +207,7 @@ extern "C" {
 //                  COMMON DEFINES
 //*****************************************************************************
 #define ERROR_SOCKET_INACTIVE   -57
+#define ERROR_WAIT_TIMEOUT      -60
 
 #define WLAN_ENABLE      (1)
 #define WLAN_DISABLE     (0)
@@ -257,6 +340,8 @@ typedef void (*tWlanInterruptDisable)(void);
 
 typedef void (*tWriteWlanPin)(unsigned char val);
 
+typedef long (*tSendFill)(unsigned char *buf, long len, void *arg);
+
 typedef struct
 {
 	unsigned short	 usRxEventOpcode;
@@ -287,8 +372,6 @@ typedef struct
 	unsigned char	 InformHostOnTxComplete;
 }sSimplLinkInformation;
 
-extern volatile sSimplLinkInformation tSLInformation;
-
 
 //*****************************************************************************
 // Prototypes for the APIs.
@@ -303,14 +386,15 @@ extern volatile sSimplLinkInformation tSLInformation;
 //!  @param  usOpcode      command operation code
 //!  @param  pRetParams    command return parameters
 //!
-//!  @return               none
+//!  @return               ESUCCESS, or ERROR_WAIT_TIMEOUT if the event
+//!                        didn't arrive before the wait deadline
 //!
 //!  @brief                Wait for event, pass it to the hci_event_handler and
 //!                        update the event opcode in a global variable.
 //
 //*****************************************************************************
 
-extern void SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams);
+extern long SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams);
 
 //*****************************************************************************
 //
@@ -320,7 +404,8 @@ extern void SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams);
 //!  @param  from       from information
 //!  @param  fromlen	  from information length
 //!
-//!  @return               none
+//!  @return               ESUCCESS, or ERROR_WAIT_TIMEOUT if the data
+//!                        didn't arrive before the wait deadline
 //!
 //!  @brief                Wait for data, pass it to the hci_event_handler
 //! 					   and update in a global variable that there is
@@ -328,7 +413,7 @@ extern void SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams);
 //
 //*****************************************************************************
 
-extern void SimpleLinkWaitData(uint8_t *pBuf, uint8_t *from, uint8_t *fromlen);
+extern long SimpleLinkWaitData(uint8_t *pBuf, uint8_t *from, uint8_t *fromlen);
 
 //*****************************************************************************
 //
@@ -407,6 +492,71 @@ extern uint32_t STREAM_TO_UINT32_f(char* p, uint16_t offset);
 
 extern void cc3k_int_poll();
 
+//*****************************************************************************
+//
+//!  cc3000_set_idle_hook
+//!
+//!  \param  hook       function to call while the driver waits, 0 for none
+//!
+//!  \brief             Every driver wait loop (SPI transfers, command
+//!                     replies, free TX buffers and the timed waits of
+//!                     Adafruit_CC3000) calls cc3000_idle(), which runs the
+//!                     hook. It can sleep until the next interrupt, see
+//!                     cc3000_idle_sleep(), or run a cooperative task; it
+//!                     must not call into the driver. cc3k_delay() is a
+//!                     delay() that idles the same way. Functions are in
+//!                     ccspi.cpp
+//
+//*****************************************************************************
+
+typedef void (*cc3000_idle_hook_t)(void);
+
+extern void cc3000_set_idle_hook(cc3000_idle_hook_t hook);
+extern void cc3000_idle(void);
+extern void cc3k_delay(unsigned long ms);
+
+//*****************************************************************************
+//
+//!  cc3000_idle_sleep
+//!
+//!  \brief             Ready-made idle hook: idle sleep on AVR, wait for
+//!                     interrupt on ARM, returning on the next interrupt
+//!                     (the CC3000 IRQ or the system tick). Does nothing on
+//!                     other cores
+//
+//*****************************************************************************
+
+extern void cc3000_idle_sleep(void);
+
+//*****************************************************************************
+//
+//!  cc3000_set_wait_timeout
+//!
+//!  \param  ulTimeout  deadline for each blocking wait in ms, 0 for none
+//!
+//!  \return            the previous deadline
+//!
+//!  \brief             Sets how long the driver waits for the CC3000 before
+//!                     an API gives up with ERROR_WAIT_TIMEOUT. Applies to
+//!                     the current module. Functions are in ccspi.cpp
+//
+//*****************************************************************************
+
+extern unsigned long cc3000_set_wait_timeout(unsigned long ulTimeout);
+
+//*****************************************************************************
+//
+//!  cc3000_wait_start / cc3000_wait_expired
+//!
+//!  \brief             Start a wait and check it against the deadline, e.g.
+//!                     start = cc3000_wait_start();
+//!                     while (!ready) { if (cc3000_wait_expired(start)) ... }
+//
+//*****************************************************************************
+
+extern unsigned long cc3000_wait_start(void);
+extern int cc3000_wait_expired(unsigned long ulStart);
+
 
 
 //*****************************************************************************
@@ -442,4 +592,9 @@ extern void cc3k_int_poll();
 }
 #endif // __cplusplus
 
+// Per-module driver state, see cc3000_context.h
+#include "cc3000_context.h"
+// Locking and wait hooks for CC3000_THREAD_SAFE, see cc3000_os.h
+#include "cc3000_os.h"
+
 #endif // __COMMON_H__
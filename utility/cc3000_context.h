@@ -0,0 +1,184 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_context.h
+
+  Per-module driver state.
+
+  Everything the SPI, HCI, socket and Adafruit_CC3000 layers keep about one
+  CC3000 (pins, SPI state machine, RX/TX buffers, tSLInformation, socket
+  status, connection flags) lives in a tCC3000Context. The historical
+  global names (tSLInformation, sSpiInformation, g_csPin, ...) are macros
+  that resolve to fields of the current context, cc3000_ctx, so the TI
+  driver code is unchanged.
+
+  With CC3000_MAX_INSTANCES left at 1 cc3000_ctx is a constant address and
+  the generated code is the same as with plain globals. With more instances
+  every Adafruit_CC3000 (and the clients and servers created from it)
+  selects its own context before calling into the driver, and each module
+  gets its own interrupt handler.
+*/
+/**************************************************************************/
+#ifndef __CC3000_CONTEXT_H__
+#define __CC3000_CONTEXT_H__
+
+#include <Arduino.h>
+#include "cc3000_common.h"
+#include "cc3000_dns.h"
+
+#ifndef CC3000_MAX_INSTANCES
+#define CC3000_MAX_INSTANCES 1
+#endif
+
+#if (CC3000_MAX_INSTANCES < 1) || (CC3000_MAX_INSTANCES > 4)
+#error "CC3000_MAX_INSTANCES must be between 1 and 4"
+#endif
+
+#if defined(CC3000_THREAD_SAFE) && (CC3000_MAX_INSTANCES > 1)
+// cc3000_ctx is shared by all threads, selecting a module would race
+#error "CC3000_THREAD_SAFE supports a single CC3000 module only"
+#endif
+
+#define MAX_SOCKETS 32  // can change this
+
+#ifndef CC3000_WAIT_TIMEOUT_MS
+#define CC3000_WAIT_TIMEOUT_MS 0
+#endif
+
+#ifndef CC3000_FAULT_TIMEOUTS
+#define CC3000_FAULT_TIMEOUTS 3
+#endif
+
+/*
+the CS and IRQ pins are touched on every transfer and in every wait loop,
+so where the core lets us we resolve them to their port registers once in
+init_spi and skip digitalWrite/digitalRead afterwards
+*/
+#if defined(portOutputRegister) && defined(portInputRegister) && !defined(CC3000_SLOW_PINS)
+#define CC3000_FAST_PINS
+#if defined(__AVR__)
+typedef volatile uint8_t ccspi_OutReg;
+typedef volatile uint8_t ccspi_InReg;
+typedef uint8_t ccspi_PortMask;
+#else
+/* 32 bit ports on SAM, SAMD and most other cores: take whatever the core's
+   own macros give back (the AVR ones read PROGMEM, so can't be used here) */
+typedef __typeof__(*portOutputRegister(digitalPinToPort(0))) ccspi_OutReg;
+typedef __typeof__(*portInputRegister(digitalPinToPort(0))) ccspi_InReg;
+typedef __typeof__(digitalPinToBitMask(0)) ccspi_PortMask;
+#endif
+#endif
+
+/* Why the driver gave up on the module, see Adafruit_CC3000::supervise() */
+#define CC3000_FAULT_NONE       0
+#define CC3000_FAULT_TIMEOUT    1   // CC3000_FAULT_TIMEOUTS waits in a row ran out, the SPI link is lost
+#define CC3000_FAULT_OVERRUN    2   // the RX or TX buffer guard byte was overwritten
+#define CC3000_FAULT_RECOVERY   3   // recover() restarted the module but couldn't get it back on the AP
+#define CC3000_FAULT_NO_CONTEXT 4   // the object got no context, see CC3000_MAX_INSTANCES
+
+/* What the IP configuration cache holds, see Adafruit_CC3000::getIPAddress() */
+#define CC3000_IPCONFIG_NONE      0   // nothing, ask the module
+#define CC3000_IPCONFIG_ADDRESSES 1   // the addresses of the last DHCP event
+#define CC3000_IPCONFIG_FULL      2   // and the MAC address and SSID too
+
+typedef struct
+{
+  void          (*SPIRxHandler)(void *p);
+
+  unsigned short usTxPacketLength;
+  unsigned short usRxPacketLength;
+  unsigned long  ulSpiState;
+  unsigned char *pTxPacket;
+  unsigned char *pRxPacket;
+
+} tSpiInformation;
+
+typedef struct
+{
+  /* Pins and SPI setup (ccspi.cpp) */
+  uint8_t csPin, irqPin, vbatPin, irqNum, spiSpeed;
+#ifdef CC3000_FAST_PINS
+  ccspi_OutReg *csPort;
+  ccspi_InReg *irqPort;
+  ccspi_PortMask csMask, irqMask;
+#endif
+  uint8_t mySPCR, mySPSR;
+
+  /* SPI transport (ccspi.cpp) */
+  tSpiInformation spi;
+  char rxBuffer[CC3000_RX_BUFFER_SIZE];
+  unsigned char txBuffer[CC3000_TX_BUFFER_SIZE];
+  volatile char isInIrq;
+  volatile char intEnabled;
+#ifdef CC3000_DEFERRED_RX
+  volatile char irqPending;
+  volatile char inBottomHalf;
+#endif
+
+  /* HCI / socket layer (utility) */
+  volatile sSimplLinkInformation sl;
+  unsigned long socketActiveStatus;
+  unsigned long listenSockets;  // bit per socket that listen() succeeded on
+
+  /* Wait deadlines: the last SPI write gave up, a reply that was given up on,
+     waits that ran out since the module was last heard from */
+  unsigned long waitTimeout;
+  volatile char txTimedOut;
+  unsigned short staleOpcode;
+  uint8_t timeouts;
+
+  /* Recovery: why the module is wedged, bumped on every restart */
+  volatile uint8_t fault;
+  uint8_t generation;
+
+  /* Adafruit_CC3000 */
+  boolean closedSockets[MAX_SOCKETS];
+  volatile unsigned long connected, dhcp, dhcpConfigured, okToDoShutDown;
+  volatile uint8_t events;  // CC3000_EVENT_* bits not yet taken by waitFor()
+  volatile unsigned long dhcpTime;  // millis() of the first DHCP event since begin()
+  unsigned char ipConfig[20];       // IP, subnet mask, gateway, DHCP and DNS server as in tNetappIpconfigRetArgs
+  volatile uint8_t ipConfigState;   // CC3000_IPCONFIG_*, dropped on disconnect
+#ifndef CC3000_TINY_DRIVER
+  volatile unsigned long smartConfigFinished;
+  volatile unsigned char stopSmartConfig;
+  volatile long smartConfigSocket;
+#if CC3000_DNS_CACHE_SIZE > 0
+  tDnsCacheEntry dnsCache[CC3000_DNS_CACHE_SIZE];
+#endif
+#endif
+} tCC3000Context;
+
+extern tCC3000Context cc3000_contexts[CC3000_MAX_INSTANCES];
+
+#if CC3000_MAX_INSTANCES == 1
+#define cc3000_ctx              (&cc3000_contexts[0])
+#define CC3000_SELECT(c)        do {  } while (0)
+#else
+extern tCC3000Context * volatile cc3000_ctx;
+#define CC3000_SELECT(c)        do { cc3000_ctx = (c); } while (0)
+#endif
+
+extern tCC3000Context *cc3000_ctx_alloc(void);
+
+/* Historical global names, now fields of the current context */
+#define g_csPin                 (cc3000_ctx->csPin)
+#define g_irqPin                (cc3000_ctx->irqPin)
+#define g_vbatPin               (cc3000_ctx->vbatPin)
+#define g_IRQnum                (cc3000_ctx->irqNum)
+#define g_SPIspeed              (cc3000_ctx->spiSpeed)
+#define sSpiInformation         (cc3000_ctx->spi)
+#define spi_buffer              (cc3000_ctx->rxBuffer)
+#define wlan_tx_buffer          (cc3000_ctx->txBuffer)
+#define tSLInformation          (cc3000_ctx->sl)
+#define socket_active_status    (cc3000_ctx->socketActiveStatus)
+#define closed_sockets          (cc3000_ctx->closedSockets)
+#define ulCC3000Connected       (cc3000_ctx->connected)
+#define ulCC3000DHCP            (cc3000_ctx->dhcp)
+#define ulCC3000DHCP_configured (cc3000_ctx->dhcpConfigured)
+#define OkToDoShutDown          (cc3000_ctx->okToDoShutDown)
+#ifndef CC3000_TINY_DRIVER
+#define ulSmartConfigFinished   (cc3000_ctx->smartConfigFinished)
+#define ucStopSmartConfig       (cc3000_ctx->stopSmartConfig)
+#define ulSocket                (cc3000_ctx->smartConfigSocket)
+#endif
+
+#endif
@@ -0,0 +1,163 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_dns.cpp
+
+  Host name cache in front of gethostbyname(), see cc3000_dns.h.
+
+  The entries live in the module's context, so each module caches the
+  answers of its own network.
+*/
+/**************************************************************************/
+#include <string.h>
+#include "cc3000_common.h"
+#include "socket.h"
+#include "cc3000_dns.h"
+
+#ifndef CC3000_TINY_DRIVER
+
+#if CC3000_DNS_CACHE_SIZE > 0
+
+/* Time left until t, negative once it's over */
+#define DNS_LEFT(t)   ((long)((t) - millis()))
+
+static tDnsCacheEntry *dns_cache_find(const char *hostname, uint8_t usNameLen)
+{
+  tDnsCacheEntry *entry = cc3000_ctx->dnsCache;
+
+  for (uint8_t i = 0; i < CC3000_DNS_CACHE_SIZE; i++, entry++)
+  {
+    if ((strncmp(entry->name, hostname, usNameLen) == 0) &&
+        (entry->name[usNameLen] == '\0'))
+    {
+      return entry;
+    }
+  }
+
+  return NULL;
+}
+
+/* An unused entry, else an expired one, else the least asked for */
+static tDnsCacheEntry *dns_cache_victim(void)
+{
+  tDnsCacheEntry *entry = cc3000_ctx->dnsCache;
+  tDnsCacheEntry *victim = entry;
+
+  for (uint8_t i = 0; i < CC3000_DNS_CACHE_SIZE; i++, entry++)
+  {
+    if ((entry->name[0] == '\0') || (DNS_LEFT(entry->expires) < 0))
+    {
+      return entry;
+    }
+    if (entry->hits < victim->hits)
+    {
+      victim = entry;
+    }
+  }
+
+  return victim;
+}
+
+/* Stores the module's answer for the entry's name */
+static void dns_cache_store(tDnsCacheEntry *entry, int ret, uint32_t ip)
+{
+  entry->ret = ret;
+  entry->ip = (ret < 0) ? 0 : ip;
+  entry->expires = millis() + (entry->ip ? CC3000_DNS_TTL : CC3000_DNS_NEGATIVE_TTL);
+  entry->hits = 0;
+}
+
+int dns_cache_gethostbyname(const char *hostname, uint8_t usNameLen, uint32_t *out_ip_addr)
+{
+  tDnsCacheEntry *entry;
+
+  // Names that don't fit go straight to the module
+  if ((usNameLen == 0) || (usNameLen >= CC3000_DNS_NAME_SIZE))
+  {
+    return gethostbyname(hostname, usNameLen, out_ip_addr);
+  }
+
+  entry = dns_cache_find(hostname, usNameLen);
+  if (entry && (DNS_LEFT(entry->expires) >= 0))
+  {
+    if (entry->hits < 0xFF)
+    {
+      entry->hits++;
+    }
+  }
+  else
+  {
+    uint32_t ip = 0;
+    int ret = gethostbyname(hostname, usNameLen, &ip);
+
+    // No answer in time isn't a name that doesn't exist, ask again next time
+    if (ret == ERROR_WAIT_TIMEOUT)
+    {
+      *out_ip_addr = 0;
+      return ret;
+    }
+    if (!entry)
+    {
+      entry = dns_cache_victim();
+      memcpy(entry->name, hostname, usNameLen);
+      entry->name[usNameLen] = '\0';
+    }
+    dns_cache_store(entry, ret, ip);
+  }
+
+  *out_ip_addr = entry->ip;
+  return entry->ret;
+}
+
+int dns_cache_refresh(void)
+{
+  tDnsCacheEntry *entry = cc3000_ctx->dnsCache;
+
+  for (uint8_t i = 0; i < CC3000_DNS_CACHE_SIZE; i++, entry++)
+  {
+    if ((entry->name[0] == '\0') || (entry->ip == 0) ||
+        (entry->hits < CC3000_DNS_PREFETCH_HITS) ||
+        (DNS_LEFT(entry->expires) >= CC3000_DNS_PREFETCH))
+    {
+      continue;
+    }
+
+    uint32_t ip = 0;
+    int ret = gethostbyname(entry->name, strlen(entry->name), &ip);
+    if ((ret >= 0) && ip)
+    {
+      entry->ret = ret;
+      entry->ip = ip;
+      entry->expires = millis() + CC3000_DNS_TTL;
+    }
+    // Refreshed or not, it has to be asked for again to be refreshed again
+    entry->hits = 0;
+    return 1;
+  }
+
+  return 0;
+}
+
+void dns_cache_flush(void)
+{
+  memset(cc3000_ctx->dnsCache, 0, sizeof(cc3000_ctx->dnsCache));
+}
+
+#else
+
+int dns_cache_gethostbyname(const char *hostname, uint8_t usNameLen, uint32_t *out_ip_addr)
+{
+  return gethostbyname(hostname, usNameLen, out_ip_addr);
+}
+
+int dns_cache_refresh(void)
+{
+  return 0;
+}
+
+void dns_cache_flush(void)
+{
+}
+
+#endif
+
+#endif
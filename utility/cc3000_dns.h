@@ -0,0 +1,103 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_dns.h
+
+  Host name cache in front of gethostbyname().
+
+  Every gethostbyname() is a DNS round trip that blocks the driver. The
+  cache keeps the last CC3000_DNS_CACHE_SIZE answers per module, names
+  the module couldn't resolve included, so asking for the same name again
+  is free until the entry expires. The CC3000 doesn't pass the record's
+  TTL on, so answers are kept for a fixed CC3000_DNS_TTL and failures for
+  CC3000_DNS_NEGATIVE_TTL. A lookup the module didn't answer in time
+  isn't cached, it says nothing about the name.
+
+  dns_cache_refresh() re-resolves a name that was asked for at least
+  CC3000_DNS_PREFETCH_HITS times shortly before it expires, so names in
+  regular use don't block the sketch when they run out. The old answer
+  stays in use if the refresh fails. Adafruit_CC3000::supervise() calls
+  it.
+
+  Set CC3000_DNS_CACHE_SIZE to 0 to leave the cache out. That's the
+  default on AVR, where the entries would take about 170 bytes of the
+  RAM per module. Not available with CC3000_TINY_DRIVER, there is no
+  gethostbyname().
+*/
+/**************************************************************************/
+#ifndef __CC3000_DNS_H__
+#define __CC3000_DNS_H__
+
+#include <stdint.h>
+
+#ifndef CC3000_DNS_CACHE_SIZE
+#ifdef __AVR__
+#define CC3000_DNS_CACHE_SIZE      0       // 2 KB boards can't spare the RAM, define it to cache anyway
+#else
+#define CC3000_DNS_CACHE_SIZE      4       // names cached per module
+#endif
+#endif
+#ifndef CC3000_DNS_NAME_SIZE
+#define CC3000_DNS_NAME_SIZE       32      // longest cached name plus the terminator, longer names aren't cached
+#endif
+#ifndef CC3000_DNS_TTL
+#define CC3000_DNS_TTL             300000  // how long an answer is used, in milliseconds
+#endif
+#ifndef CC3000_DNS_NEGATIVE_TTL
+#define CC3000_DNS_NEGATIVE_TTL    30000   // how long a failed lookup is remembered, in milliseconds
+#endif
+#ifndef CC3000_DNS_PREFETCH
+#define CC3000_DNS_PREFETCH        30000   // refresh answers this long before they expire, in milliseconds
+#endif
+#ifndef CC3000_DNS_PREFETCH_HITS
+#define CC3000_DNS_PREFETCH_HITS   2       // only refresh names asked for this often since the last lookup
+#endif
+
+typedef struct
+{
+  char     name[CC3000_DNS_NAME_SIZE];  // empty for an unused entry
+  uint32_t ip;                          // 0 if the lookup failed
+  uint32_t expires;                     // millis() when the entry runs out
+  int16_t  ret;                         // what gethostbyname() returned
+  uint8_t  hits;                        // cache hits since the last lookup
+} tDnsCacheEntry;
+
+#ifndef CC3000_TINY_DRIVER
+
+//*****************************************************************************
+//
+//! dns_cache_gethostbyname
+//!
+//!  @param[in]   hostname     host name
+//!  @param[in]   usNameLen    name length
+//!  @param[out]  out_ip_addr  host IP address, zero if it isn't resolved
+//!  @return      what gethostbyname() returned for the name
+//!
+//!  @brief  gethostbyname() through the cache of the current module
+//
+//*****************************************************************************
+extern int dns_cache_gethostbyname(const char *hostname, uint8_t usNameLen, uint32_t *out_ip_addr);
+
+//*****************************************************************************
+//
+//! dns_cache_refresh
+//!
+//!  @return  1 if a name was looked up, 0 if none was due
+//!
+//!  @brief  Re-resolves at most one popular name that expires soon. It
+//!          blocks for the lookup, call it where the sketch can wait.
+//
+//*****************************************************************************
+extern int dns_cache_refresh(void);
+
+//*****************************************************************************
+//
+//! dns_cache_flush
+//!
+//!  @brief  Forgets all cached names of the current module
+//
+//*****************************************************************************
+extern void dns_cache_flush(void);
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_os.h
+
+  Operating system hooks for CC3000_THREAD_SAFE.
+
+  The CC3000 talks one HCI command at a time and the driver keeps the
+  command buffer and the pending reply in tSLInformation, so every driver
+  API (socket, wlan, netapp and nvmem calls) holds the driver lock from
+  sending its command until its reply is in. The lock must be recursive,
+  as some APIs call others.
+
+  Instead of spinning, the wait loops block in cc3000_os_wait_event() for
+  at most CC3000_OS_WAIT_MS, and the SPI layer calls
+  cc3000_os_signal_event() whenever a transfer completes. The signal may
+  come from the IRQ handler, so it must be safe to call from an ISR.
+
+  A port implements the four functions below, utility/cc3000_os_pthread.cpp
+  is the one for POSIX threads (define CC3000_OS_PTHREAD to build it).
+*/
+/**************************************************************************/
+#ifndef __CC3000_OS_H__
+#define __CC3000_OS_H__
+
+#ifdef CC3000_THREAD_SAFE
+
+#ifndef CC3000_OS_WAIT_MS
+#define CC3000_OS_WAIT_MS 1   // longest wait for a signal before polling the IRQ line again
+#endif
+
+extern void cc3000_os_lock(void);
+extern void cc3000_os_unlock(void);
+extern void cc3000_os_wait_event(unsigned long timeout_ms);
+extern void cc3000_os_signal_event(void);
+
+/* Holds the driver lock until the end of the enclosing scope */
+class cc3000_os_lock_guard
+{
+  public:
+    cc3000_os_lock_guard()  { cc3000_os_lock(); }
+    ~cc3000_os_lock_guard() { cc3000_os_unlock(); }
+};
+
+#define CC3000_DRIVER_LOCK()      cc3000_os_lock_guard cc3000_driver_lock_
+#define CC3000_OS_WAIT_EVENT()    cc3000_os_wait_event(CC3000_OS_WAIT_MS)
+#define CC3000_OS_SIGNAL_EVENT()  cc3000_os_signal_event()
+
+#else
+
+#define CC3000_DRIVER_LOCK()
+#define CC3000_OS_WAIT_EVENT()
+#define CC3000_OS_SIGNAL_EVENT()
+
+#endif
+
+#endif
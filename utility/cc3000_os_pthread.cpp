@@ -0,0 +1,93 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_os_pthread.cpp
+
+  POSIX threads port of the CC3000_THREAD_SAFE hooks (see cc3000_os.h).
+
+  The driver lock is a recursive mutex. The event is a flag guarded by its
+  own mutex and condition variable, so a signal that arrives before the
+  waiter blocks isn't lost. Build with CC3000_THREAD_SAFE and
+  CC3000_OS_PTHREAD defined, e.g. for host tests under ThreadSanitizer.
+
+  Only cc3000_os.h is included: the driver's own time and socket types in
+  cc3000_common.h clash with the host C library. For the same reason the
+  driver is built without _GNU_SOURCE on the host (see tests/host), so the
+  recursive mutex type is asked for here.
+*/
+/**************************************************************************/
+#ifdef CC3000_OS_PTHREAD
+
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700
+#endif
+
+#ifndef CC3000_THREAD_SAFE
+#define CC3000_THREAD_SAFE
+#endif
+#include "cc3000_os.h"
+
+#include <pthread.h>
+#include <time.h>
+
+static pthread_mutex_t cc3000_os_driver_mutex;
+static pthread_once_t  cc3000_os_once = PTHREAD_ONCE_INIT;
+
+static pthread_mutex_t cc3000_os_event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cc3000_os_event_cond  = PTHREAD_COND_INITIALIZER;
+static int             cc3000_os_event_flag  = 0;
+
+static void cc3000_os_init(void)
+{
+  pthread_mutexattr_t attr;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&cc3000_os_driver_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+void cc3000_os_lock(void)
+{
+  pthread_once(&cc3000_os_once, cc3000_os_init);
+  pthread_mutex_lock(&cc3000_os_driver_mutex);
+}
+
+void cc3000_os_unlock(void)
+{
+  pthread_mutex_unlock(&cc3000_os_driver_mutex);
+}
+
+void cc3000_os_wait_event(unsigned long timeout_ms)
+{
+  struct timespec deadline;
+
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec  += timeout_ms / 1000;
+  deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L)
+  {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&cc3000_os_event_mutex);
+  while (!cc3000_os_event_flag)
+  {
+    if (pthread_cond_timedwait(&cc3000_os_event_cond, &cc3000_os_event_mutex, &deadline) != 0)
+    {
+      break;
+    }
+  }
+  cc3000_os_event_flag = 0;
+  pthread_mutex_unlock(&cc3000_os_event_mutex);
+}
+
+void cc3000_os_signal_event(void)
+{
+  pthread_mutex_lock(&cc3000_os_event_mutex);
+  cc3000_os_event_flag = 1;
+  pthread_cond_broadcast(&cc3000_os_event_cond);
+  pthread_mutex_unlock(&cc3000_os_event_mutex);
+}
+
+#endif
@@ -0,0 +1,104 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_queue.h
+
+  Bounded lock-free multi-producer/single-consumer queue.
+
+  Every slot carries a sequence number that tells producers and the
+  consumer whose turn it is (Dmitry Vyukov's bounded queue). Producers
+  claim a slot with one compare-and-swap on the enqueue position, the
+  single consumer needs no atomic read-modify-write at all. push() fails
+  instead of blocking when the queue is full.
+
+  N must be a power of two. The header has no driver dependencies so it
+  can be used (and benchmarked) on its own.
+*/
+/**************************************************************************/
+#ifndef __CC3000_QUEUE_H__
+#define __CC3000_QUEUE_H__
+
+#include <stddef.h>
+
+template <typename T, size_t N>
+class cc3000_mpsc_queue
+{
+  public:
+    cc3000_mpsc_queue()
+    {
+      for (size_t i = 0; i < N; i++)
+      {
+        _cells[i].seq = i;
+      }
+      _head = 0;
+      _tail = 0;
+    }
+
+    // Any thread (or ISR); false if the queue is full
+    bool push(const T &item)
+    {
+      cell *c;
+      size_t pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+
+      for (;;)
+      {
+        c = &_cells[pos & (N - 1)];
+        size_t seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+        // Subtract in the counters' own width, so the sign stays right
+        // once they wrap (size_t is 16 bits on AVR)
+        ptrdiff_t dif = (ptrdiff_t)(seq - pos);
+
+        if (dif == 0)
+        {
+          if (__atomic_compare_exchange_n(&_tail, &pos, pos + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+          {
+            break;
+          }
+        }
+        else if (dif < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        }
+      }
+
+      c->data = item;
+      __atomic_store_n(&c->seq, pos + 1, __ATOMIC_RELEASE);
+      return true;
+    }
+
+    // Consumer only; false if the queue is empty
+    bool pop(T &item)
+    {
+      cell *c = &_cells[_head & (N - 1)];
+      size_t seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+
+      if (seq != _head + 1)
+      {
+        return false;
+      }
+
+      item = c->data;
+      __atomic_store_n(&c->seq, _head + N, __ATOMIC_RELEASE);
+      _head++;
+      return true;
+    }
+
+  private:
+    typedef char size_must_be_power_of_two[((N & (N - 1)) == 0) ? 1 : -1];
+
+    struct cell
+    {
+      size_t seq;
+      T      data;
+    };
+
+    cell   _cells[N];
+    size_t _head;   // consumer position, only touched by the consumer
+    size_t _tail;   // producer position, claimed with compare-and-swap
+};
+
+#endif
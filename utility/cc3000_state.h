@@ -0,0 +1,51 @@
+/**************************************************************************/
+/*!
+  @file     cc3000_state.h
+
+  State of the non-blocking managers that run() steps from loop(), such
+  as Adafruit_CC3000_ConnectionManager: the current state and how long it
+  may last.
+
+  enter() switches state and starts its timer, expired() tells when the
+  wait is over. Timers run on millis() and survive its wrap-around.
+*/
+/**************************************************************************/
+#ifndef __CC3000_STATE_H__
+#define __CC3000_STATE_H__
+
+#if ARDUINO >= 100
+ #include "Arduino.h"
+#else
+ #include "WProgram.h"
+#endif
+
+template <typename S>
+class cc3000_state
+{
+  public:
+    cc3000_state(S state) : _state(state), _wait(0), _since(0) { }
+
+    void enter(S state, uint32_t wait)
+    {
+      _state = state;
+      _wait = wait;
+      _since = millis();
+    }
+
+    bool expired(void) const
+    {
+      return millis() - _since >= _wait;
+    }
+
+    operator S(void) const
+    {
+      return _state;
+    }
+
+  private:
+    S        _state;
+    uint32_t _wait;    // how long the current state may last
+    uint32_t _since;   // millis() when the current state was entered
+};
+
+#endif
@@ -124,7 +124,7 @@
 //                  GLOBAL VARAIABLES
 //*****************************************************************************
 
-unsigned long socket_active_status = SOCKET_STATUS_INIT_VAL;
+// socket_active_status is part of the driver context, see cc3000_context.h
 
 
 //*****************************************************************************
@@ -236,7 +236,8 @@ void hci_unsol_handle_patch_request(char *event_hdr)
 //!  @param  from           from information (in case of data received)
 //!  @param  fromlen        from information length (in case of data received)
 //!
-//!  @return         none
+//!  @return         ESUCCESS, or ERROR_WAIT_TIMEOUT if the awaited event or
+//!                  data didn't arrive before the wait deadline
 //!
 //!  @brief          Parse the incoming events packets and issues corresponding
 //!                  event handler from global array of handlers pointers
@@ -244,7 +245,7 @@ void hci_unsol_handle_patch_request(char *event_hdr)
 //*****************************************************************************
 
 
-unsigned char *
+long
 hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
 {
 	unsigned char *pucReceivedData, ucArgsize;
@@ -254,13 +255,52 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
 	unsigned long retValue32;
 	unsigned char * RecvParams;
 	unsigned char *RetParams;
+	unsigned long ulStart = cc3000_wait_start();
+	unsigned char ucDroppedOwn = 0;
 
 	while (1)
 	{
 		cc3k_int_poll();
 
-		if (tSLInformation.usEventOrDataReceived != 0)
+		if (tSLInformation.usEventOrDataReceived == 0)
+		{
+			// The SPI link is lost (the module stayed silent through several
+			// timeouts, or a buffer overran): fail every wait until the
+			// module has been recovered
+			if ((cc3000_ctx->fault == CC3000_FAULT_TIMEOUT) ||
+			    (cc3000_ctx->fault == CC3000_FAULT_OVERRUN))
+			{
+				cc3000_ctx->txTimedOut = 0;
+				tSLInformation.usRxEventOpcode = 0;
+				tSLInformation.usRxDataPending = 0;
+				return ERROR_WAIT_TIMEOUT;
+			}
+			// The command never went out, or its reply is overdue: give up
+			// on it, and drop the reply should it still turn up
+			if (cc3000_ctx->txTimedOut || cc3000_wait_expired(ulStart))
+			{
+				// Unless this wait dropped a late reply of its own command: that
+				// was likely its own, the late one having been lost, and one more
+				// would have every call of the command drop the next one's reply
+				if (!cc3000_ctx->txTimedOut && !ucDroppedOwn)
+				{
+					cc3000_ctx->staleOpcode = tSLInformation.usRxEventOpcode;
+				}
+				if (++cc3000_ctx->timeouts >= CC3000_FAULT_TIMEOUTS)
+				{
+					cc3000_ctx->fault = CC3000_FAULT_TIMEOUT;
+				}
+				cc3000_ctx->txTimedOut = 0;
+				tSLInformation.usRxEventOpcode = 0;
+				tSLInformation.usRxDataPending = 0;
+				return ERROR_WAIT_TIMEOUT;
+			}
+			cc3000_idle();
+		}
+		else
 		{
+			// The module talks to us, whatever timed out before
+			cc3000_ctx->timeouts = 0;
 
 			pucReceivedData = (tSLInformation.pucReceivedData);
 
@@ -274,8 +314,21 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
 				RecvParams = pucReceivedParams;
 				RetParams = (unsigned char *)pRetParams;
 
+				if (usReceivedEventOpcode == cc3000_ctx->staleOpcode)
+				{
+					// Late reply to a wait that timed out, nobody wants it. The
+					// module answers in order, so it comes ahead of the reply to
+					// a new call of the same command, which is still to come.
+					if (usReceivedEventOpcode == tSLInformation.usRxEventOpcode)
+					{
+						ucDroppedOwn = 1;
+					}
+					cc3000_ctx->staleOpcode = 0;
+					// Nor does it end the wait below
+					usReceivedEventOpcode = 0;
+				}
 				// In case unsolicited event received - here the handling finished
-				if (hci_unsol_event_handler((char *)pucReceivedData) == 0)
+				else if (hci_unsol_event_handler((char *)pucReceivedData) == 0)
 				{
 					STREAM_TO_UINT8(pucReceivedData, HCI_DATA_LENGTH_OFFSET, usLength);
 
@@ -366,15 +419,15 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
 					case HCI_EVNT_RECV:
 					case HCI_EVNT_RECVFROM:
 						{
-						  STREAM_TO_UINT32((char *)pucReceivedParams,SL_RECEIVE_SD_OFFSET ,*(unsigned long *)pRetParams);
-						  pRetParams = ((char *)pRetParams) + 4;
-						  STREAM_TO_UINT32((char *)pucReceivedParams,SL_RECEIVE_NUM_BYTES_OFFSET,*(unsigned long *)pRetParams);
-						  pRetParams = ((char *)pRetParams) + 4;
-						  STREAM_TO_UINT32((char *)pucReceivedParams,SL_RECEIVE__FLAGS__OFFSET,*(unsigned long *)pRetParams);
+						  // Field by field: the status check needs the struct from its
+						  // start, and long isn't 4 bytes on a 64 bit host
 						  tBsdReadReturnParams *tread = (tBsdReadReturnParams *)pRetParams;
-						  if(((tBsdReadReturnParams *)pRetParams)->iNumberOfBytes == ERROR_SOCKET_INACTIVE)
+						  STREAM_TO_UINT32((char *)pucReceivedParams,SL_RECEIVE_SD_OFFSET ,tread->iSocketDescriptor);
+						  STREAM_TO_UINT32((char *)pucReceivedParams,SL_RECEIVE_NUM_BYTES_OFFSET,tread->iNumberOfBytes);
+						  STREAM_TO_UINT32((char *)pucReceivedParams,SL_RECEIVE__FLAGS__OFFSET,tread->uiFlags);
+						  if(tread->iNumberOfBytes == ERROR_SOCKET_INACTIVE)
 						    {
-						      set_socket_active_status(((tBsdReadReturnParams *)pRetParams)->iSocketDescriptor,SOCKET_STATUS_INACTIVE);
+						      set_socket_active_status(tread->iSocketDescriptor,SOCKET_STATUS_INACTIVE);
 						    }
 						  break;
 						}
@@ -462,7 +515,7 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
 					tSLInformation.usRxEventOpcode = 0;
 				}
 			}
-			else
+			else if (tSLInformation.usRxDataPending)
 			{
 				pucReceivedParams = pucReceivedData;
 				STREAM_TO_UINT8((char *)pucReceivedData, HCI_PACKET_ARGSIZE_OFFSET, ucArgsize);
@@ -497,7 +550,7 @@ hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen)
 
 			if ((tSLInformation.usRxEventOpcode == 0) && (tSLInformation.usRxDataPending == 0))
 			{
-				return NULL;
+				return ESUCCESS;
 			}
 		}
 	}
@@ -832,20 +885,21 @@ update_socket_active_status(char *resp_params)
 //!  @param  usOpcode      command operation code
 //!  @param  pRetParams    command return parameters
 //!
-//!  @return               none
+//!  @return               ESUCCESS, or ERROR_WAIT_TIMEOUT if the event
+//!                        didn't arrive before the wait deadline
 //!
 //!  @brief                Wait for event, pass it to the hci_event_handler and
 //!                        update the event opcode in a global variable.
 //
 //*****************************************************************************
 
-void
+long
 SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams)
 {
 	// In the blocking implementation the control to caller will be returned only
 	// after the end of current transaction
 	tSLInformation.usRxEventOpcode = usOpcode;
-	hci_event_handler(pRetParams, 0, 0);
+	return hci_event_handler(pRetParams, 0, 0);
 }
 
 //*****************************************************************************
@@ -856,7 +910,8 @@ SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams)
 //!  @param  from       from information
 //!  @param  fromlen	from information length
 //!
-//!  @return               none
+//!  @return               ESUCCESS, or ERROR_WAIT_TIMEOUT if the data
+//!                        didn't arrive before the wait deadline
 //!
 //!  @brief                Wait for data, pass it to the hci_event_handler
 //! 					   and update in a global variable that there is
@@ -864,14 +919,14 @@ SimpleLinkWaitEvent(unsigned short usOpcode, void *pRetParams)
 //
 //*****************************************************************************
 
-void
+long
 SimpleLinkWaitData(unsigned char *pBuf, unsigned char *from,
 									 unsigned char *fromlen)
 {
 	// In the blocking implementation the control to caller will be returned only
 	// after the end of current transaction, i.e. only after data will be received
 	tSLInformation.usRxDataPending = 1;
-	hci_event_handler(pBuf, from, fromlen);
+	return hci_event_handler(pBuf, from, fromlen);
 }
 
 //*****************************************************************************
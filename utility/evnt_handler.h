@@ -71,13 +71,14 @@ extern "C" {
 //!  @param  from           from information (in case of data received)
 //!  @param  fromlen        from information length (in case of data received)
 //!
-//!  @return         none
+//!  @return         ESUCCESS, or ERROR_WAIT_TIMEOUT if the awaited event or
+//!                  data didn't arrive before the wait deadline
 //!
 //!  @brief          Parse the incoming events packets and issues corresponding
 //!                  event handler from global array of handlers pointers
 //
 //*****************************************************************************
-extern unsigned char *hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen);
+extern long hci_event_handler(void *pRetParams, unsigned char *from, unsigned char *fromlen);
 
 //*****************************************************************************
 //
@@ -117,8 +118,6 @@ extern long hci_unsolicited_event_handler(void);
 #define M_IS_VALID_SD(sd) ((0 <= (sd)) && ((sd) <= 7))
 #define M_IS_VALID_STATUS(status) (((status) == SOCKET_STATUS_ACTIVE)||((status) == SOCKET_STATUS_INACTIVE))
 
-extern unsigned long socket_active_status;
-
 extern void set_socket_active_status(long Sd, long Status);
 extern long get_socket_active_status(long Sd);
 
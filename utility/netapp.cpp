@@ -110,6 +110,7 @@ long netapp_config_mac_adrress(unsigned char * mac)
 #ifndef CC3000_TINY_DRIVER
 long netapp_dhcp(unsigned long *aucIP, unsigned long *aucSubnetMask,unsigned long *aucDefaultGateway, unsigned long *aucDNSServer)
 {
+	CC3000_DRIVER_LOCK();
 	signed char scRet;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -129,7 +130,10 @@ long netapp_dhcp(unsigned long *aucIP, unsigned long *aucSubnetMask,unsigned lon
 	hci_command_send(HCI_NETAPP_DHCP, ptr, NETAPP_DHCP_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_NETAPP_DHCP, &scRet);
+	if (SimpleLinkWaitEvent(HCI_NETAPP_DHCP, &scRet) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(scRet);
 }
@@ -190,6 +194,7 @@ long netapp_dhcp(unsigned long *aucIP, unsigned long *aucSubnetMask,unsigned lon
 long
 netapp_timeout_values(unsigned long *aucDHCP, unsigned long *aucARP,unsigned long *aucKeepalive,	unsigned long *aucInactivity)
 {
+	CC3000_DRIVER_LOCK();
 	signed char scRet;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -214,7 +219,10 @@ netapp_timeout_values(unsigned long *aucDHCP, unsigned long *aucARP,unsigned lon
 	hci_command_send(HCI_NETAPP_SET_TIMERS, ptr, NETAPP_SET_TIMER_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_NETAPP_SET_TIMERS, &scRet);
+	if (SimpleLinkWaitEvent(HCI_NETAPP_SET_TIMERS, &scRet) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(scRet);
 }
@@ -246,6 +254,7 @@ netapp_timeout_values(unsigned long *aucDHCP, unsigned long *aucARP,unsigned lon
 long
 netapp_ping_send(uint32_t *ip, uint32_t ulPingAttempts, uint32_t ulPingSize, uint32_t ulPingTimeout)
 {
+	CC3000_DRIVER_LOCK();
 	signed char scRet;
 	unsigned char *ptr, *args;
 
@@ -272,7 +281,10 @@ netapp_ping_send(uint32_t *ip, uint32_t ulPingAttempts, uint32_t ulPingSize, uin
 	hci_command_send(HCI_NETAPP_PING_SEND, ptr, NETAPP_PING_SEND_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_NETAPP_PING_SEND, &scRet);
+	if (SimpleLinkWaitEvent(HCI_NETAPP_PING_SEND, &scRet) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(scRet);
 }
@@ -305,6 +317,7 @@ netapp_ping_send(uint32_t *ip, uint32_t ulPingAttempts, uint32_t ulPingSize, uin
 #ifndef CC3000_TINY_DRIVER
 void netapp_ping_report()
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr;
 	ptr = tSLInformation.pucTxCommandBuffer;
 	signed char scRet;
@@ -335,6 +348,7 @@ void netapp_ping_report()
 #ifndef CC3000_TINY_DRIVER
 long netapp_ping_stop()
 {
+	CC3000_DRIVER_LOCK();
 	signed char scRet;
 	unsigned char *ptr;
 
@@ -345,7 +359,10 @@ long netapp_ping_stop()
 	hci_command_send(HCI_NETAPP_PING_STOP, ptr, 0);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_NETAPP_PING_STOP, &scRet);
+	if (SimpleLinkWaitEvent(HCI_NETAPP_PING_STOP, &scRet) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(scRet);
 }
@@ -379,6 +396,7 @@ long netapp_ping_stop()
 
 void netapp_ipconfig( tNetappIpconfigRetArgs * ipconfig )
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr;
 
 	ptr = tSLInformation.pucTxCommandBuffer;
@@ -386,8 +404,11 @@ void netapp_ipconfig( tNetappIpconfigRetArgs * ipconfig )
 	// Initiate a HCI command
 	hci_command_send(HCI_NETAPP_IPCONFIG, ptr, 0);
 
-	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_NETAPP_IPCONFIG, ipconfig );
+	// Wait for command complete event, report no configuration if it never comes
+	if (SimpleLinkWaitEvent(HCI_NETAPP_IPCONFIG, ipconfig ) != ESUCCESS)
+	{
+		memset(ipconfig, 0, sizeof(tNetappIpconfigRetArgs));
+	}
 
 }
 
@@ -406,6 +427,7 @@ void netapp_ipconfig( tNetappIpconfigRetArgs * ipconfig )
 #ifndef CC3000_TINY_DRIVER
 long netapp_arp_flush(void)
 {
+	CC3000_DRIVER_LOCK();
 	signed char scRet;
 	unsigned char *ptr;
 
@@ -416,7 +438,10 @@ long netapp_arp_flush(void)
 	hci_command_send(HCI_NETAPP_ARP_FLUSH, ptr, 0);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_NETAPP_ARP_FLUSH, &scRet);
+	if (SimpleLinkWaitEvent(HCI_NETAPP_ARP_FLUSH, &scRet) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(scRet);
 }
@@ -444,6 +469,7 @@ long netapp_arp_flush(void)
 #ifndef CC3000_TINY_DRIVER
 long netapp_set_debug_level(unsigned long ulLevel)
 {
+	CC3000_DRIVER_LOCK();
 	signed char scRet;
     unsigned char *ptr, *args;
 
@@ -465,7 +491,10 @@ long netapp_set_debug_level(unsigned long ulLevel)
     //
 	// Wait for command complete event
 	//
-	SimpleLinkWaitEvent(HCI_NETAPP_SET_DEBUG_LEVEL, &scRet);
+	if (SimpleLinkWaitEvent(HCI_NETAPP_SET_DEBUG_LEVEL, &scRet) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
     return(scRet);
 
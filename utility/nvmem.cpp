@@ -99,6 +99,7 @@
 signed long
 nvmem_read(unsigned long ulFileId, unsigned long ulLength, unsigned long ulOffset, unsigned char *buff)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char ucStatus = 0xFF;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -113,7 +114,10 @@ nvmem_read(unsigned long ulFileId, unsigned long ulLength, unsigned long ulOffse
 
 	// Initiate a HCI command
 	hci_command_send(HCI_CMND_NVMEM_READ, ptr, NVMEM_READ_PARAMS_LEN);
-	SimpleLinkWaitEvent(HCI_CMND_NVMEM_READ, &ucStatus);
+	if (SimpleLinkWaitEvent(HCI_CMND_NVMEM_READ, &ucStatus) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	// In case there is data - read it - even if an error code is returned
    // Note: It is the user responsibility to ignore the data in case of an error code
@@ -121,7 +125,10 @@ nvmem_read(unsigned long ulFileId, unsigned long ulLength, unsigned long ulOffse
 	// Wait for the data in a synchronous way. Here we assume that the buffer is
 	// big enough to store also parameters of nvmem
 
-	SimpleLinkWaitData(buff, 0, 0);
+	if (SimpleLinkWaitData(buff, 0, 0) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ucStatus);
 }
@@ -152,6 +159,7 @@ signed long
 nvmem_write(unsigned long ulFileId, unsigned long ulLength, unsigned long
 						ulEntryOffset, unsigned char *buff)
 {
+	CC3000_DRIVER_LOCK();
 	long iRes;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -182,7 +190,10 @@ nvmem_write(unsigned long ulFileId, unsigned long ulLength, unsigned long
 	hci_data_command_send(HCI_CMND_NVMEM_WRITE, ptr, NVMEM_WRITE_PARAMS_LEN,
 												ulLength);
 
-	SimpleLinkWaitEvent(HCI_EVNT_NVMEM_WRITE, &iRes);
+	if (SimpleLinkWaitEvent(HCI_EVNT_NVMEM_WRITE, &iRes) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(iRes);
 }
@@ -249,6 +260,7 @@ unsigned char nvmem_get_mac_address(unsigned char *mac)
 #ifndef CC3000_TINY_DRIVER
 unsigned char nvmem_write_patch(unsigned long ulFileId, unsigned long spLength, const uint8_t *spData)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char 	status = 0;
 	unsigned short	offset = 0;
 	unsigned char*      spDataPtr = (unsigned char*)spData;
@@ -298,7 +310,8 @@ unsigned char nvmem_write_patch(unsigned long ulFileId, unsigned long spLength,
 //!  @param[out]  patchVer    first number indicates package ID and the second
 //!                           number indicates package build number
 //!
-//!  @return       on success  0, error otherwise.
+//!  @return       on success  0, ERROR_WAIT_TIMEOUT if the reply didn't
+//!                arrive before the wait deadline, error otherwise.
 //!
 //!  @brief      Read patch version. read package version (WiFi FW patch,
 //!              driver-supplicant-NS patch, bootloader patch)
@@ -306,8 +319,9 @@ unsigned char nvmem_write_patch(unsigned long ulFileId, unsigned long spLength,
 //*****************************************************************************
 
 #ifndef CC3000_TINY_DRIVER
-uint8_t nvmem_read_sp_version(uint8_t* patchVer)
+long nvmem_read_sp_version(uint8_t* patchVer)
 {
+	CC3000_DRIVER_LOCK();
 	uint8_t *ptr;
 	// 1st byte is the status and the rest is the SP version
 	uint8_t	retBuf[5];
@@ -316,7 +330,10 @@ uint8_t nvmem_read_sp_version(uint8_t* patchVer)
 
    // Initiate a HCI command, no args are required
 	hci_command_send(HCI_CMND_READ_SP_VERSION, ptr, 0);
-	SimpleLinkWaitEvent(HCI_CMND_READ_SP_VERSION, retBuf);
+	if (SimpleLinkWaitEvent(HCI_CMND_READ_SP_VERSION, retBuf) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	// package ID
 	*patchVer = retBuf[3];
@@ -353,6 +370,7 @@ uint8_t nvmem_read_sp_version(uint8_t* patchVer)
 int8_t
 nvmem_create_entry(unsigned long ulFileId, unsigned long ulNewLen)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr;
 	unsigned char *args;
 	int8_t retval;
@@ -367,7 +385,10 @@ nvmem_create_entry(unsigned long ulFileId, unsigned long ulNewLen)
 	// Initiate a HCI command
 	hci_command_send(HCI_CMND_NVMEM_CREATE_ENTRY,ptr, NVMEM_CREATE_PARAMS_LEN);
 
-	SimpleLinkWaitEvent(HCI_CMND_NVMEM_CREATE_ENTRY, &retval);
+	if (SimpleLinkWaitEvent(HCI_CMND_NVMEM_CREATE_ENTRY, &retval) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	return(retval);
 }
 
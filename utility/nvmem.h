@@ -205,14 +205,15 @@ extern	unsigned char nvmem_write_patch(unsigned long ulFileId, unsigned long spL
 //!  @param[out]  patchVer    first number indicates package ID and the second 
 //!                           number indicates package build number   
 //!
-//!  @return       on success 0, error otherwise.
+//!  @return       on success 0, ERROR_WAIT_TIMEOUT if the reply didn't
+//!                arrive before the wait deadline, error otherwise.
 //!
 //!  @brief      Read patch version. read package version (WiFi FW patch, 
 //!              driver-supplicant-NS patch, bootloader patch)
 //!	 
 //*****************************************************************************
 #ifndef CC3000_TINY_DRIVER 
-extern	unsigned char nvmem_read_sp_version(unsigned char* patchVer);
+extern	long nvmem_read_sp_version(unsigned char* patchVer);
 #endif
 
 //*****************************************************************************
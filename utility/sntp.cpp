@@ -369,7 +369,7 @@ char sntp::GetNTPServerList(const char** ntp_pool_list, uint32_t* addrBuffer, in
 				if (CC3KPrinter != 0) { CC3KPrinter->print(F("Checking NTP server/pool address ")); CC3KPrinter->println(*ntpPoolName); }
 			#endif
 
-			gethostbyname(*ntpPoolName, strlen(*ntpPoolName), &ntpServer);
+			dns_cache_gethostbyname(*ntpPoolName, strlen(*ntpPoolName), &ntpServer);
 
 			#ifdef CLOCK_DEBUG
 				if (CC3KPrinter != 0) { CC3KPrinter->print(F("     returns ntpServer: ")); CC3KPrinter->println(ntpServer,HEX); }
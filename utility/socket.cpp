@@ -112,6 +112,8 @@
 //!          -1 in case of bad socket
 //!          -2 if there are no free buffers present (only when 
 //!          SEND_NON_BLOCKING is enabled)
+//!          ERROR_WAIT_TIMEOUT if no buffer was freed before the wait
+//!          deadline
 //!
 //!  @brief  if SEND_NON_BLOCKING not define - block until have free buffer 
 //!          becomes available, else return immediately  with correct status 
@@ -122,6 +124,8 @@ int
 HostFlowControlConsumeBuff(int sd)
 {
 #ifndef SEND_NON_BLOCKING
+	unsigned long ulStart = cc3000_wait_start();
+
 	/* wait in busy loop */
 	do
 	{
@@ -137,6 +141,16 @@ HostFlowControlConsumeBuff(int sd)
 		
 		if(SOCKET_STATUS_ACTIVE != get_socket_active_status(sd))
 			return -1;
+
+		if (0 == tSLInformation.usNumberOfFreeBuffers)
+		{
+			if (cc3000_wait_expired(ulStart))
+				return ERROR_WAIT_TIMEOUT;
+
+			// Free buffer events only arrive through the SPI layer
+			cc3k_int_poll();
+			cc3000_idle();
+		}
 	} while(0 == tSLInformation.usNumberOfFreeBuffers);
 	
 	tSLInformation.usNumberOfFreeBuffers--;
@@ -196,6 +210,7 @@ HostFlowControlConsumeBuff(int sd)
 int
 socket(long domain, long type, long protocol)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr, *args;
 	
@@ -212,7 +227,10 @@ socket(long domain, long type, long protocol)
 	hci_command_send(HCI_CMND_SOCKET, ptr, SOCKET_OPEN_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_SOCKET, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_SOCKET, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	// Process the event 
 	errno = ret;
@@ -237,6 +255,7 @@ socket(long domain, long type, long protocol)
 long
 closesocket(long sd)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr, *args;
 	
@@ -251,12 +270,16 @@ closesocket(long sd)
 	hci_command_send(HCI_CMND_CLOSE_SOCKET, ptr, SOCKET_CLOSE_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_CLOSE_SOCKET, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_CLOSE_SOCKET, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	errno = ret;
 	
 	// since 'close' call may result in either OK (and then it closed) or error 
 	// mark this socket as invalid 
 	set_socket_active_status(sd, SOCKET_STATUS_INACTIVE);
+	cc3000_ctx->listenSockets &= ~(1UL << sd);
 	
 	return(ret);
 }
@@ -309,6 +332,7 @@ closesocket(long sd)
 long
 accept(long sd, sockaddr *addr, socklen_t *addrlen)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr, *args;
 	tBsdReturnParams tAcceptReturnArguments;
@@ -325,7 +349,10 @@ accept(long sd, sockaddr *addr, socklen_t *addrlen)
 									 ptr, SOCKET_ACCEPT_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_ACCEPT, &tAcceptReturnArguments);
+	if (SimpleLinkWaitEvent(HCI_CMND_ACCEPT, &tAcceptReturnArguments) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	
 	// need specify return parameters!!!
@@ -373,6 +400,7 @@ accept(long sd, sockaddr *addr, socklen_t *addrlen)
 long
 bind(long sd, const sockaddr *addr, long addrlen)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr, *args;
 	
@@ -393,7 +421,10 @@ bind(long sd, const sockaddr *addr, long addrlen)
 									 ptr, SOCKET_BIND_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_BIND, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_BIND, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	errno = ret;
   
@@ -426,6 +457,7 @@ bind(long sd, const sockaddr *addr, long addrlen)
 long
 listen(long sd, long backlog)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr, *args;
 	
@@ -442,9 +474,17 @@ listen(long sd, long backlog)
 									 ptr, SOCKET_LISTEN_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_LISTEN, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_LISTEN, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	errno = ret;
 	
+	if (ret == 0)
+	{
+		cc3000_ctx->listenSockets |= (1UL << sd);
+	}
+	
 	return(ret);
 }
 
@@ -471,6 +511,7 @@ listen(long sd, long backlog)
 int 
 gethostbyname(const char * hostname, uint8_t usNameLen, uint32_t * out_ip_addr)
 {
+	CC3000_DRIVER_LOCK();
 	tBsdGethostbynameParams ret;
 	unsigned char *ptr, *args;
 	
@@ -494,7 +535,10 @@ gethostbyname(const char * hostname, uint8_t usNameLen, uint32_t * out_ip_addr)
 									 + usNameLen - 1);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_EVNT_BSD_GETHOSTBYNAME, &ret);
+	if (SimpleLinkWaitEvent(HCI_EVNT_BSD_GETHOSTBYNAME, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	errno = ret.retVal;
 	//Dprinter->print("errno: "); Dprinter->println(errno);
@@ -537,6 +581,7 @@ gethostbyname(const char * hostname, uint8_t usNameLen, uint32_t * out_ip_addr)
 long
 connect(long sd, const sockaddr *addr, long addrlen)
 {
+	CC3000_DRIVER_LOCK();
 	long int ret;
 	unsigned char *ptr, *args;
 	
@@ -556,7 +601,10 @@ connect(long sd, const sockaddr *addr, long addrlen)
 									 ptr, SOCKET_CONNECT_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_CONNECT, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_CONNECT, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	errno = ret;
 	
@@ -606,6 +654,7 @@ int
 select(long nfds, fd_set *readsds, fd_set *writesds, fd_set *exceptsds, 
        struct timeval *timeout)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr, *args;
 	tBsdSelectRecvParams tParams;
 	unsigned long is_blocking;
@@ -649,7 +698,10 @@ select(long nfds, fd_set *readsds, fd_set *writesds, fd_set *exceptsds,
 	hci_command_send(HCI_CMND_BSD_SELECT, ptr, SOCKET_SELECT_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_EVNT_SELECT, &tParams);
+	if (SimpleLinkWaitEvent(HCI_EVNT_SELECT, &tParams) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	// Update actually read FD
 	if (tParams.iStatus >= 0)
@@ -731,6 +783,7 @@ int
 setsockopt(long sd, long level, long optname, const void *optval,
 					 socklen_t optlen)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr, *args;
 	
@@ -750,7 +803,10 @@ setsockopt(long sd, long level, long optname, const void *optval,
 									 ptr, SOCKET_SET_SOCK_OPT_PARAMS_LEN  + optlen);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_SETSOCKOPT, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_SETSOCKOPT, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	if (ret >= 0)
 	{
@@ -814,6 +870,7 @@ setsockopt(long sd, long level, long optname, const void *optval,
 int
 getsockopt (long sd, long level, long optname, void *optval, socklen_t *optlen)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr, *args;
 	tBsdGetSockOptReturnParams  tRetParams;
 	
@@ -830,7 +887,10 @@ getsockopt (long sd, long level, long optname, void *optval, socklen_t *optlen)
 									 ptr, SOCKET_GET_SOCK_OPT_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_CMND_GETSOCKOPT, &tRetParams);
+	if (SimpleLinkWaitEvent(HCI_CMND_GETSOCKOPT, &tRetParams) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	if (((signed char)tRetParams.iStatus) >= 0)
 	{
@@ -870,6 +930,7 @@ int
 simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
                 socklen_t *fromlen, long opcode)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr, *args;
 	tBsdReadReturnParams tSocketReadEvent;
 	
@@ -885,7 +946,10 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
 	hci_command_send(opcode,  ptr, SOCKET_RECV_FROM_PARAMS_LEN);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(opcode, &tSocketReadEvent);
+	if (SimpleLinkWaitEvent(opcode, &tSocketReadEvent) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	DEBUGPRINT_F("\n\r\tRecv'd data... Socket #");
 	DEBUGPRINT_DEC(tSocketReadEvent.iSocketDescriptor);
@@ -900,7 +964,10 @@ simple_link_recv(long sd, void *buf, long len, long flags, sockaddr *from,
 	{
 		// Wait for the data in a synchronous way. Here we assume that the bug is 
 		// big enough to store also parameters of receive from too....
-	  SimpleLinkWaitData((unsigned char *)buf, (unsigned char *)from, (unsigned char *)fromlen);
+	  if (SimpleLinkWaitData((unsigned char *)buf, (unsigned char *)from, (unsigned char *)fromlen) != ESUCCESS)
+	  {
+	    return(ERROR_WAIT_TIMEOUT);
+	  }
 	}
 	
 	errno = tSocketReadEvent.iNumberOfBytes;
@@ -1002,6 +1069,7 @@ int
 simple_link_send(long sd, const void *buf, long len, long flags,
               const sockaddr *to, long tolen, long opcode)
 {    
+	CC3000_DRIVER_LOCK();
 	unsigned char uArgSize,  addrlen;
 	unsigned char *ptr, *pDataPtr, *args;
 	unsigned long addr_offset;
@@ -1072,10 +1140,11 @@ simple_link_send(long sd, const void *buf, long len, long flags,
 	// Initiate a HCI command
 	hci_data_send(opcode, ptr, uArgSize, len,(unsigned char*)to, tolen);
         
-         if (opcode == HCI_CMND_SENDTO)
-            SimpleLinkWaitEvent(HCI_EVNT_SENDTO, &tSocketSendEvent);
-         else
-            SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent);
+	if (SimpleLinkWaitEvent((opcode == HCI_CMND_SENDTO) ? HCI_EVNT_SENDTO : HCI_EVNT_SEND,
+	                        &tSocketSendEvent) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	return	(len);
 }
@@ -1109,6 +1178,75 @@ send(long sd, const void *buf, long len, long flags)
 	return(simple_link_send(sd, buf, len, flags, NULL, 0, HCI_CMND_SEND));
 }
 
+#ifndef CC3000_TINY_DRIVER
+//*****************************************************************************
+//
+//!  send_fill
+//!
+//!  @param sd       socket handle
+//!  @param len      most bytes to send, cut to what fits the TX buffer
+//!  @param flags    On this version, this parameter is not supported
+//!  @param fill     writes the data into the TX buffer, returns its length
+//!  @param arg      passed on to fill
+//!
+//!  @return         Return the number of bytes transmitted, 0 if fill had
+//!                  nothing, or -1 if an error occurred
+//!
+//!  @brief          Like send(), but the data is written straight into the
+//!                  TX buffer by fill instead of being copied from the
+//!                  caller's buffer. fill is only called once the socket
+//!                  has a free buffer on the module, so a dead socket fails
+//!                  before any data is taken from the caller. fill must
+//!                  not call the driver.
+//
+//*****************************************************************************
+
+int
+send_fill(long sd, long len, long flags, tSendFill fill, void *arg)
+{
+	CC3000_DRIVER_LOCK();
+	unsigned char *ptr, *args;
+	int res;
+	tBsdReadReturnParams tSocketSendEvent;
+
+	if (len > CC3000_TX_BUFFER_SIZE - HEADERS_SIZE_DATA - HCI_CMND_SEND_ARG_LENGTH - 1)
+	{
+		len = CC3000_TX_BUFFER_SIZE - HEADERS_SIZE_DATA - HCI_CMND_SEND_ARG_LENGTH - 1;
+	}
+
+	if (0 != (res = HostFlowControlConsumeBuff(sd)))
+	{
+		return res;
+	}
+
+	ptr = tSLInformation.pucTxCommandBuffer;
+	len = fill(ptr + HEADERS_SIZE_DATA + HCI_CMND_SEND_ARG_LENGTH, len, arg);
+	if (len <= 0)
+	{
+		// Nothing to send, the buffer is still free
+		tSLInformation.usNumberOfFreeBuffers++;
+		return 0;
+	}
+
+	tSLInformation.NumberOfSentPackets++;
+
+	args = (ptr + HEADERS_SIZE_DATA);
+	args = UINT32_TO_STREAM(args, sd);
+	args = UINT32_TO_STREAM(args, HCI_CMND_SEND_ARG_LENGTH - sizeof(sd));
+	args = UINT32_TO_STREAM(args, len);
+	args = UINT32_TO_STREAM(args, flags);
+
+	hci_data_send(HCI_CMND_SEND, ptr, HCI_CMND_SEND_ARG_LENGTH, len, NULL, 0);
+
+	if (SimpleLinkWaitEvent(HCI_EVNT_SEND, &tSocketSendEvent) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
+
+	return	(len);
+}
+#endif
+
 //*****************************************************************************
 //
 //!  sendto
@@ -1163,6 +1301,7 @@ sendto(long sd, const void *buf, long len, long flags, const sockaddr *to,
 int
 mdnsAdvertiser(unsigned short mdnsEnabled, char * deviceServiceName, unsigned short deviceServiceNameLength)
 {
+	CC3000_DRIVER_LOCK();
 	char ret;
  	unsigned char *pTxBuffer, *pArgs;
 	
@@ -1184,7 +1323,10 @@ mdnsAdvertiser(unsigned short mdnsEnabled, char * deviceServiceName, unsigned sh
 	hci_command_send(HCI_CMND_MDNS_ADVERTISE, pTxBuffer, SOCKET_MDNS_ADVERTISE_PARAMS_LEN + deviceServiceNameLength);
 	
 	// Since we are in blocking state - wait for event complete
-	SimpleLinkWaitEvent(HCI_EVNT_MDNS_ADVERTISE, &ret);
+	if (SimpleLinkWaitEvent(HCI_EVNT_MDNS_ADVERTISE, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	
 	return ret;
 	
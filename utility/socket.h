@@ -625,6 +625,31 @@ extern int recvfrom(long sd, void *buf, long len, long flags, sockaddr *from,
 
 extern int send(long sd, const void *buf, long len, long flags);
 
+//*****************************************************************************
+//
+//!  send_fill
+//!
+//!  @param sd       socket handle
+//!  @param len      most bytes to send, cut to what fits the TX buffer
+//!  @param flags    On this version, this parameter is not supported
+//!  @param fill     writes the data into the TX buffer, returns its length
+//!  @param arg      passed on to fill
+//!
+//!  @return         Return the number of bytes transmitted, 0 if fill had
+//!                  nothing, or -1 if an error occurred
+//!
+//!  @brief          Like send(), but fill writes the data straight into
+//!                  the TX buffer, saving the copy from a caller's buffer.
+//!                  fill must not call the driver.
+//!
+//!  @sa             send
+//
+//*****************************************************************************
+
+#ifndef CC3000_TINY_DRIVER
+extern int send_fill(long sd, long len, long flags, tSendFill fill, void *arg);
+#endif
+
 //*****************************************************************************
 //
 //!  sendto
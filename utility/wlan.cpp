@@ -57,7 +57,7 @@
 #include "evnt_handler.h"
 #include "debug.h"
 
-volatile sSimplLinkInformation tSLInformation;
+// tSLInformation is part of the driver context, see cc3000_context.h
 
 #define SMART_CONFIG_PROFILE_SIZE		67		// 67 = 32 (max ssid) + 32 (max key) + 1 (SSID length) + 1 (security type) + 1 (key length)
 
@@ -114,12 +114,12 @@ unsigned char profileArray[SMART_CONFIG_PROFILE_SIZE];
 //!                                    patches will be available from the EEPROM
 //!                                    and not from the host.
 //!
-//!  @return   none
+//!  @return   ESUCCESS, or ERROR_WAIT_TIMEOUT if the CC3000 didn't answer
 //!
 //!  @brief    Send HCI_CMND_SIMPLE_LINK_START to CC3000
 //
 //*****************************************************************************
-static void SimpleLink_Init_Start(unsigned short usPatchesAvailableAtHost)
+static long SimpleLink_Init_Start(unsigned short usPatchesAvailableAtHost)
 {
 	unsigned char *ptr;
 	unsigned char *args;
@@ -133,7 +133,7 @@ static void SimpleLink_Init_Start(unsigned short usPatchesAvailableAtHost)
 
 	// IRQ Line asserted - send HCI_CMND_SIMPLE_LINK_START to CC3000
 	hci_command_send(HCI_CMND_SIMPLE_LINK_START, ptr, WLAN_SL_INIT_START_PARAMS_LEN);
-	SimpleLinkWaitEvent(HCI_CMND_SIMPLE_LINK_START, 0);
+	return SimpleLinkWaitEvent(HCI_CMND_SIMPLE_LINK_START, 0);
 }
 
 
@@ -249,7 +249,8 @@ void SpiReceiveHandler(void *pvBuffer)
 //!                                    patches will be available from the EEPROM
 //!                                    and not from the host.
 //!
-//!  @return        none
+//!  @return        ESUCCESS, or ERROR_WAIT_TIMEOUT if the device didn't
+//!                 come up before the wait deadline
 //!
 //!  @brief        Start WLAN device. This function asserts the enable pin of
 //!                the device (WLAN_EN), starting the HW initialization process.
@@ -265,11 +266,13 @@ void SpiReceiveHandler(void *pvBuffer)
 //
 //*****************************************************************************
 
-void
+long
 wlan_start(unsigned short usPatchesAvailableAtHost)
 {
+	CC3000_DRIVER_LOCK();
 
 	unsigned long ulSpiIRQState;
+	unsigned long ulStart;
 
 	tSLInformation.NumberOfSentPackets = 0;
 	tSLInformation.NumberOfReleasedPackets = 0;
@@ -293,12 +296,16 @@ wlan_start(unsigned short usPatchesAvailableAtHost)
 
 	// ASIC 1273 chip enable: toggle WLAN EN line
 	tSLInformation.WriteWlanPin( WLAN_ENABLE );
+	ulStart = cc3000_wait_start();
 
 	if (ulSpiIRQState)
 	{
 		// wait till the IRQ line goes low
 		while(tSLInformation.ReadWlanInterruptPin() != 0)
 		{
+			if (cc3000_wait_expired(ulStart))
+				return(ERROR_WAIT_TIMEOUT);
+			cc3000_idle();
 		}
 	}
 	else
@@ -306,19 +313,28 @@ wlan_start(unsigned short usPatchesAvailableAtHost)
 		// wait till the IRQ line goes high and than low
 		while(tSLInformation.ReadWlanInterruptPin() == 0)
 		{
+			if (cc3000_wait_expired(ulStart))
+				return(ERROR_WAIT_TIMEOUT);
+			cc3000_idle();
 		}
 
 		while(tSLInformation.ReadWlanInterruptPin() != 0)
 		{
+			if (cc3000_wait_expired(ulStart))
+				return(ERROR_WAIT_TIMEOUT);
+			cc3000_idle();
 		}
 	}
 	DEBUGPRINT_F("SimpleLink start\n\r");
-	SimpleLink_Init_Start(usPatchesAvailableAtHost);
+	if (SimpleLink_Init_Start(usPatchesAvailableAtHost) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	// Read Buffer's size and finish
 	DEBUGPRINT_F("Read buffer\n\r");
 	hci_command_send(HCI_CMND_READ_BUFFER_SIZE, tSLInformation.pucTxCommandBuffer, 0);
-	SimpleLinkWaitEvent(HCI_CMND_READ_BUFFER_SIZE, 0);
+	return SimpleLinkWaitEvent(HCI_CMND_READ_BUFFER_SIZE, 0);
 }
 
 
@@ -339,12 +355,20 @@ wlan_start(unsigned short usPatchesAvailableAtHost)
 void
 wlan_stop(void)
 {
+	CC3000_DRIVER_LOCK();
+	unsigned long ulStart;
+
 	// ASIC 1273 chip disable
 	tSLInformation.WriteWlanPin( WLAN_DISABLE );
+	ulStart = cc3000_wait_start();
 
-	// Wait till IRQ line goes high...
+	// Wait till IRQ line goes high... (the module is off either way, so a
+	// missed edge only ends the wait early)
 	while(tSLInformation.ReadWlanInterruptPin() == 0)
 	{
+		if (cc3000_wait_expired(ulStart))
+			break;
+		cc3000_idle();
 	}
 
 	// Free the used by WLAN Driver memory
@@ -393,6 +417,7 @@ long
 wlan_connect(unsigned long ulSecType, const char *ssid, long ssid_len,
              unsigned char *bssid, unsigned char *key, long key_len)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -432,7 +457,10 @@ wlan_connect(unsigned long ulSecType, const char *ssid, long ssid_len,
 									 ssid_len + key_len - 1);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_CONNECT, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_CONNECT, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	errno = ret;
 
 	return(ret);
@@ -441,6 +469,7 @@ wlan_connect(unsigned long ulSecType, const char *ssid, long ssid_len,
 long
 wlan_connect(const char *ssid, long ssid_len)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -467,7 +496,10 @@ wlan_connect(const char *ssid, long ssid_len)
 									 ssid_len  - 1);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_CONNECT, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_CONNECT, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	errno = ret;
 
 	return(ret);
@@ -489,6 +521,7 @@ wlan_connect(const char *ssid, long ssid_len)
 long
 wlan_disconnect()
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 
@@ -498,7 +531,10 @@ wlan_disconnect()
 	hci_command_send(HCI_CMND_WLAN_DISCONNECT, ptr, 0);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_DISCONNECT, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_DISCONNECT, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 	errno = ret;
 
 	return(ret);
@@ -541,6 +577,7 @@ wlan_ioctl_set_connection_policy(unsigned long should_connect_to_open_ap,
                                  unsigned long ulShouldUseFastConnect,
                                  unsigned long ulUseProfiles)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -559,7 +596,10 @@ wlan_ioctl_set_connection_policy(unsigned long should_connect_to_open_ap,
 									 ptr, WLAN_SET_CONNECTION_POLICY_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SET_CONNECTION_POLICY, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SET_CONNECTION_POLICY, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -605,6 +645,7 @@ wlan_add_profile(unsigned long ulSecType,
 								 unsigned char* ucPf_OrKey,
 								 unsigned long ulPassPhraseLen)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned short arg_len;
 	long ret;
 	unsigned char *ptr;
@@ -710,7 +751,10 @@ wlan_add_profile(unsigned long ulSecType,
 									 ptr, arg_len);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_ADD_PROFILE, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_ADD_PROFILE, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -750,6 +794,7 @@ wlan_add_profile(unsigned long ulSecType,
 long
 wlan_ioctl_del_profile(unsigned long ulIndex)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -766,7 +811,10 @@ wlan_ioctl_del_profile(unsigned long ulIndex)
 									 ptr, WLAN_DEL_PROFILE_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_DEL_PROFILE, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_DEL_PROFILE, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -810,6 +858,7 @@ long
 wlan_ioctl_get_scan_results(unsigned long ulScanTimeout,
                             unsigned char *ucResults)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned char *ptr;
 	unsigned char *args;
 
@@ -824,7 +873,10 @@ wlan_ioctl_get_scan_results(unsigned long ulScanTimeout,
 									 ptr, WLAN_GET_SCAN_RESULTS_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_GET_SCAN_RESULTS, ucResults);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_GET_SCAN_RESULTS, ucResults) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(0);
 }
@@ -877,6 +929,7 @@ wlan_ioctl_set_scan_params(unsigned long uiEnable, unsigned long uiMinDwellTime,
 													 unsigned long uiDefaultTxPower,
 													 unsigned long *aiIntervalList)
 {
+	CC3000_DRIVER_LOCK();
 	unsigned long  uiRes;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -902,7 +955,10 @@ wlan_ioctl_set_scan_params(unsigned long uiEnable, unsigned long uiMinDwellTime,
 									 ptr, WLAN_SET_SCAN_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SET_SCANPARAM, &uiRes);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SET_SCANPARAM, &uiRes) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(uiRes);
 }
@@ -933,6 +989,7 @@ wlan_ioctl_set_scan_params(unsigned long uiEnable, unsigned long uiMinDwellTime,
 long
 wlan_set_event_mask(unsigned long ulMask)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -969,7 +1026,10 @@ wlan_set_event_mask(unsigned long ulMask)
 									 ptr, WLAN_SET_MASK_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_EVENT_MASK, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_EVENT_MASK, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -991,6 +1051,7 @@ wlan_set_event_mask(unsigned long ulMask)
 long
 wlan_ioctl_statusget(void)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 
@@ -1001,7 +1062,10 @@ wlan_ioctl_statusget(void)
 									 ptr, 0);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_STATUSGET, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_STATUSGET, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -1032,6 +1096,7 @@ wlan_ioctl_statusget(void)
 long
 wlan_smart_config_start(unsigned long algoEncryptedFlag)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -1048,7 +1113,10 @@ wlan_smart_config_start(unsigned long algoEncryptedFlag)
 									 WLAN_SMART_CONFIG_START_PARAMS_LEN);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_START, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_START, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -1072,6 +1140,7 @@ wlan_smart_config_start(unsigned long algoEncryptedFlag)
 long
 wlan_smart_config_stop(void)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 
@@ -1081,7 +1150,10 @@ wlan_smart_config_stop(void)
 	hci_command_send(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_STOP, ptr, 0);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_STOP, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_STOP, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -1108,6 +1180,7 @@ wlan_smart_config_stop(void)
 long
 wlan_smart_config_set_prefix(char* cNewPrefix)
 {
+	CC3000_DRIVER_LOCK();
 	long ret;
 	unsigned char *ptr;
 	unsigned char *args;
@@ -1131,7 +1204,10 @@ wlan_smart_config_set_prefix(char* cNewPrefix)
 									 SL_SIMPLE_CONFIG_PREFIX_LENGTH);
 
 	// Wait for command complete event
-	SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_SET_PREFIX, &ret);
+	if (SimpleLinkWaitEvent(HCI_CMND_WLAN_IOCTL_SIMPLE_CONFIG_SET_PREFIX, &ret) != ESUCCESS)
+	{
+		return(ERROR_WAIT_TIMEOUT);
+	}
 
 	return(ret);
 }
@@ -1158,6 +1234,7 @@ wlan_smart_config_set_prefix(char* cNewPrefix)
 long
 wlan_smart_config_process()
 {
+	CC3000_DRIVER_LOCK();
 	signed long	returnValue;
 	unsigned long ssidLen, keyLen;
 	unsigned char *decKeyPtr;
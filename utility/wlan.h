@@ -144,7 +144,8 @@ extern void wlan_init(		tWlanCB	 	sWlanCB,
 //!                                    patches will be available from the EEPROM
 //!                                    and not from the host.
 //!
-//!  @return        none
+//!  @return        ESUCCESS, or ERROR_WAIT_TIMEOUT if the device didn't
+//!                 come up before the wait deadline
 //!
 //!  @brief        Start WLAN device. This function asserts the enable pin of 
 //!                the device (WLAN_EN), starting the HW initialization process.
@@ -159,7 +160,7 @@ extern void wlan_init(		tWlanCB	 	sWlanCB,
 //!
 //
 //*****************************************************************************
-extern void wlan_start(unsigned short usPatchesAvailableAtHost);
+extern long wlan_start(unsigned short usPatchesAvailableAtHost);
 
 //*****************************************************************************
 //